@@ -40,6 +40,46 @@ if os.environ.get('PYCRYPTOPP_DISABLE_EMBEDDED_CRYPTOPP') == "1":
 
 EMBEDDED_CRYPTOPP_DIR='src-cryptopp'
 
+# By default the embedded Crypto++ is built with CRYPTOPP_DISABLE_ASM, which
+# leaves only the portable C++ code plus the AES-NI/CLMUL intrinsics. With
+# this option its SSE2 and x86-64 inline assembly kernels (Rijndael, GCM,
+# SHA, Salsa20, Integer) are compiled in as well. Crypto++ chooses among them
+# at runtime with the CPU checks in cpu.cpp, so the resulting binary still
+# runs on CPUs without those instructions. Use _pycryptopp.cpu_features() to
+# see which kernels are active.
+ENABLE_EMBEDDED_CRYPTOPP_ASM=False
+if "--enable-embedded-cryptopp-asm" in sys.argv:
+    ENABLE_EMBEDDED_CRYPTOPP_ASM=True
+    sys.argv.remove("--enable-embedded-cryptopp-asm")
+
+if os.environ.get('PYCRYPTOPP_ENABLE_EMBEDDED_CRYPTOPP_ASM') == "1":
+    ENABLE_EMBEDDED_CRYPTOPP_ASM=True
+
+# Ed25519 field arithmetic: by default, on 64-bit platforms other than
+# Windows, elements of GF(2^255-19) are held in five 51-bit limbs and
+# multiplied with the compiler's unsigned __int128. Otherwise, or with this
+# option, the SUPERCOP "ref" code's 32 one-byte limbs are used.
+ED25519_RADIX51=sys.maxsize > 2**32 and platform.system() != "Windows"
+if "--disable-ed25519-radix51" in sys.argv:
+    ED25519_RADIX51=False
+    sys.argv.remove("--disable-ed25519-radix51")
+
+if os.environ.get('PYCRYPTOPP_DISABLE_ED25519_RADIX51') == "1":
+    ED25519_RADIX51=False
+
+# hash.sha512 has two implementations of SHA-512: Crypto++'s and the SUPERCOP
+# "ref" code's that Ed25519 signs with. By default SHA512 objects use
+# whichever of them hashes faster in a short timing run the first time one is
+# needed; --sha512-kernel=cryptopp or --sha512-kernel=supercop settles it at
+# build time instead.
+SHA512_KERNEL=os.environ.get('PYCRYPTOPP_SHA512_KERNEL')
+for arg in sys.argv[:]:
+    if arg.startswith("--sha512-kernel="):
+        SHA512_KERNEL=arg[len("--sha512-kernel="):]
+        sys.argv.remove(arg)
+if SHA512_KERNEL not in (None, "", "cryptopp", "supercop"):
+    raise SystemExit("--sha512-kernel must be cryptopp or supercop, not %r" % (SHA512_KERNEL,))
+
 BUILD_DOUBLE_LOAD_TESTER=False
 BDLTARG="--build-double-load-tester"
 if BDLTARG in sys.argv:
@@ -60,6 +100,9 @@ include_dirs=[]
 library_dirs=[]
 extra_srcs=[] # This is for Crypto++ .cpp files if they are needed.
 
+if SHA512_KERNEL:
+    define_macros.append(('PYCRYPTOPP_SHA512_%s' % SHA512_KERNEL.upper(), 1))
+
 #
 # Fix the build on OpenBSD
 # https://tahoe-lafs/trac/pycryptopp/ticket/32
@@ -106,7 +149,8 @@ if DISABLE_EMBEDDED_CRYPTOPP:
 else:
     # Build the bundled Crypto++ library which is included by source
     # code in the pycryptopp tree and link against it.
-    define_macros.append(('CRYPTOPP_DISABLE_ASM', 1))
+    if not ENABLE_EMBEDDED_CRYPTOPP_ASM:
+        define_macros.append(('CRYPTOPP_DISABLE_ASM', 1))
 
     include_dirs.append(".")
 
@@ -142,14 +186,25 @@ trove_classifiers=[
     ]
 
 srcs = ['src/pycryptopp/_pycryptoppmodule.cpp',
+        'src/pycryptopp/cpufeatures.cpp',
+        'src/pycryptopp/buffers.cpp',
+        'src/pycryptopp/workerpool.cpp',
+        'src/pycryptopp/threadrng.cpp',
+        'src/pycryptopp/idamodule.cpp',
         'src/pycryptopp/publickey/rsamodule.cpp',
         'src/pycryptopp/hash/sha256module.cpp',
+        'src/pycryptopp/hash/sha256mb.cpp',
+        'src/pycryptopp/hash/sha512module.cpp',
+        'src-ed25519/supercop-ref/sha512-blocks.c',
+        'src/pycryptopp/hash/merklemodule.cpp',
+        'src/pycryptopp/hash/kdfmodule.cpp',
         'src/pycryptopp/cipher/aesmodule.cpp',
         'src/pycryptopp/cipher/xsalsa20module.cpp',
 	'src/pycryptopp/cipher/aesgcmmodule.cpp',
         ]
 if ECDSA:
     srcs.append('src/pycryptopp/publickey/ecdsamodule.cpp')
+    srcs.append('src/pycryptopp/publickey/p256.cpp')
 if BUILD_DOUBLE_LOAD_TESTER:
     srcs.append('_doubleloadtester.cpp', )
 
@@ -162,8 +217,12 @@ sources = [os.path.join("src-ed25519","glue","ed25519module.c")]
 sources.extend([os.path.join("src-ed25519","supercop-ref",s)
                 for s in os.listdir(os.path.join("src-ed25519","supercop-ref"))
                 if s.endswith(".c") and s!="test.c"])
+ed25519_macros = []
+if ED25519_RADIX51:
+    ed25519_macros.append(('ED25519_RADIX51', 1))
 m = Extension("pycryptopp.publickey.ed25519._ed25519",
               include_dirs=[os.path.join("src-ed25519","supercop-ref")],
+              define_macros=ed25519_macros,
               sources=sources)
 ext_modules.append(m)
 
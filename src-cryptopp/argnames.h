@@ -78,6 +78,8 @@ CRYPTOPP_DEFINE_NAME_STRING(MaxLineLength)		//< int
 CRYPTOPP_DEFINE_NAME_STRING(DigestSize)			//!< int, in bytes
 CRYPTOPP_DEFINE_NAME_STRING(L1KeyLength)		//!< int, in bytes
 CRYPTOPP_DEFINE_NAME_STRING(TableSize)			//!< int, in bytes
+CRYPTOPP_DEFINE_NAME_STRING(UseCLMUL)			//!< bool, GCM: use CLMUL if the CPU has it, ON by default
+CRYPTOPP_DEFINE_NAME_STRING(BlocksPerPass)		//!< int, Salsa20: most keystream blocks per SIMD pass (1, 4 or 8), as many as the CPU can do by default
 CRYPTOPP_DEFINE_NAME_STRING(Blinding)			//!< bool, timing attack mitigations, ON by default
 CRYPTOPP_DEFINE_NAME_STRING(DerivedKey)			//!< ByteArrayParameter, key derivation, derived key
 CRYPTOPP_DEFINE_NAME_STRING(DerivedKeyLength)	//!< int, key derivation, derived key length in bytes
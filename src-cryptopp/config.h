@@ -426,6 +426,27 @@ NAMESPACE_END
 	#define CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE 0
 #endif
 
+// The SHA extensions (SHA-NI) also need SSSE3's palignr and SSE4.1's pblendw. GNU as learned the
+// SHA instructions in binutils 2.24, released 12/2/2013; GCC 4.9 (4/22/2014) stands in for it.
+#if !defined(CRYPTOPP_DISABLE_SHA) && CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE && (CRYPTOPP_GCC_VERSION >= 40900 || _MSC_VER >= 1900 || __INTEL_COMPILER >= 1600 || defined(__SHA__))
+	#define CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE 1
+#else
+	#define CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE 0
+#endif
+
+// AVX2 code is compiled with a target attribute rather than -mavx2, so that the rest of the library
+// still runs on CPUs without it. Callers must check HasAVX2() before calling into such code.
+#if !defined(CRYPTOPP_DISABLE_AVX2) && CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE && (CRYPTOPP_GCC_VERSION >= 40900 || CRYPTOPP_CLANG_VERSION >= 30400 || CRYPTOPP_APPLE_CLANG_VERSION >= 50100 || _MSC_VER >= 1800 || defined(__AVX2__))
+	#define CRYPTOPP_BOOL_AVX2_INTRINSICS_AVAILABLE 1
+	#if defined(__GNUC__) && !defined(__AVX2__)
+		#define CRYPTOPP_TARGET_AVX2 __attribute__((target("avx2")))
+	#else
+		#define CRYPTOPP_TARGET_AVX2
+	#endif
+#else
+	#define CRYPTOPP_BOOL_AVX2_INTRINSICS_AVAILABLE 0
+#endif
+
 #if CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE || CRYPTOPP_BOOL_SSE2_ASM_AVAILABLE || defined(CRYPTOPP_X64_MASM_AVAILABLE)
 	#define CRYPTOPP_BOOL_ALIGN16 1
 #else
@@ -22,6 +22,10 @@
 #include <emmintrin.h>
 #endif
 
+#if _MSC_FULL_VER >= 160040219
+#include <immintrin.h>	// _xgetbv
+#endif
+
 NAMESPACE_BEGIN(CryptoPP)
 
 #ifdef CRYPTOPP_CPUID_AVAILABLE
@@ -166,13 +170,37 @@ static bool TrySSE2()
 }
 
 bool g_x86DetectionDone = false;
-bool g_hasMMX = false, g_hasISSE = false, g_hasSSE2 = false, g_hasSSSE3 = false, g_hasAESNI = false, g_hasCLMUL = false, g_isP4 = false, g_hasRDRAND = false, g_hasRDSEED = false;
+bool g_hasMMX = false, g_hasISSE = false, g_hasSSE2 = false, g_hasSSSE3 = false, g_hasAESNI = false, g_hasCLMUL = false, g_hasSHA = false, g_hasAVX2 = false, g_isP4 = false, g_hasRDRAND = false, g_hasRDSEED = false;
 word32 g_cacheLineSize = CRYPTOPP_L1_CACHE_LINE_SIZE;
 
 // MacPorts/GCC does not provide constructor(priority). Apple/GCC and Fink/GCC do provide it.
 #define HAVE_GCC_CONSTRUCTOR1 (__GNUC__ && (CRYPTOPP_INIT_PRIORITY > 0) && ((CRYPTOPP_GCC_VERSION >= 40300) || (CRYPTOPP_CLANG_VERSION >= 20900) || (_INTEL_COMPILER >= 300)) && !(MACPORTS_GCC_COMPILER > 0))
 #define HAVE_GCC_CONSTRUCTOR0 (__GNUC__ && (CRYPTOPP_INIT_PRIORITY > 0) && !(MACPORTS_GCC_COMPILER > 0))
 
+// Only call this if CPUID says the OS has enabled XSAVE (OSXSAVE)
+static word32 XGetBV0()
+{
+#if _MSC_FULL_VER >= 160040219
+	return (word32)_xgetbv(0);
+#elif defined(CRYPTOPP_MS_STYLE_INLINE_ASSEMBLY)
+	word32 lo;
+	__asm
+	{
+		xor ecx, ecx
+		_emit 0x0f
+		_emit 0x01
+		_emit 0xd0
+		mov lo, eax
+	}
+	return lo;
+#else
+	word32 lo, hi;
+	// xgetbv, spelled out for assemblers that do not know it
+	__asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0" : "=a" (lo), "=d" (hi) : "c" (0));
+	return lo;
+#endif
+}
+
 static inline bool IsIntel(const word32 output[4])
 {
 	// This is the "GenuineIntel" string
@@ -223,6 +251,18 @@ void DetectX86Features()
 		}
 	}
 
+	word32 cpuid7[4] = {0, 0, 0, 0};
+	if (cpuid[0] /*EAX*/ >= 7)
+		CpuId(7, cpuid7);
+
+	// SHA extensions; the SHA-256 code built on them also uses SSSE3 and SSE4.1
+	if (g_hasSSSE3 && (cpuid1[2] & (1<<19)))
+		g_hasSHA = !!(cpuid7[1] /*EBX*/ & (1<<29));
+
+	// AVX2 also needs the OS to save the YMM registers: OSXSAVE and AVX, then XCR0 bits 1 and 2
+	if (g_hasSSE2 && (cpuid7[1] /*EBX*/ & (1<<5)) && (cpuid1[2] & (3<<27)) == (3<<27))
+		g_hasAVX2 = (XGetBV0() & 6) == 6;
+
 	static const unsigned int RDRAND_FLAG = (1 << 30);
 	static const unsigned int RDSEED_FLAG = (1 << 18);
 	if (IsIntel(cpuid))
@@ -106,6 +106,49 @@ NAMESPACE_END
 #endif // wmmintrin.h
 #endif // CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
 
+#if CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE
+#if !defined(__GNUC__) || (defined(__SHA__) && defined(__SSE4_1__)) || defined(__INTEL_COMPILER)
+#include <immintrin.h>
+#else
+NAMESPACE_BEGIN(CryptoPP)
+#ifndef __SSSE3__
+__inline __m128i __attribute__((__gnu_inline__, __always_inline__, __artificial__))
+_mm_alignr_epi8 (__m128i a, __m128i b, const int n)
+{
+	asm ("palignr %2, %1, %0" : "+x"(a) : "xm"(b), "i"(n));
+	return a;
+}
+#endif
+#ifndef __SSE4_1__
+__inline __m128i __attribute__((__gnu_inline__, __always_inline__, __artificial__))
+_mm_blend_epi16 (__m128i a, __m128i b, const int mask)
+{
+	asm ("pblendw %2, %1, %0" : "+x"(a) : "xm"(b), "i"(mask));
+	return a;
+}
+#endif
+__inline __m128i __attribute__((__gnu_inline__, __always_inline__, __artificial__))
+_mm_sha256rnds2_epu32 (__m128i a, __m128i b, __m128i k)
+{
+	asm ("sha256rnds2 %2, %1, %0" : "+x"(a) : "xm"(b), "Yz"(k));
+	return a;
+}
+__inline __m128i __attribute__((__gnu_inline__, __always_inline__, __artificial__))
+_mm_sha256msg1_epu32 (__m128i a, __m128i b)
+{
+	asm ("sha256msg1 %1, %0" : "+x"(a) : "xm"(b));
+	return a;
+}
+__inline __m128i __attribute__((__gnu_inline__, __always_inline__, __artificial__))
+_mm_sha256msg2_epu32 (__m128i a, __m128i b)
+{
+	asm ("sha256msg2 %1, %0" : "+x"(a) : "xm"(b));
+	return a;
+}
+NAMESPACE_END
+#endif // shaintrin.h
+#endif // CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE
+
 NAMESPACE_BEGIN(CryptoPP)
 
 #if CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64
@@ -120,6 +163,8 @@ extern CRYPTOPP_DLL bool g_hasSSE2;
 extern CRYPTOPP_DLL bool g_hasSSSE3;
 extern CRYPTOPP_DLL bool g_hasAESNI;
 extern CRYPTOPP_DLL bool g_hasCLMUL;
+extern CRYPTOPP_DLL bool g_hasSHA;
+extern CRYPTOPP_DLL bool g_hasAVX2;
 extern CRYPTOPP_DLL bool g_isP4;
 extern CRYPTOPP_DLL bool g_hasRDRAND;
 extern CRYPTOPP_DLL bool g_hasRDSEED;
@@ -182,6 +227,20 @@ inline bool HasCLMUL()
 	return g_hasCLMUL;
 }
 
+inline bool HasSHA()
+{
+	if (!g_x86DetectionDone)
+		DetectX86Features();
+	return g_hasSHA;
+}
+
+inline bool HasAVX2()
+{
+	if (!g_x86DetectionDone)
+		DetectX86Features();
+	return g_hasAVX2;
+}
+
 inline bool IsP4()
 {
 	if (!g_x86DetectionDone)
@@ -143,7 +143,8 @@ void GCM_Base::SetKeyWithoutResync(const byte *userKey, size_t keylength, const
 	int tableSize, i, j, k;
 
 #if CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
-	if (HasCLMUL())
+	const bool useCLMUL = HasCLMUL() && params.GetValueWithDefault(Name::UseCLMUL(), true);
+	if (useCLMUL)
 	{
 		// Avoid "parameter not used" error and suppress Coverity finding
 		(void)params.GetIntValue(Name::TableSize(), tableSize);
@@ -170,7 +171,7 @@ void GCM_Base::SetKeyWithoutResync(const byte *userKey, size_t keylength, const
 	blockCipher.ProcessBlock(hashKey);
 
 #if CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
-	if (HasCLMUL())
+	if (useCLMUL)
 	{
 		const __m128i r = s_clmulConstants[0];
 		__m128i h0 = _mm_shuffle_epi8(_mm_load_si128((__m128i *)hashKey), s_clmulConstants[1]);
@@ -275,10 +276,20 @@ void GCM_Base::SetKeyWithoutResync(const byte *userKey, size_t keylength, const
 	}
 }
 
+bool GCM_Base::UsesCLMUL() const
+{
+#if CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
+	// the CLMUL table is smaller than either size of multiplication table
+	return m_buffer.size() == 3*REQUIRED_BLOCKSIZE + s_clmulTableSizeInBlocks*REQUIRED_BLOCKSIZE;
+#else
+	return false;
+#endif
+}
+
 inline void GCM_Base::ReverseHashBufferIfNeeded()
 {
 #if CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
-	if (HasCLMUL())
+	if (UsesCLMUL())
 	{
 		__m128i &x = *(__m128i *)HashBuffer();
 		x = _mm_shuffle_epi8(x, s_clmulConstants[1]);
@@ -358,7 +369,7 @@ void GCM_AuthenticateBlocks_64K(const byte *data, size_t blocks, word64 *hashBuf
 size_t GCM_Base::AuthenticateBlocks(const byte *data, size_t len)
 {
 #if CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
-	if (HasCLMUL())
+	if (UsesCLMUL())
 	{
 		const __m128i *table = (const __m128i *)MulTable();
 		__m128i x = _mm_load_si128((__m128i *)HashBuffer());
@@ -16,6 +16,12 @@ NAMESPACE_BEGIN(CryptoPP)
 //! \brief Use either 2K or 64K size tables.
 enum GCM_TablesOption {GCM_2K_Tables, GCM_64K_Tables};
 
+//! \brief Defined when GCM honours the \p UseCLMUL parameter
+//! \details By default GCM uses CLMUL whenever the CPU supports it, whatever the
+//!   \p TableSize. Passing <tt>UseCLMUL=false</tt> when keying makes the object use
+//!   multiplication tables of \p TableSize bytes instead.
+#define CRYPTOPP_GCM_OPTIONAL_CLMUL 1
+
 //! \class GCM_Base
 //! \brief CCM block cipher mode of operation.
 //! \details Implementations and overrides in \p GCM_Base apply to both \p ENCRYPTION and \p DECRYPTION directions
@@ -73,6 +79,7 @@ protected:
 	byte *HashKey() {return m_buffer+2*REQUIRED_BLOCKSIZE;}
 	byte *MulTable() {return m_buffer+3*REQUIRED_BLOCKSIZE;}
 	inline void ReverseHashBufferIfNeeded();
+	bool UsesCLMUL() const;
 
 	class CRYPTOPP_DLL GCTR : public CTR_Mode_ExternalCipher::Encryption
 	{
@@ -6,13 +6,35 @@
 #include "ida.h"
 #include "algebra.h"
 #include "gf2_32.h"
+#include "gf256.h"
+#include "cpu.h"
 #include "polynomi.h"
 #include "polynomi.cpp"
 
 #include <functional>
+#include <algorithm>
+
+// pshufb comes with the AES-NI intrinsics, as an inline asm wrapper in cpu.h where the compiler lacks -mssse3
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && defined(CRYPTOPP_CPUID_AVAILABLE) && CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
+#define CRYPTOPP_IDA_PSHUFB_AVAILABLE
+#if CRYPTOPP_BOOL_AVX2_INTRINSICS_AVAILABLE
+#include <immintrin.h>
+#define CRYPTOPP_IDA_VPSHUFB_AVAILABLE
+#endif
+#endif
 
 ANONYMOUS_NAMESPACE_BEGIN
 static const CryptoPP::GF2_32 field;
+
+// GF256 with the names the polynomial interpolation templates expect
+class GF256Field : public CryptoPP::GF256
+{
+public:
+	GF256Field() : GF256(0x1d) {}
+	Element Identity() const {return 0;}
+	Element MultiplicativeIdentity() const {return 1;}
+};
+static const GF256Field field256;
 NAMESPACE_END
 
 NAMESPACE_BEGIN(CryptoPP)
@@ -420,4 +442,241 @@ size_t PaddingRemover::Put2(const byte *begin, size_t length, int messageEnd, bo
 	return 0;
 }
 
+// ****************************************************************
+
+BlockIDA::Kernel BlockIDA::GetBestKernel(Field field)
+{
+	if (field == GF256_FIELD)
+	{
+#ifdef CRYPTOPP_IDA_VPSHUFB_AVAILABLE
+		if (HasAVX2())
+			return AVX2_KERNEL;
+#endif
+#ifdef CRYPTOPP_IDA_PSHUFB_AVAILABLE
+		if (HasSSSE3())
+			return SSSE3_KERNEL;
+#endif
+	}
+	return SCALAR_KERNEL;
+}
+
+void BlockIDA::Initialize(unsigned int threshold, const word32 *inputIds, const word32 *outputIds, unsigned int nOutputs, Field field, Kernel kernel)
+{
+	if (threshold == 0)
+		throw InvalidArgument("BlockIDA: threshold must be greater than 0");
+
+	std::vector<word32> w(inputIds, inputIds+threshold);
+	std::sort(w.begin(), w.end());
+	if (std::adjacent_find(w.begin(), w.end()) != w.end())
+		throw InvalidArgument("BlockIDA: input share IDs must be distinct");
+
+	const Kernel best = GetBestKernel(field);
+	if (kernel == DEFAULT_KERNEL)
+		kernel = best;
+	else if (kernel > best)
+		throw InvalidArgument("BlockIDA: the requested kernel is not available for this field on this CPU");
+
+	m_threshold = threshold;
+	m_field = field;
+	m_kernel = kernel;
+	m_outputToInput.resize(nOutputs);
+	for (unsigned int i=0; i<nOutputs; i++)
+		m_outputToInput[i] = (unsigned int)(std::find(inputIds, inputIds+threshold, outputIds[i]) - inputIds);
+
+	if (field == GF256_FIELD)
+	{
+		if (w.back() > 0xff || std::find_if(outputIds, outputIds+nOutputs, std::bind2nd(std::greater<word32>(), word32(0xff))) != outputIds+nOutputs)
+			throw InvalidArgument("BlockIDA: share IDs in GF(2^8) must be less than 256");
+
+		std::vector<byte> x(inputIds, inputIds+threshold), w256(threshold), v(threshold);
+		PrepareBulkPolynomialInterpolation(field256, &w256[0], &x[0], threshold);
+
+		m_v.clear();
+		m_tables.assign(size_t(nOutputs)*threshold*32, 0);
+		for (unsigned int i=0; i<nOutputs; i++)
+		{
+			if (m_outputToInput[i] != threshold)
+				continue;
+			PrepareBulkPolynomialInterpolationAt(field256, &v[0], byte(outputIds[i]), &x[0], &w256[0], threshold);
+			for (unsigned int j=0; j<threshold; j++)
+			{
+				byte *t = &m_tables[(size_t(i)*threshold+j)*32];
+				for (unsigned int n=0; n<16; n++)
+				{
+					t[n] = field256.Multiply(v[j], byte(n));
+					t[16+n] = field256.Multiply(v[j], byte(n<<4));
+				}
+			}
+		}
+	}
+	else
+	{
+		PrepareBulkPolynomialInterpolation(::field, &w[0], inputIds, threshold);
+
+		m_tables.clear();
+		m_v.resize(size_t(nOutputs)*threshold);
+		for (unsigned int i=0; i<nOutputs; i++)
+			if (m_outputToInput[i] == threshold)
+				PrepareBulkPolynomialInterpolationAt(::field, &m_v[size_t(i)*threshold], outputIds[i], inputIds, &w[0], threshold);
+	}
+}
+
+// table[256*b+x] = c*(x<<(24-8*b)), so that c*y is the XOR of four lookups, one per byte of y
+static void BlockIDA_MultiplicationTable(word32 c, word32 *table)
+{
+	word32 power = c;
+	for (int b=3; b>=0; b--)
+	{
+		word32 *t = table + 256*b;
+		t[0] = 0;
+		for (unsigned int e=1; e<256; e<<=1)
+		{
+			t[e] = power;
+			power = field.Multiply(power, 2);
+		}
+		for (unsigned int x=3; x<256; x++)
+			if (x & (x-1))
+				t[x] = t[x & (x-1)] ^ t[x & (0-x)];
+	}
+}
+
+void BlockIDA::Compute(byte *const *outputs, const byte *const *inputs, size_t length) const
+{
+	assert(length % GetSymbolSize() == 0);
+
+	if (m_field == GF256_FIELD)
+	{
+		ComputeGF256(outputs, inputs, length);
+		return;
+	}
+
+	const unsigned int k = m_threshold;
+	SecBlock<word32> tables(1024*k);
+
+	for (unsigned int i=0; i<m_outputToInput.size(); i++)
+	{
+		if (m_outputToInput[i] != k)
+		{
+			memcpy(outputs[i], inputs[m_outputToInput[i]], length);
+			continue;
+		}
+
+		for (unsigned int j=0; j<k; j++)
+			BlockIDA_MultiplicationTable(m_v[size_t(i)*k+j], tables+1024*j);
+
+		byte *out = outputs[i];
+		for (size_t n=0; n+4<=length; n+=4)
+		{
+			word32 y = 0;
+			for (unsigned int j=0; j<k; j++)
+			{
+				const byte *in = inputs[j]+n;
+				const word32 *t = tables+1024*j;
+				y ^= t[in[0]] ^ t[256+in[1]] ^ t[512+in[2]] ^ t[768+in[3]];
+			}
+			PutWord(false, BIG_ENDIAN_ORDER, out+n, y);
+		}
+	}
+}
+
+// The GF(2^8) kernels set out[0..length-1] to the sum over j of the products of in[j][offset..offset+length-1]
+// with the coefficient whose split-nibble tables are at tables+32*j.
+
+static void BlockIDA_GF256_Scalar(byte *out, const byte *const *in, size_t offset, size_t length, const byte *tables, unsigned int k)
+{
+	for (size_t n=0; n<length; n++)
+	{
+		byte y = 0;
+		for (unsigned int j=0; j<k; j++)
+		{
+			const byte x = in[j][offset+n];
+			y ^= tables[32*j+(x&15)] ^ tables[32*j+16+(x>>4)];
+		}
+		out[n] = y;
+	}
+}
+
+#ifdef CRYPTOPP_IDA_PSHUFB_AVAILABLE
+static size_t BlockIDA_GF256_SSSE3(byte *out, const byte *const *in, size_t offset, size_t length, const byte *tables, unsigned int k)
+{
+	const __m128i mask = _mm_set1_epi8(15);
+	size_t n;
+	for (n=0; n+16<=length; n+=16)
+	{
+		__m128i y = _mm_setzero_si128();
+		for (unsigned int j=0; j<k; j++)
+		{
+			const __m128i x = _mm_loadu_si128((const __m128i *)(in[j]+offset+n));
+			const __m128i lo = _mm_loadu_si128((const __m128i *)(tables+32*j));
+			const __m128i hi = _mm_loadu_si128((const __m128i *)(tables+32*j+16));
+			y = _mm_xor_si128(y, _mm_shuffle_epi8(lo, _mm_and_si128(x, mask)));
+			y = _mm_xor_si128(y, _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(x, 4), mask)));
+		}
+		_mm_storeu_si128((__m128i *)(out+n), y);
+	}
+	return n;
+}
+#endif
+
+#ifdef CRYPTOPP_IDA_VPSHUFB_AVAILABLE
+CRYPTOPP_TARGET_AVX2
+static size_t BlockIDA_GF256_AVX2(byte *out, const byte *const *in, size_t offset, size_t length, const byte *tables, unsigned int k)
+{
+	const __m256i mask = _mm256_set1_epi8(15);
+	size_t n;
+	for (n=0; n+32<=length; n+=32)
+	{
+		__m256i y = _mm256_setzero_si256();
+		for (unsigned int j=0; j<k; j++)
+		{
+			const __m256i x = _mm256_loadu_si256((const __m256i *)(in[j]+offset+n));
+			// both halves of lo and hi hold the table; _mm256_broadcastsi128_si256 would
+			// do it in one step, but some GCC releases that have AVX2 lack it
+			const __m128i lo128 = _mm_loadu_si128((const __m128i *)(tables+32*j));
+			const __m128i hi128 = _mm_loadu_si128((const __m128i *)(tables+32*j+16));
+			const __m256i lo = _mm256_inserti128_si256(_mm256_castsi128_si256(lo128), lo128, 1);
+			const __m256i hi = _mm256_inserti128_si256(_mm256_castsi128_si256(hi128), hi128, 1);
+			y = _mm256_xor_si256(y, _mm256_shuffle_epi8(lo, _mm256_and_si256(x, mask)));
+			y = _mm256_xor_si256(y, _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(x, 4), mask)));
+		}
+		_mm256_storeu_si256((__m256i *)(out+n), y);
+	}
+	return n;
+}
+#endif
+
+void BlockIDA::ComputeGF256(byte *const *outputs, const byte *const *inputs, size_t length) const
+{
+	// Take the inputs a stripe at a time, small enough that a stripe of every input stays in cache
+	// while all of the outputs are computed from it.
+	const size_t STRIPE = 4096;
+	const unsigned int k = m_threshold;
+
+	for (size_t offset=0; offset<length; offset+=STRIPE)
+	{
+		const size_t len = STDMIN(STRIPE, length-offset);
+		for (unsigned int i=0; i<m_outputToInput.size(); i++)
+		{
+			byte *out = outputs[i]+offset;
+			if (m_outputToInput[i] != k)
+			{
+				memcpy(out, inputs[m_outputToInput[i]]+offset, len);
+				continue;
+			}
+
+			const byte *tables = &m_tables[size_t(i)*k*32];
+			size_t done = 0;
+#ifdef CRYPTOPP_IDA_VPSHUFB_AVAILABLE
+			if (m_kernel == AVX2_KERNEL)
+				done = BlockIDA_GF256_AVX2(out, inputs, offset, len, tables, k);
+#endif
+#ifdef CRYPTOPP_IDA_PSHUFB_AVAILABLE
+			if (m_kernel >= SSSE3_KERNEL)
+				done += BlockIDA_GF256_SSSE3(out+done, inputs, offset+done, len-done, tables, k);
+#endif
+			BlockIDA_GF256_Scalar(out+done, inputs, offset+done, len-done, tables, k);
+		}
+	}
+}
+
 NAMESPACE_END
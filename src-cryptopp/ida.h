@@ -156,6 +156,51 @@ private:
 	lword m_zeroCount;
 };
 
+/// the arithmetic of RawIDA over whole shares held in contiguous buffers
+/*! A share is a sequence of symbols. At each symbol position, the share with ID x holds
+	the value at x of the polynomial of degree less than the threshold that passes through
+	the input shares' symbols at that position. With GF2_32_FIELD the symbols are big-endian
+	32-bit words in GF(2^32), and the shares are the ones RawIDA computes one word at a time
+	through its message queues. With GF256_FIELD they are bytes in GF(2^8) modulo
+	x^8+x^4+x^3+x^2+1, share IDs are below 256, and the shares are computed in stripes,
+	multiplying 16 or 32 bytes at a time with PSHUFB lookups in split-nibble tables. */
+class BlockIDA
+{
+public:
+	enum Field {GF2_32_FIELD, GF256_FIELD};
+	//! how GF256_FIELD multiplies; every kernel gives the same shares
+	enum Kernel {DEFAULT_KERNEL, SCALAR_KERNEL, SSSE3_KERNEL, AVX2_KERNEL};
+
+	BlockIDA() : m_threshold(0), m_field(GF2_32_FIELD), m_kernel(SCALAR_KERNEL) {}
+
+	//! the kernel that DEFAULT_KERNEL selects for field on this CPU
+	static Kernel GetBestKernel(Field field);
+
+	//! prepare to compute the shares with IDs outputIds[0..nOutputs-1] from the shares with IDs inputIds[0..threshold-1]
+	/*! \throws InvalidArgument if the IDs are not valid for field or kernel is not available on this CPU */
+	void Initialize(unsigned int threshold, const word32 *inputIds, const word32 *outputIds, unsigned int nOutputs, Field field=GF2_32_FIELD, Kernel kernel=DEFAULT_KERNEL);
+
+	unsigned int GetThreshold() const {return m_threshold;}
+	unsigned int GetOutputCount() const {return (unsigned int)m_outputToInput.size();}
+	Field GetField() const {return m_field;}
+	Kernel GetKernel() const {return m_kernel;}
+	unsigned int GetSymbolSize() const {return m_field == GF256_FIELD ? 1 : 4;}
+
+	//! inputs[j] holds the length bytes of share inputIds[j]; outputs[i] receives the length bytes of share outputIds[i]
+	/*! length must be a multiple of GetSymbolSize() */
+	void Compute(byte *const *outputs, const byte *const *inputs, size_t length) const;
+
+private:
+	void ComputeGF256(byte *const *outputs, const byte *const *inputs, size_t length) const;
+
+	unsigned int m_threshold;
+	Field m_field;
+	Kernel m_kernel;
+	std::vector<unsigned int> m_outputToInput;	// index of the input share with the same ID, or m_threshold
+	std::vector<word32> m_v;	// m_threshold interpolation coefficients per output share (GF2_32_FIELD)
+	std::vector<byte> m_tables;	// 32 bytes per coefficient: products with the low nibbles, then the high nibbles (GF256_FIELD)
+};
+
 NAMESPACE_END
 
 #endif
@@ -12,6 +12,10 @@
 #include "misc.h"
 #include "cpu.h"
 
+#if CRYPTOPP_BOOL_AVX2_INTRINSICS_AVAILABLE && defined(CRYPTOPP_SALSA_SIMD_INTRINSICS)
+#include <immintrin.h>
+#endif
+
 #if CRYPTOPP_MSC_VERSION
 # pragma warning(disable: 4702 4740)
 #endif
@@ -57,7 +61,24 @@ void Salsa20_Policy::CipherSetKey(const NameValuePairs &params, const byte *key,
 	m_state[1] = (length == 16) ? 0x3120646e : 0x3320646e;
 	m_state[2] = (length == 16) ? 0x79622d36 : 0x79622d32;
 	m_state[3] = 0x6b206574;
+
+#ifdef CRYPTOPP_SALSA_SIMD_INTRINSICS
+	SetBlocksPerPass(params);
+#endif
+}
+
+#ifdef CRYPTOPP_SALSA_SIMD_INTRINSICS
+void Salsa20_Policy::SetBlocksPerPass(const NameValuePairs &params)
+{
+	unsigned int most = HasSSE2() ? 4 : 1;
+#if CRYPTOPP_BOOL_AVX2_INTRINSICS_AVAILABLE
+	if (HasAVX2())
+		most = 8;
+#endif
+	const int requested = params.GetIntValueWithDefault(Name::BlocksPerPass(), (int)most);
+	m_blocksPerPass = STDMIN(most, requested >= 8 ? 8U : requested >= 4 ? 4U : 1U);
 }
+#endif
 
 void Salsa20_Policy::CipherResynchronize(byte *keystreamBuffer, const byte *IV, size_t length)
 {
@@ -75,7 +96,7 @@ void Salsa20_Policy::SeekToIteration(lword iterationCount)
 	m_state[5] = (word32)SafeRightShift<32>(iterationCount);
 }
 
-#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && !defined(CRYPTOPP_DISABLE_SALSA_ASM)
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && (!defined(CRYPTOPP_DISABLE_SALSA_ASM) || defined(CRYPTOPP_SALSA_SIMD_INTRINSICS))
 unsigned int Salsa20_Policy::GetAlignment() const
 {
 #if CRYPTOPP_BOOL_SSE2_ASM_AVAILABLE
@@ -88,7 +109,9 @@ unsigned int Salsa20_Policy::GetAlignment() const
 
 unsigned int Salsa20_Policy::GetOptimalBlockSize() const
 {
-#if CRYPTOPP_BOOL_SSE2_ASM_AVAILABLE
+#if defined(CRYPTOPP_SALSA_SIMD_INTRINSICS)
+	return m_blocksPerPass*BYTES_PER_ITERATION;
+#elif CRYPTOPP_BOOL_SSE2_ASM_AVAILABLE
 	if (HasSSE2())
 		return 4*BYTES_PER_ITERATION;
 	else
@@ -97,6 +120,173 @@ unsigned int Salsa20_Policy::GetOptimalBlockSize() const
 }
 #endif
 
+#ifdef CRYPTOPP_SALSA_SIMD_INTRINSICS
+
+// The same rounds as the scalar code below, on 4 (SSE2) or 8 (AVX2) blocks at once, each lane
+// holding one block. V is the vector type; ADD, XOR and ROTL are its operations.
+#define SALSA_SIMD_QUARTER_ROUND(a, b, c, d)	\
+	b = XOR(b, ROTL(ADD(a, d), 7));	\
+	c = XOR(c, ROTL(ADD(b, a), 9));	\
+	d = XOR(d, ROTL(ADD(c, b), 13));	\
+	a = XOR(a, ROTL(ADD(d, c), 18));
+
+#define SALSA_SIMD_ROUNDS(x, s, rounds)	{\
+	for (int i=0; i<16; i++)	\
+		x[i] = s[i];	\
+	for (int i=rounds; i>0; i-=2)	\
+	{	\
+		SALSA_SIMD_QUARTER_ROUND(x[0], x[4], x[8], x[12])	\
+		SALSA_SIMD_QUARTER_ROUND(x[1], x[5], x[9], x[13])	\
+		SALSA_SIMD_QUARTER_ROUND(x[2], x[6], x[10], x[14])	\
+		SALSA_SIMD_QUARTER_ROUND(x[3], x[7], x[11], x[15])	\
+		SALSA_SIMD_QUARTER_ROUND(x[0], x[13], x[10], x[7])	\
+		SALSA_SIMD_QUARTER_ROUND(x[1], x[14], x[11], x[4])	\
+		SALSA_SIMD_QUARTER_ROUND(x[2], x[15], x[8], x[5])	\
+		SALSA_SIMD_QUARTER_ROUND(x[3], x[12], x[9], x[6])	\
+	}	\
+	for (int i=0; i<16; i++)	\
+		x[i] = ADD(x[i], s[i]);}
+
+// m_state words in keystream order, 4 words (16 bytes) per row; see SALSA_OUTPUT below
+static const int s_salsaOutputOrder[4][4] = {{0, 13, 10, 7}, {4, 1, 14, 11}, {8, 5, 2, 15}, {12, 9, 6, 3}};
+
+// lane i of the block counter vectors gets block counter + i
+static inline void Salsa20_LaneCounters(const word32 *state, unsigned int lanes, word32 *lo, word32 *hi)
+{
+	for (unsigned int i=0; i<lanes; i++)
+	{
+		lo[i] = state[8] + i;
+		hi[i] = state[5] + (lo[i] < state[8]);
+	}
+}
+
+static inline void Salsa20_AdvanceCounter(word32 *state, unsigned int blocks)
+{
+	state[8] += blocks;
+	if (state[8] < blocks)
+		++state[5];
+}
+
+#define ADD _mm_add_epi32
+#define XOR _mm_xor_si128
+#define ROTL(v, n) _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32-n))
+
+// blocks is a multiple of 4
+static void Salsa20_OperateKeystream_SSE2(KeystreamOperation operation, byte *output, const byte *input, size_t blocks, int rounds, word32 *state)
+{
+	__m128i s[16], x[16];
+	word32 lo[4], hi[4];
+
+	for (int i=0; i<16; i++)
+		s[i] = _mm_set1_epi32(state[i]);
+
+	for (; blocks; blocks-=4)
+	{
+		Salsa20_LaneCounters(state, 4, lo, hi);
+		s[8] = _mm_loadu_si128((const __m128i *)lo);
+		s[5] = _mm_loadu_si128((const __m128i *)hi);
+
+		SALSA_SIMD_ROUNDS(x, s, rounds)
+
+		for (int row=0; row<4; row++)
+		{
+			// transpose, so that t[i] is this row of lane i's block
+			const int *w = s_salsaOutputOrder[row];
+			const __m128i t0 = _mm_unpacklo_epi32(x[w[0]], x[w[1]]);
+			const __m128i t1 = _mm_unpacklo_epi32(x[w[2]], x[w[3]]);
+			const __m128i t2 = _mm_unpackhi_epi32(x[w[0]], x[w[1]]);
+			const __m128i t3 = _mm_unpackhi_epi32(x[w[2]], x[w[3]]);
+			__m128i t[4] = {_mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1), _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3)};
+
+			for (int i=0; i<4; i++)
+			{
+				if (!(operation & INPUT_NULL))
+					t[i] = _mm_xor_si128(t[i], _mm_loadu_si128((const __m128i *)input + 4*i + row));
+				_mm_storeu_si128((__m128i *)output + 4*i + row, t[i]);
+			}
+		}
+
+		Salsa20_AdvanceCounter(state, 4);
+		output += 4*64;
+		if (!(operation & INPUT_NULL))
+			input += 4*64;
+	}
+}
+
+#undef ADD
+#undef XOR
+#undef ROTL
+
+#if CRYPTOPP_BOOL_AVX2_INTRINSICS_AVAILABLE
+
+#define ADD _mm256_add_epi32
+#define XOR _mm256_xor_si256
+#define ROTL(v, n) _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32-n))
+
+// blocks is a multiple of 8
+CRYPTOPP_TARGET_AVX2
+static void Salsa20_OperateKeystream_AVX2(KeystreamOperation operation, byte *output, const byte *input, size_t blocks, int rounds, word32 *state)
+{
+	__m256i s[16], x[16];
+	word32 lo[8], hi[8];
+
+	for (int i=0; i<16; i++)
+		s[i] = _mm256_set1_epi32(state[i]);
+
+	for (; blocks; blocks-=8)
+	{
+		Salsa20_LaneCounters(state, 8, lo, hi);
+		s[8] = _mm256_loadu_si256((const __m256i *)lo);
+		s[5] = _mm256_loadu_si256((const __m256i *)hi);
+
+		SALSA_SIMD_ROUNDS(x, s, rounds)
+
+		for (int row=0; row<4; row+=2)
+		{
+			// transpose within each 128-bit half, so that t[r][i] is row r of lane i's block in
+			// the low half and of lane i+4's block in the high half
+			__m256i t[2][4];
+			for (int r=0; r<2; r++)
+			{
+				const int *w = s_salsaOutputOrder[row+r];
+				const __m256i t0 = _mm256_unpacklo_epi32(x[w[0]], x[w[1]]);
+				const __m256i t1 = _mm256_unpacklo_epi32(x[w[2]], x[w[3]]);
+				const __m256i t2 = _mm256_unpackhi_epi32(x[w[0]], x[w[1]]);
+				const __m256i t3 = _mm256_unpackhi_epi32(x[w[2]], x[w[3]]);
+				t[r][0] = _mm256_unpacklo_epi64(t0, t1);
+				t[r][1] = _mm256_unpackhi_epi64(t0, t1);
+				t[r][2] = _mm256_unpacklo_epi64(t2, t3);
+				t[r][3] = _mm256_unpackhi_epi64(t2, t3);
+			}
+
+			for (int i=0; i<4; i++)
+			{
+				// rows row and row+1 of lanes i and i+4
+				__m256i k[2] = {_mm256_permute2x128_si256(t[0][i], t[1][i], 0x20), _mm256_permute2x128_si256(t[0][i], t[1][i], 0x31)};
+				for (int j=0; j<2; j++)
+				{
+					const size_t offset = 2*(4*j+i) + row/2;	// in 32-byte units
+					if (!(operation & INPUT_NULL))
+						k[j] = _mm256_xor_si256(k[j], _mm256_loadu_si256((const __m256i *)input + offset));
+					_mm256_storeu_si256((__m256i *)output + offset, k[j]);
+				}
+			}
+		}
+
+		Salsa20_AdvanceCounter(state, 8);
+		output += 8*64;
+		if (!(operation & INPUT_NULL))
+			input += 8*64;
+	}
+}
+
+#undef ADD
+#undef XOR
+#undef ROTL
+
+#endif	// CRYPTOPP_BOOL_AVX2_INTRINSICS_AVAILABLE
+#endif	// CRYPTOPP_SALSA_SIMD_INTRINSICS
+
 #ifdef CRYPTOPP_X64_MASM_AVAILABLE
 extern "C" {
 void Salsa20_OperateKeystream(byte *output, const byte *input, size_t iterationCount, int rounds, void *state);
@@ -514,6 +704,28 @@ Salsa20_OperateKeystream ENDP
 #endif
 #ifndef CRYPTOPP_GENERATE_X64_MASM
 	{
+#ifdef CRYPTOPP_SALSA_SIMD_INTRINSICS
+		// as many blocks as possible the wide way, the rest one at a time below
+		size_t blocks = 0;
+#if CRYPTOPP_BOOL_AVX2_INTRINSICS_AVAILABLE
+		if (m_blocksPerPass >= 8 && iterationCount >= 8)
+		{
+			blocks = iterationCount & ~size_t(7);
+			Salsa20_OperateKeystream_AVX2(operation, output, input, blocks, m_rounds, m_state);
+		}
+#endif
+		if (m_blocksPerPass >= 4 && iterationCount - blocks >= 4)
+		{
+			const size_t n = (iterationCount - blocks) & ~size_t(3);
+			Salsa20_OperateKeystream_SSE2(operation, output + 64*blocks, (operation & INPUT_NULL) ? input : input + 64*blocks, n, m_rounds, m_state);
+			blocks += n;
+		}
+		iterationCount -= blocks;
+		output += 64*blocks;
+		if (!(operation & INPUT_NULL))
+			input += 64*blocks;
+#endif
+
 		word32 x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
 
 		while (iterationCount--)
@@ -586,6 +798,10 @@ void XSalsa20_Policy::CipherSetKey(const NameValuePairs &params, const byte *key
 	m_state[1] = 0x3320646e;
 	m_state[2] = 0x79622d32;
 	m_state[3] = 0x6b206574;
+
+#ifdef CRYPTOPP_SALSA_SIMD_INTRINSICS
+	SetBlocksPerPass(params);
+#endif
 }
 
 void XSalsa20_Policy::CipherResynchronize(byte *keystreamBuffer, const byte *IV, size_t length)
@@ -16,6 +16,12 @@
 # define CRYPTOPP_DISABLE_SALSA_ASM
 #endif
 
+// Where the SSE2 assembly is not used, the keystream is computed 4 blocks at a time with SSE2
+// intrinsics, or 8 at a time with AVX2 intrinsics when the CPU has AVX2
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && CRYPTOPP_BOOL_SSE2_INTRINSICS_AVAILABLE && !defined(CRYPTOPP_X64_MASM_AVAILABLE) && (defined(CRYPTOPP_DISABLE_SALSA_ASM) || !CRYPTOPP_BOOL_SSE2_ASM_AVAILABLE)
+# define CRYPTOPP_SALSA_SIMD_INTRINSICS 1
+#endif
+
 NAMESPACE_BEGIN(CryptoPP)
 
 //! \class Salsa20_Info
@@ -33,13 +39,20 @@ protected:
 	void CipherResynchronize(byte *keystreamBuffer, const byte *IV, size_t length);
 	bool CipherIsRandomAccess() const {return true;}
 	void SeekToIteration(lword iterationCount);
-#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && !defined(CRYPTOPP_DISABLE_SALSA_ASM)
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64) && (!defined(CRYPTOPP_DISABLE_SALSA_ASM) || defined(CRYPTOPP_SALSA_SIMD_INTRINSICS))
 	unsigned int GetAlignment() const;
 	unsigned int GetOptimalBlockSize() const;
 #endif
+#ifdef CRYPTOPP_SALSA_SIMD_INTRINSICS
+	void SetBlocksPerPass(const NameValuePairs &params);
+#endif
 
 	FixedSizeAlignedSecBlock<word32, 16> m_state;
 	int m_rounds;
+#ifdef CRYPTOPP_SALSA_SIMD_INTRINSICS
+	// 8 with AVX2, 4 with SSE2 or 1, capped by the BlocksPerPass parameter
+	unsigned int m_blocksPerPass;
+#endif
 };
 
 // <a href="http://www.cryptolounge.org/wiki/Salsa20">Salsa20</a>, variable rounds: 8, 12 or 20 (default 20)
@@ -461,18 +461,122 @@ void CRYPTOPP_FASTCALL X86_SHA256_HashBlocks(word32 *state, const word32 *data,
 }
 #endif
 
-#if defined(CRYPTOPP_X86_ASM_AVAILABLE) || defined(CRYPTOPP_X32_ASM_AVAILABLE) || defined(CRYPTOPP_X64_MASM_AVAILABLE)
+#if CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE
+
+// rounds 4*i to 4*i+3, extending the message schedule along the way
+#define SHA256_SHA_ROUNDS(i, Mi, Mprev, Mnext) \
+	MSG = _mm_add_epi32(Mi, _mm_loadu_si128((const __m128i *)(SHA256_K+4*i))); \
+	STATE1 = _mm_sha256rnds2_epu32(STATE1, STATE0, MSG); \
+	if (i >= 3 && i <= 14) \
+	{ \
+		Mnext = _mm_add_epi32(Mnext, _mm_alignr_epi8(Mi, Mprev, 4)); \
+		Mnext = _mm_sha256msg2_epu32(Mnext, Mi); \
+	} \
+	MSG = _mm_shuffle_epi32(MSG, 0x0E); \
+	STATE0 = _mm_sha256rnds2_epu32(STATE0, STATE1, MSG); \
+	if (i >= 1 && i <= 12) \
+		Mprev = _mm_sha256msg1_epu32(Mprev, Mi);
+
+// length is a multiple of 64. The data is in big-endian byte order if
+// bigEndianData, and already in native words otherwise.
+static void SHA256_SSE_SHA_HashBlocks(word32 *state, const word32 *data, size_t length, bool bigEndianData)
+{
+	const __m128i MASK = _mm_set_epi8(12,13,14,15, 8,9,10,11, 4,5,6,7, 0,1,2,3);
+	__m128i STATE0, STATE1, MSG, TMP, MSG0, MSG1, MSG2, MSG3, ABEF_SAVE, CDGH_SAVE;
+
+	// the instructions want the state as ABEF and CDGH
+	TMP = _mm_loadu_si128((const __m128i *)(state+0));
+	STATE1 = _mm_loadu_si128((const __m128i *)(state+4));
+	TMP = _mm_shuffle_epi32(TMP, 0xB1);
+	STATE1 = _mm_shuffle_epi32(STATE1, 0x1B);
+	STATE0 = _mm_alignr_epi8(TMP, STATE1, 8);
+	STATE1 = _mm_blend_epi16(STATE1, TMP, 0xF0);
+
+	for (; length >= 64; length -= 64, data += 16)
+	{
+		ABEF_SAVE = STATE0;
+		CDGH_SAVE = STATE1;
+
+		MSG0 = _mm_loadu_si128((const __m128i *)(data+0));
+		MSG1 = _mm_loadu_si128((const __m128i *)(data+4));
+		MSG2 = _mm_loadu_si128((const __m128i *)(data+8));
+		MSG3 = _mm_loadu_si128((const __m128i *)(data+12));
+		if (bigEndianData)
+		{
+			MSG0 = _mm_shuffle_epi8(MSG0, MASK);
+			MSG1 = _mm_shuffle_epi8(MSG1, MASK);
+			MSG2 = _mm_shuffle_epi8(MSG2, MASK);
+			MSG3 = _mm_shuffle_epi8(MSG3, MASK);
+		}
+
+		SHA256_SHA_ROUNDS( 0, MSG0, MSG3, MSG1)
+		SHA256_SHA_ROUNDS( 1, MSG1, MSG0, MSG2)
+		SHA256_SHA_ROUNDS( 2, MSG2, MSG1, MSG3)
+		SHA256_SHA_ROUNDS( 3, MSG3, MSG2, MSG0)
+		SHA256_SHA_ROUNDS( 4, MSG0, MSG3, MSG1)
+		SHA256_SHA_ROUNDS( 5, MSG1, MSG0, MSG2)
+		SHA256_SHA_ROUNDS( 6, MSG2, MSG1, MSG3)
+		SHA256_SHA_ROUNDS( 7, MSG3, MSG2, MSG0)
+		SHA256_SHA_ROUNDS( 8, MSG0, MSG3, MSG1)
+		SHA256_SHA_ROUNDS( 9, MSG1, MSG0, MSG2)
+		SHA256_SHA_ROUNDS(10, MSG2, MSG1, MSG3)
+		SHA256_SHA_ROUNDS(11, MSG3, MSG2, MSG0)
+		SHA256_SHA_ROUNDS(12, MSG0, MSG3, MSG1)
+		SHA256_SHA_ROUNDS(13, MSG1, MSG0, MSG2)
+		SHA256_SHA_ROUNDS(14, MSG2, MSG1, MSG3)
+		SHA256_SHA_ROUNDS(15, MSG3, MSG2, MSG0)
+
+		STATE0 = _mm_add_epi32(STATE0, ABEF_SAVE);
+		STATE1 = _mm_add_epi32(STATE1, CDGH_SAVE);
+	}
+
+	// and back to ABCD and EFGH
+	TMP = _mm_shuffle_epi32(STATE0, 0x1B);
+	STATE1 = _mm_shuffle_epi32(STATE1, 0xB1);
+	STATE0 = _mm_blend_epi16(TMP, STATE1, 0xF0);
+	STATE1 = _mm_alignr_epi8(STATE1, TMP, 8);
+	_mm_storeu_si128((__m128i *)(state+0), STATE0);
+	_mm_storeu_si128((__m128i *)(state+4), STATE1);
+}
+
+#undef SHA256_SHA_ROUNDS
+
+#endif	// CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE
+
+#if defined(CRYPTOPP_X86_ASM_AVAILABLE) || defined(CRYPTOPP_X32_ASM_AVAILABLE) || defined(CRYPTOPP_X64_MASM_AVAILABLE) || CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE
 
 size_t SHA256::HashMultipleBlocks(const word32 *input, size_t length)
 {
+#if CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE
+	if (HasSHA())
+	{
+		SHA256_SSE_SHA_HashBlocks(m_state, input, length&(size_t(0)-BLOCKSIZE), true);
+		return length % BLOCKSIZE;
+	}
+#endif
+#if defined(CRYPTOPP_X86_ASM_AVAILABLE) || defined(CRYPTOPP_X32_ASM_AVAILABLE) || defined(CRYPTOPP_X64_MASM_AVAILABLE)
 	X86_SHA256_HashBlocks(m_state, input, (length&(size_t(0)-BLOCKSIZE)) - !HasSSE2());
 	return length % BLOCKSIZE;
+#else
+	return IteratedHashWithStaticTransform<word32, BigEndian, 64, 32, SHA256, 32, true>::HashMultipleBlocks(input, length);
+#endif
 }
 
 size_t SHA224::HashMultipleBlocks(const word32 *input, size_t length)
 {
+#if CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE
+	if (HasSHA())
+	{
+		SHA256_SSE_SHA_HashBlocks(m_state, input, length&(size_t(0)-BLOCKSIZE), true);
+		return length % BLOCKSIZE;
+	}
+#endif
+#if defined(CRYPTOPP_X86_ASM_AVAILABLE) || defined(CRYPTOPP_X32_ASM_AVAILABLE) || defined(CRYPTOPP_X64_MASM_AVAILABLE)
 	X86_SHA256_HashBlocks(m_state, input, (length&(size_t(0)-BLOCKSIZE)) - !HasSSE2());
 	return length % BLOCKSIZE;
+#else
+	return IteratedHashWithStaticTransform<word32, BigEndian, 64, 32, SHA224, 28, true>::HashMultipleBlocks(input, length);
+#endif
 }
 
 #endif
@@ -502,6 +606,13 @@ size_t SHA224::HashMultipleBlocks(const word32 *input, size_t length)
 
 void SHA256::Transform(word32 *state, const word32 *data)
 {
+#if CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE
+	if (HasSHA())
+	{
+		SHA256_SSE_SHA_HashBlocks(state, data, BLOCKSIZE, false);
+		return;
+	}
+#endif
 	word32 W[16];
 #if defined(CRYPTOPP_X86_ASM_AVAILABLE) || defined(CRYPTOPP_X32_ASM_AVAILABLE) || defined(CRYPTOPP_X64_MASM_AVAILABLE)
 	// this byte reverse is a waste of time, but this function is only called by MDC
@@ -0,0 +1,185 @@
+#include <stdlib.h>
+
+#include "crypto_sign.h"
+
+#include "sha512.h"
+
+#include "ge25519.h"
+
+/* signatures per multi-scalar multiplication: the bucket method's cost per
+ * point keeps falling well past a few hundred points */
+#define MAXBATCH 512
+
+/* return 1 if the y coordinate encoded in p is below 2^255-19, 0 otherwise */
+static int y_is_canonical(const unsigned char p[32])
+{
+  int i;
+  if((p[31] & 127) != 127) return 1;
+  for(i=30;i>0;i--)
+    if(p[i] != 255) return 1;
+  return p[0] < 237;
+}
+
+/* one signature of a chunk, sorted by the key it is checked against */
+typedef struct
+{
+  const void *key; /* ppk[i] if there is one, else pk[i] */
+  unsigned long long i;
+} batchitem;
+
+static int cmp_batchitem(const void *a, const void *b)
+{
+  const batchitem *x = a, *y = b;
+  if(x->key != y->key) return (const char *)x->key < (const char *)y->key ? -1 : 1;
+  return x->i < y->i ? -1 : x->i > y->i;
+}
+
+static int open_one(unsigned char *scratch,
+    const unsigned char *sm, unsigned long long smlen,
+    const unsigned char *pk, const crypto_sign_prepared_publickey *ppk)
+{
+  unsigned long long mlen;
+  if(ppk) return crypto_sign_open_prepared(scratch, &mlen, sm, smlen, ppk) == 0;
+  return crypto_sign_open(scratch, &mlen, sm, smlen, pk) == 0;
+}
+
+/* Checks the signed messages sm[start...start+n-1] with the single equation
+ * [sum z_i*S_i]B - sum [z_i]R_i - sum_A [sum_{i: A_i=A} z_i*H(R_i,A_i,M_i)]A = 0
+ * for 128-bit z_i taken from SHA512(seed,i). Each distinct key A enters
+ * the equation once, decoded once. If it does not hold, each message is
+ * checked on its own. */
+static void open_chunk(int *valid, unsigned char *scratch,
+    ge25519 *points, sc25519 *scalars, batchitem *items,
+    const unsigned char *const sm[], const unsigned long long smlen[],
+    const unsigned char *const pk[], const crypto_sign_prepared_publickey *const ppk[],
+    unsigned long long start, unsigned long long n,
+    const unsigned char seed[32])
+{
+  unsigned char zbytes[64];
+  unsigned char zin[40];
+  unsigned char hram[crypto_hash_sha512_BYTES];
+  const unsigned char *pkbytes;
+  unsigned long long i, j, k, ngood = 0, nitems = 0, npoints = 1;
+  shortsc25519 z;
+  sc25519 scs, schram, t;
+  ge25519 sum, *keypoint = 0;
+  sc25519 *keyscalar = 0;
+  int keyok = 0;
+
+  points[0] = ge25519_base;
+  for(j=0;j<32;j++) scalars[0].v[j] = 0;
+
+  for(i=start;i<start+n;i++)
+  {
+    valid[i] = 0;
+    if(!ppk[i] && !pk[i]) continue;
+    items[nitems].key = ppk[i] ? (const void *)ppk[i] : (const void *)pk[i];
+    items[nitems].i = i;
+    nitems++;
+  }
+  qsort(items, nitems, sizeof(items[0]), cmp_batchitem);
+
+  for(k=0;k<nitems;k++)
+  {
+    i = items[k].i;
+    if(k == 0 || items[k].key != items[k-1].key)
+    {
+      /* the first signature under a new key: give the key its own point */
+      keypoint = &points[npoints];
+      keyscalar = &scalars[npoints];
+      if(ppk[i])
+      {
+        *keypoint = ppk[i]->negpk;
+        keyok = 1;
+      }
+      else
+        keyok = ge25519_unpackneg_vartime(keypoint, pk[i]) == 0;
+      if(!keyok) continue;
+      for(j=0;j<32;j++) keyscalar->v[j] = 0;
+      npoints++;
+    }
+    if(!keyok) continue;
+
+    /* the single check packs its own R, so it rejects any R that is not
+     * in canonical form */
+    if(!y_is_canonical(sm[i]) ||
+       ge25519_unpackneg_vartime(&points[npoints], sm[i]) ||
+       (fe25519_iszero(&points[npoints].x) && (sm[i][31] >> 7)))
+      continue;
+
+    for(j=0;j<32;j++) zin[j] = seed[j];
+    for(j=0;j<8;j++) zin[32+j] = (i >> (8*j)) & 255;
+    crypto_hash_sha512(zbytes, zin, 40);
+    shortsc25519_from16bytes(&z, zbytes);
+
+    pkbytes = ppk[i] ? ppk[i]->pk : pk[i];
+    for(j=0;j<32;j++)              scratch[j] = sm[i][j];
+    for(j=32;j<64;j++)             scratch[j] = pkbytes[j-32];
+    for(j=64;j<smlen[i];j++)       scratch[j] = sm[i][j];
+    crypto_hash_sha512(hram, scratch, smlen[i]);
+    sc25519_from64bytes(&schram, hram);
+    sc25519_from32bytes(&scs, sm[i]+32);
+
+    sc25519_from_shortsc(&scalars[npoints], &z);
+    sc25519_mul_shortsc(&t, &schram, &z);
+    sc25519_add(keyscalar, keyscalar, &t);
+    sc25519_mul_shortsc(&t, &scs, &z);
+    sc25519_add(&scalars[0], &scalars[0], &t);
+    npoints++;
+    valid[i] = 1; /* so far: R decoded, and the key too */
+    ngood++;
+  }
+
+  if(ngood > 1 &&
+     ge25519_multi_scalarmult_vartime(&sum, points, scalars, npoints) == 0 &&
+     ge25519_isneutral_vartime(&sum))
+    return;
+
+  for(k=0;k<nitems;k++)
+  {
+    i = items[k].i;
+    if(valid[i])
+      valid[i] = open_one(scratch, sm[i], smlen[i], pk[i], ppk[i]);
+  }
+}
+
+int crypto_sign_open_batch(
+    int *valid, unsigned char *scratch,
+    const unsigned char *const sm[], const unsigned long long smlen[],
+    const unsigned char *const pk[], const crypto_sign_prepared_publickey *const ppk[],
+    unsigned long long num,
+    const unsigned char seed[32]
+    )
+{
+  unsigned long long i, n, chunk;
+  ge25519 *points;
+  sc25519 *scalars;
+  batchitem *items;
+  int ret = 0;
+
+  /* at most a key and an R per signature, plus the base point */
+  chunk = num < MAXBATCH ? num : MAXBATCH;
+  points = malloc((1+2*chunk) * sizeof(ge25519));
+  scalars = malloc((1+2*chunk) * sizeof(sc25519));
+  items = malloc((chunk ? chunk : 1) * sizeof(batchitem));
+  if(!points || !scalars || !items)
+  {
+    for(i=0;i<num;i++)
+      valid[i] = (ppk[i] || pk[i]) && open_one(scratch, sm[i], smlen[i], pk[i], ppk[i]);
+  }
+  else
+  {
+    for(i=0;i<num;i+=n)
+    {
+      n = num-i < MAXBATCH ? num-i : MAXBATCH;
+      open_chunk(valid, scratch, points, scalars, items, sm, smlen, pk, ppk, i, n, seed);
+    }
+  }
+  free(items);
+  free(scalars);
+  free(points);
+
+  for(i=0;i<num;i++)
+    if(!valid[i]) ret = -1;
+  return ret;
+}
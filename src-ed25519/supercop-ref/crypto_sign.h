@@ -5,9 +5,33 @@
 #define PUBLICKEYBYTES 32
 #define SIGNATUREBYTES 64
 
+#include "ge25519.h"
+
+/* A public key decoded once, for checking many signatures against it */
+typedef struct
+{
+  unsigned char pk[PUBLICKEYBYTES];
+  ge25519 negpk;
+  ge25519_prepared table;
+  int hastable;
+} crypto_sign_prepared_publickey;
+
 extern int crypto_sign(unsigned char *,unsigned long long *,const unsigned char *,unsigned long long,const unsigned char *);
 extern int crypto_sign_open(unsigned char *,unsigned long long *,const unsigned char *,unsigned long long,const unsigned char *);
 extern int crypto_sign_keypair(unsigned char *,unsigned char *);
 extern int crypto_sign_publickey(unsigned char *pk, unsigned char *sk, unsigned char *seed);
+/* Returns -1 if pk does not encode a curve point. With table set, also
+   builds the per-key window table that crypto_sign_open_prepared uses. */
+extern int crypto_sign_prepare_publickey(crypto_sign_prepared_publickey *ppk, const unsigned char *pk, int table);
+extern int crypto_sign_open_prepared(unsigned char *m, unsigned long long *mlen, const unsigned char *sm, unsigned long long smlen, const crypto_sign_prepared_publickey *ppk);
+/* Check num signed messages at once, setting valid[i] to 1 or 0 for each
+   one. sm[i] is checked against the prepared key ppk[i] or, where that is
+   NULL, the 32 bytes at pk[i]; if both are NULL it is invalid. Messages
+   that share a ppk[i] (or, without one, a pk[i] pointer) are checked
+   against their key together, and the key is decoded at most once per
+   chunk. scratch must hold the longest sm[i], and every smlen[i] must be at
+   least SIGNATUREBYTES. seed is 32 secret random bytes, fresh for each call.
+   Returns 0 if every signature is valid, -1 otherwise. */
+extern int crypto_sign_open_batch(int *valid, unsigned char *scratch, const unsigned char *const sm[], const unsigned long long smlen[], const unsigned char *const pk[], const crypto_sign_prepared_publickey *const ppk[], unsigned long long num, const unsigned char seed[32]);
 
 #endif
@@ -95,27 +95,29 @@ int crypto_sign(
   return 0;
 }
 
-int crypto_sign_open(
+/* the rest of crypto_sign_open, once pk has been decoded into -A */
+static int open_unpacked(
     unsigned char *m,unsigned long long *mlen,
     const unsigned char *sm,unsigned long long smlen,
-    const unsigned char *pk
+    const unsigned char *pk, const ge25519 *get1, const ge25519_prepared *table
     )
 {
   int i, ret;
   unsigned char t2[32];
-  ge25519 get1, get2;
+  ge25519 get2;
   sc25519 schram, scs;
   unsigned char hram[crypto_hash_sha512_BYTES];
 
-  if (ge25519_unpackneg_vartime(&get1, pk)) return -1;
-
   get_hram(hram,sm,pk,m,smlen);
 
   sc25519_from64bytes(&schram, hram);
 
   sc25519_from32bytes(&scs, sm+32);
 
-  ge25519_double_scalarmult_vartime(&get2, &get1, &schram, &ge25519_base, &scs);
+  if (table)
+    ge25519_double_scalarmult_prepared_vartime(&get2, table, &schram, &scs);
+  else
+    ge25519_double_scalarmult_vartime(&get2, get1, &schram, &ge25519_base, &scs);
   ge25519_pack(t2, &get2);
 
   ret = crypto_verify_32(sm, t2);
@@ -134,3 +136,42 @@ int crypto_sign_open(
   }
   return ret;
 }
+
+int crypto_sign_open(
+    unsigned char *m,unsigned long long *mlen,
+    const unsigned char *sm,unsigned long long smlen,
+    const unsigned char *pk
+    )
+{
+  ge25519 get1;
+
+  if (ge25519_unpackneg_vartime(&get1, pk)) return -1;
+
+  return open_unpacked(m, mlen, sm, smlen, pk, &get1, 0);
+}
+
+int crypto_sign_prepare_publickey(
+    crypto_sign_prepared_publickey *ppk,
+    const unsigned char *pk,
+    int table
+    )
+{
+  int i;
+  for(i=0;i<32;i++)
+    ppk->pk[i] = pk[i];
+  if (ge25519_unpackneg_vartime(&ppk->negpk, pk)) return -1;
+  ppk->hastable = table;
+  if (table)
+    ge25519_prepare_vartime(&ppk->table, &ppk->negpk);
+  return 0;
+}
+
+int crypto_sign_open_prepared(
+    unsigned char *m,unsigned long long *mlen,
+    const unsigned char *sm,unsigned long long smlen,
+    const crypto_sign_prepared_publickey *ppk
+    )
+{
+  return open_unpacked(m, mlen, sm, smlen, ppk->pk, &ppk->negpk,
+                       ppk->hastable ? &ppk->table : 0);
+}
@@ -3,6 +3,10 @@
 
 #include "fe25519.h"
 
+/* With ED25519_RADIX51 the representation-specific functions come from
+ * fe25519_51.c instead; the exponentiation chains at the end are shared. */
+#ifndef ED25519_RADIX51
+
 static crypto_uint32 equal(crypto_uint32 a,crypto_uint32 b) /* 16-bit inputs */
 {
   crypto_uint32 x = a ^ b; /* 0: yes; 1..65535: no */
@@ -204,6 +208,8 @@ void fe25519_square(fe25519 *r, const fe25519 *x)
   fe25519_mul(r, x, x);
 }
 
+#endif
+
 void fe25519_invert(fe25519 *r, const fe25519 *x)
 {
 	fe25519 z2;
@@ -3,6 +3,7 @@
 
 #include "crypto_int32.h"
 #include "crypto_uint32.h"
+#include "crypto_uint64.h"
 
 #define fe25519              crypto_sign_ed25519_ref_fe25519
 #define fe25519_freeze       crypto_sign_ed25519_ref_fe25519_freeze
@@ -22,11 +23,20 @@
 #define fe25519_invert       crypto_sign_ed25519_ref_fe25519_invert
 #define fe25519_pow2523      crypto_sign_ed25519_ref_fe25519_pow2523
 
+#ifdef ED25519_RADIX51
+/* v[0] + v[1]*2^51 + ... + v[4]*2^204, see fe25519_51.c */
+typedef struct 
+{
+  crypto_uint64 v[5]; 
+}
+fe25519;
+#else
 typedef struct 
 {
   crypto_uint32 v[32]; 
 }
 fe25519;
+#endif
 
 void fe25519_freeze(fe25519 *r);
 
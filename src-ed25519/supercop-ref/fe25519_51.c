@@ -0,0 +1,198 @@
+/* Arithmetic modulo 2^255-19 on five 51-bit limbs, with 128-bit products.
+ * Selected instead of the byte-limb code in fe25519.c by defining
+ * ED25519_RADIX51 (see setup.py). Every function leaves its result with
+ * limbs below 2^52, which is all that fe25519_mul and fe25519_sub need
+ * of their inputs. fe25519_invert and fe25519_pow2523 are shared with the
+ * byte-limb code, in fe25519.c.
+ */
+
+#ifdef ED25519_RADIX51
+
+#include "fe25519.h"
+
+typedef unsigned __int128 crypto_uint128;
+
+#define MASK51 ((((crypto_uint64) 1) << 51) - 1)
+
+/* carry each limb into the next, and the top one back into the bottom */
+static void carry(fe25519 *r)
+{
+  crypto_uint64 c;
+  c = r->v[0] >> 51; r->v[0] &= MASK51; r->v[1] += c;
+  c = r->v[1] >> 51; r->v[1] &= MASK51; r->v[2] += c;
+  c = r->v[2] >> 51; r->v[2] &= MASK51; r->v[3] += c;
+  c = r->v[3] >> 51; r->v[3] &= MASK51; r->v[4] += c;
+  c = r->v[4] >> 51; r->v[4] &= MASK51; r->v[0] += 19*c;
+}
+
+/* reduction modulo 2^255-19 */
+void fe25519_freeze(fe25519 *r)
+{
+  crypto_uint64 q;
+  carry(r);
+  carry(r);
+  /* now r < 2^255 + 19, so r >= p exactly when r + 19 >= 2^255 */
+  q = (r->v[0] + 19) >> 51;
+  q = (r->v[1] + q) >> 51;
+  q = (r->v[2] + q) >> 51;
+  q = (r->v[3] + q) >> 51;
+  q = (r->v[4] + q) >> 51;
+  /* r - q*p = r + 19*q - q*2^255: carry without wrapping, drop bit 255 */
+  r->v[0] += 19*q;
+  r->v[1] += r->v[0] >> 51; r->v[0] &= MASK51;
+  r->v[2] += r->v[1] >> 51; r->v[1] &= MASK51;
+  r->v[3] += r->v[2] >> 51; r->v[2] &= MASK51;
+  r->v[4] += r->v[3] >> 51; r->v[3] &= MASK51;
+  r->v[4] &= MASK51;
+}
+
+void fe25519_unpack(fe25519 *r, const unsigned char x[32])
+{
+  crypto_uint64 w[4];
+  int i, j;
+  for(i=0;i<4;i++)
+  {
+    w[i] = 0;
+    for(j=7;j>=0;j--)
+      w[i] = (w[i] << 8) | x[8*i+j];
+  }
+  r->v[0] =  w[0]                       & MASK51;
+  r->v[1] = ((w[0] >> 51) | (w[1] << 13)) & MASK51;
+  r->v[2] = ((w[1] >> 38) | (w[2] << 26)) & MASK51;
+  r->v[3] = ((w[2] >> 25) | (w[3] << 39)) & MASK51;
+  r->v[4] =  (w[3] >> 12)                 & MASK51;
+}
+
+/* Assumes input x being reduced below 2^255 */
+void fe25519_pack(unsigned char r[32], const fe25519 *x)
+{
+  crypto_uint64 w[4];
+  int i, j;
+  fe25519 y = *x;
+  fe25519_freeze(&y);
+  w[0] =  y.v[0]        | (y.v[1] << 51);
+  w[1] = (y.v[1] >> 13) | (y.v[2] << 38);
+  w[2] = (y.v[2] >> 26) | (y.v[3] << 25);
+  w[3] = (y.v[3] >> 39) | (y.v[4] << 12);
+  for(i=0;i<4;i++)
+    for(j=0;j<8;j++)
+      r[8*i+j] = (w[i] >> (8*j)) & 255;
+}
+
+int fe25519_iszero(const fe25519 *x)
+{
+  crypto_uint64 t;
+  fe25519 y = *x;
+  fe25519_freeze(&y);
+  t = y.v[0] | y.v[1] | y.v[2] | y.v[3] | y.v[4];
+  return (int)((t - 1) >> 63);
+}
+
+int fe25519_iseq_vartime(const fe25519 *x, const fe25519 *y)
+{
+  int i;
+  fe25519 t1 = *x;
+  fe25519 t2 = *y;
+  fe25519_freeze(&t1);
+  fe25519_freeze(&t2);
+  for(i=0;i<5;i++)
+    if(t1.v[i] != t2.v[i]) return 0;
+  return 1;
+}
+
+void fe25519_cmov(fe25519 *r, const fe25519 *x, unsigned char b)
+{
+  int i;
+  crypto_uint64 mask = b;
+  mask = -mask;
+  for(i=0;i<5;i++) r->v[i] ^= mask & (x->v[i] ^ r->v[i]);
+}
+
+unsigned char fe25519_getparity(const fe25519 *x)
+{
+  fe25519 t = *x;
+  fe25519_freeze(&t);
+  return t.v[0] & 1;
+}
+
+void fe25519_setone(fe25519 *r)
+{
+  int i;
+  r->v[0] = 1;
+  for(i=1;i<5;i++) r->v[i]=0;
+}
+
+void fe25519_setzero(fe25519 *r)
+{
+  int i;
+  for(i=0;i<5;i++) r->v[i]=0;
+}
+
+void fe25519_neg(fe25519 *r, const fe25519 *x)
+{
+  fe25519 t = *x;
+  fe25519_setzero(r);
+  fe25519_sub(r, r, &t);
+}
+
+void fe25519_add(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  int i;
+  for(i=0;i<5;i++) r->v[i] = x->v[i] + y->v[i];
+  carry(r);
+}
+
+void fe25519_sub(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  /* add 4*p, whose limbs are all above 2^52, before subtracting */
+  r->v[0] = (x->v[0] + 0x1FFFFFFFFFFFB4) - y->v[0];
+  r->v[1] = (x->v[1] + 0x1FFFFFFFFFFFFC) - y->v[1];
+  r->v[2] = (x->v[2] + 0x1FFFFFFFFFFFFC) - y->v[2];
+  r->v[3] = (x->v[3] + 0x1FFFFFFFFFFFFC) - y->v[3];
+  r->v[4] = (x->v[4] + 0x1FFFFFFFFFFFFC) - y->v[4];
+  carry(r);
+}
+
+/* fold the 128-bit column sums t[] back into 51-bit limbs */
+static void reduce_mul(fe25519 *r, crypto_uint128 t[5])
+{
+  crypto_uint64 c;
+  t[1] += (crypto_uint64)(t[0] >> 51); r->v[0] = (crypto_uint64)t[0] & MASK51;
+  t[2] += (crypto_uint64)(t[1] >> 51); r->v[1] = (crypto_uint64)t[1] & MASK51;
+  t[3] += (crypto_uint64)(t[2] >> 51); r->v[2] = (crypto_uint64)t[2] & MASK51;
+  t[4] += (crypto_uint64)(t[3] >> 51); r->v[3] = (crypto_uint64)t[3] & MASK51;
+  c = (crypto_uint64)(t[4] >> 51);     r->v[4] = (crypto_uint64)t[4] & MASK51;
+  r->v[0] += 19*c;
+  c = r->v[0] >> 51; r->v[0] &= MASK51; r->v[1] += c;
+}
+
+void fe25519_mul(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  crypto_uint128 t[5];
+  const crypto_uint64 *a = x->v, *b = y->v;
+  crypto_uint64 b1_19 = 19*b[1], b2_19 = 19*b[2], b3_19 = 19*b[3], b4_19 = 19*b[4];
+
+  t[0] = (crypto_uint128)a[0]*b[0] + (crypto_uint128)a[1]*b4_19 + (crypto_uint128)a[2]*b3_19 + (crypto_uint128)a[3]*b2_19 + (crypto_uint128)a[4]*b1_19;
+  t[1] = (crypto_uint128)a[0]*b[1] + (crypto_uint128)a[1]*b[0]  + (crypto_uint128)a[2]*b4_19 + (crypto_uint128)a[3]*b3_19 + (crypto_uint128)a[4]*b2_19;
+  t[2] = (crypto_uint128)a[0]*b[2] + (crypto_uint128)a[1]*b[1]  + (crypto_uint128)a[2]*b[0]  + (crypto_uint128)a[3]*b4_19 + (crypto_uint128)a[4]*b3_19;
+  t[3] = (crypto_uint128)a[0]*b[3] + (crypto_uint128)a[1]*b[2]  + (crypto_uint128)a[2]*b[1]  + (crypto_uint128)a[3]*b[0]  + (crypto_uint128)a[4]*b4_19;
+  t[4] = (crypto_uint128)a[0]*b[4] + (crypto_uint128)a[1]*b[3]  + (crypto_uint128)a[2]*b[2]  + (crypto_uint128)a[3]*b[1]  + (crypto_uint128)a[4]*b[0];
+  reduce_mul(r, t);
+}
+
+void fe25519_square(fe25519 *r, const fe25519 *x)
+{
+  crypto_uint128 t[5];
+  const crypto_uint64 *a = x->v;
+  crypto_uint64 a0_2 = 2*a[0], a1_2 = 2*a[1];
+  crypto_uint64 a3_19 = 19*a[3], a4_19 = 19*a[4];
+
+  t[0] = (crypto_uint128)a[0]*a[0] + (crypto_uint128)a1_2*a4_19 + (crypto_uint128)(2*a[2])*a3_19;
+  t[1] = (crypto_uint128)a0_2*a[1] + (crypto_uint128)(2*a[2])*a4_19 + (crypto_uint128)a[3]*a3_19;
+  t[2] = (crypto_uint128)a0_2*a[2] + (crypto_uint128)a[1]*a[1] + (crypto_uint128)(2*a[3])*a4_19;
+  t[3] = (crypto_uint128)a0_2*a[3] + (crypto_uint128)a1_2*a[2] + (crypto_uint128)a[4]*a4_19;
+  t[4] = (crypto_uint128)a0_2*a[4] + (crypto_uint128)a1_2*a[3] + (crypto_uint128)a[2]*a[2];
+  reduce_mul(r, t);
+}
+
+#endif
@@ -1,3 +1,5 @@
+#include <stdlib.h>
+
 #include "fe25519.h"
 #include "sc25519.h"
 #include "ge25519.h"
@@ -8,6 +10,14 @@
  * Base point: (15112221349535400772501151409588531511454012693041857206046113283949847762202,46316835694926478169428394003475163141307993866256225615783033603165251855960);
  */
 
+#ifdef ED25519_RADIX51
+/* d */
+static const fe25519 ge25519_ecd = {{0x34dca135978a3, 0x1a8283b156ebd, 0x5e7a26001c029, 0x739c663a03cbb, 0x52036cee2b6ff}};
+/* 2*d */
+static const fe25519 ge25519_ec2d = {{0x69b9426b2f159, 0x35050762add7a, 0x3cf44c0038052, 0x6738cc7407977, 0x2406d9dc56dff}};
+/* sqrt(-1) */
+static const fe25519 ge25519_sqrtm1 = {{0x61b274a0ea0b0, 0x0d5a5fc8f189d, 0x7ef5e9cbd0c60, 0x78595a6804c9e, 0x2b8324804fc1d}};
+#else
 /* d */
 static const fe25519 ge25519_ecd = {{0xA3, 0x78, 0x59, 0x13, 0xCA, 0x4D, 0xEB, 0x75, 0xAB, 0xD8, 0x41, 0x41, 0x4D, 0x0A, 0x70, 0x00, 
                       0x98, 0xE8, 0x79, 0x77, 0x79, 0x40, 0xC7, 0x8C, 0x73, 0xFE, 0x6F, 0x2B, 0xEE, 0x6C, 0x03, 0x52}};
@@ -17,6 +27,7 @@ static const fe25519 ge25519_ec2d = {{0x59, 0xF1, 0xB2, 0x26, 0x94, 0x9B, 0xD6,
 /* sqrt(-1) */
 static const fe25519 ge25519_sqrtm1 = {{0xB0, 0xA0, 0x0E, 0x4A, 0x27, 0x1B, 0xEE, 0xC4, 0x78, 0xE4, 0x2F, 0xAD, 0x06, 0x18, 0x43, 0x2F, 
                          0xA7, 0xD7, 0xFB, 0x3D, 0x99, 0x00, 0x4D, 0x2B, 0x0B, 0xDF, 0xC1, 0x4F, 0x80, 0x24, 0x83, 0x2B}};
+#endif
 
 #define ge25519_p3 ge25519
 
@@ -42,6 +53,23 @@ typedef struct
 } ge25519_aff;
 
 
+#ifdef ED25519_RADIX51
+/* Packed coordinates of the base point */
+const ge25519 ge25519_base = {{{0x62d608f25d51a, 0x412a4b4f6592a, 0x75b7171a4b31d, 0x1ff60527118fe, 0x216936d3cd6e5}},
+                              {{0x6666666666658, 0x4cccccccccccc, 0x1999999999999, 0x3333333333333, 0x6666666666666}},
+                              {{0x0000000000001, 0x0000000000000, 0x0000000000000, 0x0000000000000, 0x0000000000000}},
+                              {{0x68ab3a5b7dda3, 0x00eea2a5eadbb, 0x2af8df483c27e, 0x332b375274732, 0x67875f0fd78b7}}};
+
+/* Multiples of the base point in affine representation */
+static const ge25519_aff ge25519_base_multiples_affine[425] = {
+#include "ge25519_base_51.data"
+};
+
+/* B, 3B, 5B, ..., 63B in affine representation */
+static const ge25519_aff ge25519_base_slide_multiples[32] = {
+#include "ge25519_base_slide_51.data"
+};
+#else
 /* Packed coordinates of the base point */
 const ge25519 ge25519_base = {{{0x1A, 0xD5, 0x25, 0x8F, 0x60, 0x2D, 0x56, 0xC9, 0xB2, 0xA7, 0x25, 0x95, 0x60, 0xC7, 0x2C, 0x69, 
                                 0x5C, 0xDC, 0xD6, 0xFD, 0x31, 0xE2, 0xA4, 0xC0, 0xFE, 0x53, 0x6E, 0xCD, 0xD3, 0x36, 0x69, 0x21}},
@@ -57,6 +85,12 @@ static const ge25519_aff ge25519_base_multiples_affine[425] = {
 #include "ge25519_base.data"
 };
 
+/* B, 3B, 5B, ..., 63B in affine representation */
+static const ge25519_aff ge25519_base_slide_multiples[32] = {
+#include "ge25519_base_slide.data"
+};
+#endif
+
 static void p1p1_to_p2(ge25519_p2 *r, const ge25519_p1p1 *p)
 {
   fe25519_mul(&r->x, &p->x, &p->t);
@@ -293,6 +327,183 @@ void ge25519_double_scalarmult_vartime(ge25519_p3 *r, const ge25519_p3 *p1, cons
   }
 }
 
+/* r = r + q */
+static void add_p3(ge25519_p3 *r, const ge25519_p3 *q)
+{
+  ge25519_p1p1 t;
+  add_p1p1(&t, r, q);
+  p1p1_to_p3(r, &t);
+}
+
+/* r = r + q if b > 0, r = r - q if b < 0 */
+static void addsigned_p3(ge25519_p3 *r, const ge25519_p3 *q, signed char b)
+{
+  ge25519_p3 nq;
+  if(b > 0)
+    add_p3(r, q);
+  else
+  {
+    fe25519_neg(&nq.x, &q->x);
+    nq.y = q->y;
+    nq.z = q->z;
+    fe25519_neg(&nq.t, &q->t);
+    add_p3(r, &nq);
+  }
+}
+
+/* Pippenger's bucket method with signed c-bit digits: each window costs
+ * about npoints + 2^c additions, so pick the c that minimizes the total */
+static int multi_scalarmult_window(unsigned long long npoints)
+{
+  unsigned long long cost, best = 0;
+  int c, bestc = 2;
+  for(c=2;c<=8;c++)
+  {
+    cost = ((255+c-1)/c) * (npoints + (1ULL << c));
+    if(c == 2 || cost < best) { best = cost; bestc = c; }
+  }
+  return bestc;
+}
+
+int ge25519_multi_scalarmult_vartime(ge25519_p3 *r, const ge25519_p3 *p, const sc25519 *s, unsigned long long npoints)
+{
+  ge25519_p1p1 tp1p1;
+  ge25519_p3 *bucket, running, sum;
+  unsigned char *used;
+  signed char *digits;
+  int c, nwin, nbuckets, w, j, k, haverunning, havesum, haver = 0;
+  unsigned long long i;
+
+  c = multi_scalarmult_window(npoints);
+  nwin = (255+c-1)/c;
+  nbuckets = 1 << (c-1);
+
+  bucket = malloc(nbuckets * sizeof(ge25519_p3) + nbuckets + npoints * nwin);
+  if(!bucket) return -1;
+  used = (unsigned char *)(bucket + nbuckets);
+  digits = (signed char *)(used + nbuckets);
+  for(i=0;i<npoints;i++)
+    sc25519_window_signed(digits + i*nwin, c, nwin, &s[i]);
+
+  setneutral(r);
+  for(w=nwin-1;w>=0;w--)
+  {
+    if(haver)
+    {
+      for(k=0;k<c-1;k++)
+      {
+        dbl_p1p1(&tp1p1, (ge25519_p2 *)r);
+        p1p1_to_p2((ge25519_p2 *)r, &tp1p1);
+      }
+      dbl_p1p1(&tp1p1, (ge25519_p2 *)r);
+      p1p1_to_p3(r, &tp1p1);
+    }
+
+    /* sort the points into buckets by digit */
+    for(j=0;j<nbuckets;j++) used[j] = 0;
+    for(i=0;i<npoints;i++)
+    {
+      signed char b = digits[i*nwin+w];
+      j = (b < 0 ? -b : b) - 1;
+      if(j < 0) continue;
+      if(used[j])
+        addsigned_p3(&bucket[j], &p[i], b);
+      else
+      {
+        bucket[j] = p[i];
+        if(b < 0)
+        {
+          fe25519_neg(&bucket[j].x, &bucket[j].x);
+          fe25519_neg(&bucket[j].t, &bucket[j].t);
+        }
+        used[j] = 1;
+      }
+    }
+
+    /* sum_j (j+1)*bucket[j], as a sum of running sums */
+    haverunning = havesum = 0;
+    for(j=nbuckets-1;j>=0;j--)
+    {
+      if(used[j])
+      {
+        if(haverunning) add_p3(&running, &bucket[j]);
+        else { running = bucket[j]; haverunning = 1; }
+      }
+      if(haverunning)
+      {
+        if(havesum) add_p3(&sum, &running);
+        else { sum = running; havesum = 1; }
+      }
+    }
+
+    if(havesum)
+    {
+      if(haver) add_p3(r, &sum);
+      else { *r = sum; haver = 1; }
+    }
+  }
+
+  free(bucket);
+  return 0;
+}
+
+void ge25519_prepare_vartime(ge25519_prepared *r, const ge25519_p3 *p)
+{
+  ge25519_p1p1 tp1p1;
+  ge25519_p3 p2;
+  int i;
+
+  r->odd[0] = *p;
+  dbl_p1p1(&tp1p1, (ge25519_p2 *)p); p1p1_to_p3(&p2, &tp1p1);
+  for(i=1;i<8;i++)
+  {
+    add_p1p1(&tp1p1, &r->odd[i-1], &p2);
+    p1p1_to_p3(&r->odd[i], &tp1p1);
+  }
+}
+
+/* computes [s1]p1 + [s2]base, with width-5 and width-7 sliding windows */
+void ge25519_double_scalarmult_prepared_vartime(ge25519_p3 *r, const ge25519_prepared *p1, const sc25519 *s1, const sc25519 *s2)
+{
+  ge25519_p1p1 tp1p1;
+  ge25519_aff q;
+  signed char slide1[256], slide2[256];
+  int i;
+
+  sc25519_slide(slide1, s1, 5);
+  sc25519_slide(slide2, s2, 7);
+
+  setneutral(r);
+  for(i=255;i>=0;i--)
+    if(slide1[i] || slide2[i]) break;
+
+  for(;i>=0;i--)
+  {
+    dbl_p1p1(&tp1p1, (ge25519_p2 *)r);
+    if(slide1[i] || slide2[i] || i == 0)
+      p1p1_to_p3(r, &tp1p1);
+    else
+    {
+      p1p1_to_p2((ge25519_p2 *)r, &tp1p1);
+      continue;
+    }
+
+    if(slide1[i] > 0)
+      add_p3(r, &p1->odd[slide1[i]/2]);
+    else if(slide1[i] < 0)
+      addsigned_p3(r, &p1->odd[(-slide1[i])/2], -1);
+
+    if(slide2[i] > 0)
+      ge25519_mixadd2(r, &ge25519_base_slide_multiples[slide2[i]/2]);
+    else if(slide2[i] < 0)
+    {
+      q = ge25519_base_slide_multiples[(-slide2[i])/2];
+      fe25519_neg(&q.x, &q.x);
+      ge25519_mixadd2(r, &q);
+    }
+  }
+}
+
 void ge25519_scalarmult_base(ge25519_p3 *r, const sc25519 *s)
 {
   signed char b[85];
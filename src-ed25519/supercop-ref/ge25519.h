@@ -10,6 +10,10 @@
 #define ge25519_pack                      crypto_sign_ed25519_ref_pack
 #define ge25519_isneutral_vartime         crypto_sign_ed25519_ref_isneutral_vartime
 #define ge25519_double_scalarmult_vartime crypto_sign_ed25519_ref_double_scalarmult_vartime
+#define ge25519_multi_scalarmult_vartime  crypto_sign_ed25519_ref_multi_scalarmult_vartime
+#define ge25519_prepared                  crypto_sign_ed25519_ref_ge25519_prepared
+#define ge25519_prepare_vartime           crypto_sign_ed25519_ref_prepare_vartime
+#define ge25519_double_scalarmult_prepared_vartime crypto_sign_ed25519_ref_double_scalarmult_prepared_vartime
 #define ge25519_scalarmult_base           crypto_sign_ed25519_ref_scalarmult_base
 
 typedef struct
@@ -20,6 +24,12 @@ typedef struct
   fe25519 t;
 } ge25519;
 
+/* P, 3P, 5P, ..., 15P: enough for a width-5 sliding window over P */
+typedef struct
+{
+  ge25519 odd[8];
+} ge25519_prepared;
+
 extern const ge25519 ge25519_base;
 
 int ge25519_unpackneg_vartime(ge25519 *r, const unsigned char p[32]);
@@ -30,6 +40,15 @@ int ge25519_isneutral_vartime(const ge25519 *p);
 
 void ge25519_double_scalarmult_vartime(ge25519 *r, const ge25519 *p1, const sc25519 *s1, const ge25519 *p2, const sc25519 *s2);
 
+/* computes [s[0]]p[0] + ... + [s[npoints-1]]p[npoints-1];
+ * return 0 on success, -1 if out of memory */
+int ge25519_multi_scalarmult_vartime(ge25519 *r, const ge25519 *p, const sc25519 *s, unsigned long long npoints);
+
+void ge25519_prepare_vartime(ge25519_prepared *r, const ge25519 *p);
+
+/* computes [s1]p1 + [s2]base, with p1 prepared beforehand */
+void ge25519_double_scalarmult_prepared_vartime(ge25519 *r, const ge25519_prepared *p1, const sc25519 *s1, const sc25519 *s2);
+
 void ge25519_scalarmult_base(ge25519 *r, const sc25519 *s);
 
 #endif
@@ -296,3 +296,56 @@ void sc25519_2interleave2(unsigned char r[127], const sc25519 *s1, const sc25519
   r[125] = ((s1->v[31] >> 2) & 3) ^ (((s2->v[31] >> 2) & 3) << 2);
   r[126] = ((s1->v[31] >> 4) & 3) ^ (((s2->v[31] >> 4) & 3) << 2);
 }
+
+void sc25519_window_signed(signed char *r, int c, int nwin, const sc25519 *s)
+{
+  int i, j, pos, d, carry = 0;
+  for(i=0;i<nwin;i++)
+  {
+    d = 0;
+    for(j=0;j<c;j++)
+    {
+      pos = c*i+j;
+      if(pos < 256) d |= ((s->v[pos >> 3] >> (pos & 7)) & 1) << j;
+    }
+    d += carry;
+    carry = (d + (1 << (c-1))) >> c;
+    r[i] = d - (carry << c);
+  }
+}
+
+void sc25519_slide(signed char r[256], const sc25519 *s, int w)
+{
+  int i, j, k, b, m = (1 << (w-1)) - 1;
+  for(i=0;i<256;i++)
+    r[i] = (s->v[i >> 3] >> (i & 7)) & 1;
+
+  for(j=0;j<256;j++)
+  {
+    if(!r[j]) continue;
+    for(b=1;b<w && j+b<256;b++)
+    {
+      if(!r[j+b]) continue;
+      if(r[j] + (r[j+b] << b) <= m)
+      {
+        r[j] += r[j+b] << b;
+        r[j+b] = 0;
+      }
+      else if(r[j] - (r[j+b] << b) >= -m)
+      {
+        r[j] -= r[j+b] << b;
+        for(k=j+b;k<256;k++)
+        {
+          if(!r[k])
+          {
+            r[k] = 1;
+            break;
+          }
+          r[k] = 0;
+        }
+      }
+      else
+        break;
+    }
+  }
+}
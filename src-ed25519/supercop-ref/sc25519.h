@@ -21,6 +21,8 @@
 #define sc25519_window3          crypto_sign_ed25519_ref_sc25519_window3
 #define sc25519_window5          crypto_sign_ed25519_ref_sc25519_window5
 #define sc25519_2interleave2     crypto_sign_ed25519_ref_sc25519_2interleave2
+#define sc25519_window_signed    crypto_sign_ed25519_ref_sc25519_window_signed
+#define sc25519_slide            crypto_sign_ed25519_ref_sc25519_slide
 
 typedef struct 
 {
@@ -70,4 +72,15 @@ void sc25519_window5(signed char r[51], const sc25519 *s);
 
 void sc25519_2interleave2(unsigned char r[127], const sc25519 *s1, const sc25519 *s2);
 
+/* Convert s into a representation of the form \sum_{i=0}^{nwin-1}r[i]2^(c*i)
+ * with r[i] in {-2^(c-1),...,2^(c-1)-1}, for 2 <= c <= 8 and nwin*c >= 255
+ */
+void sc25519_window_signed(signed char *r, int c, int nwin, const sc25519 *s);
+
+/* Convert s into a sliding-window (width-w NAF) representation
+ * \sum_{i=0}^{255}r[i]2^i with every r[i] zero or odd and in
+ * {-(2^(w-1)-1),...,2^(w-1)-1}, for 2 <= w <= 7
+ */
+void sc25519_slide(signed char r[256], const sc25519 *s, int w);
+
 #endif
@@ -3,9 +3,16 @@
 #include "publickey/ecdsamodule.hpp"
 #include "publickey/rsamodule.hpp"
 #include "hash/sha256module.hpp"
+#include "hash/sha512module.hpp"
+#include "hash/merklemodule.hpp"
+#include "hash/kdfmodule.hpp"
 #include "cipher/aesmodule.hpp"
 #include "cipher/xsalsa20module.hpp"
 #include "cipher/aesgcmmodule.hpp"
+#include "idamodule.hpp"
+#include "cpufeatures.hpp"
+#include "workerpool.hpp"
+#include "threadrng.hpp"
 
 /* from Crypto++ */
 #ifdef DISABLE_EMBEDDED_CRYPTOPP
@@ -24,12 +31,33 @@ from pycryptopp import cipher\n\
 from pycryptopp.cipher import aes\n\
 from pycryptopp.cipher import xsalsa20\n\
 from pycryptopp import hash\n\
-from pycryptopp.hash import sha256");
+from pycryptopp.hash import sha256\n\
+from pycryptopp.hash import sha512\n\
+from pycryptopp.hash import merkle\n\
+from pycryptopp.hash import kdf\n\
+from pycryptopp import ida");
 
 static PyMethodDef _pycryptopp_functions[] = {
+    {"ecdsa_precompute_base", reinterpret_cast<PyCFunction>(ecdsa_precompute_base), METH_KEYWORDS, const_cast<char*>(ecdsa_precompute_base__doc__)},
+    {"ecdsa__test_raw_sign", reinterpret_cast<PyCFunction>(ecdsa__test_raw_sign), METH_KEYWORDS, const_cast<char*>(ecdsa__test_raw_sign__doc__)},
     {"rsa_generate", reinterpret_cast<PyCFunction>(rsa_generate), METH_KEYWORDS, const_cast<char*>(rsa_generate__doc__)},
+    {"rsa__generate_deterministic", reinterpret_cast<PyCFunction>(rsa__generate_deterministic), METH_KEYWORDS, const_cast<char*>(rsa__generate_deterministic__doc__)},
     {"rsa_create_verifying_key_from_string", reinterpret_cast<PyCFunction>(rsa_create_verifying_key_from_string), METH_KEYWORDS, const_cast<char*>(rsa_create_verifying_key_from_string__doc__)},
     {"rsa_create_signing_key_from_string", reinterpret_cast<PyCFunction>(rsa_create_signing_key_from_string), METH_KEYWORDS, const_cast<char*>(rsa_create_signing_key_from_string__doc__)},
+    {"sha256_hash_many", reinterpret_cast<PyCFunction>(sha256_hash_many), METH_KEYWORDS, const_cast<char*>(sha256_hash_many__doc__)},
+    {"sha256__hash_many_with", reinterpret_cast<PyCFunction>(sha256__hash_many_with), METH_KEYWORDS, const_cast<char*>(sha256__hash_many_with__doc__)},
+    {"merkle_tree_hash", reinterpret_cast<PyCFunction>(merkle_tree_hash), METH_KEYWORDS, const_cast<char*>(merkle_tree_hash__doc__)},
+    {"merkle_leaf_hash", merkle_leaf_hash, METH_VARARGS, const_cast<char*>(merkle_leaf_hash__doc__)},
+    {"merkle_pair_hash", merkle_pair_hash, METH_VARARGS, const_cast<char*>(merkle_pair_hash__doc__)},
+    {"merkle_check_proof", merkle_check_proof, METH_VARARGS, const_cast<char*>(merkle_check_proof__doc__)},
+    {"kdf_hkdf", reinterpret_cast<PyCFunction>(kdf_hkdf), METH_KEYWORDS, const_cast<char*>(kdf_hkdf__doc__)},
+    {"kdf_hkdf_extract", reinterpret_cast<PyCFunction>(kdf_hkdf_extract), METH_KEYWORDS, const_cast<char*>(kdf_hkdf_extract__doc__)},
+    {"kdf_hkdf_expand", reinterpret_cast<PyCFunction>(kdf_hkdf_expand), METH_KEYWORDS, const_cast<char*>(kdf_hkdf_expand__doc__)},
+    {"kdf_hkdf_expand_many", reinterpret_cast<PyCFunction>(kdf_hkdf_expand_many), METH_KEYWORDS, const_cast<char*>(kdf_hkdf_expand_many__doc__)},
+    {"kdf_pbkdf2", reinterpret_cast<PyCFunction>(kdf_pbkdf2), METH_KEYWORDS, const_cast<char*>(kdf_pbkdf2__doc__)},
+    {"ida_encode", reinterpret_cast<PyCFunction>(ida_encode), METH_KEYWORDS, const_cast<char*>(ida_encode__doc__)},
+    {"ida_decode", reinterpret_cast<PyCFunction>(ida_decode), METH_KEYWORDS, const_cast<char*>(ida_decode__doc__)},
+    {"cpu_features", cpu_features, METH_NOARGS, const_cast<char*>(cpu_features__doc__)},
     {NULL, NULL, 0, NULL}  /* sentinel */
 };
 
@@ -66,10 +94,17 @@ init_pycryptopp(void) {
         return;
 
 
+    init_workerpool();
+    init_threadrng();
+
     init_ecdsa(module);
     init_rsa(module);
     init_sha256(module);
+    init_sha512(module);
+    init_merkle(module);
+    init_kdf(module);
     init_aes(module);
     init_xsalsa20(module);
     init_aesgcm(module);
+    init_ida(module);
 }
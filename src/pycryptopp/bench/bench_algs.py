@@ -1,9 +1,11 @@
-import bench_sigs, bench_ciphers, bench_hashes
+import bench_sigs, bench_ciphers, bench_hashes, bench_ida, bench_threads
 
 def bench(MAXTIME=10.0):
     bench_sigs.bench(MAXTIME)
     bench_ciphers.bench(MAXTIME)
     bench_hashes.bench(MAXTIME)
+    bench_ida.bench(MAXTIME)
+    bench_threads.bench(MAXTIME)
 
 if __name__ == '__main__':
     bench()
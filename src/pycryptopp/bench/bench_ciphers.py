@@ -1,32 +1,35 @@
-from pycryptopp.cipher import aes, xsalsa20
+from pycryptopp.cipher import aes, aesgcm, xsalsa20
 
 from common import insecurerandstr, rep_bench
 
 UNITS_PER_SECOND = 10**9
 
 class BenchCrypt(object):
-    def __init__(self, klass, keysize):
+    def __init__(self, klass, keysize, **kwargs):
         self.klass = klass
         self.keysize = keysize
+        self.kwargs = kwargs
 
     def __repr__(self):
-        return "<%s-%d>" % (self.klass.__name__, self.keysize*8)
+        extra = "".join([" %s=%s" % kv for kv in sorted(self.kwargs.items())])
+        return "<%s-%d%s>" % (self.klass.__name__, self.keysize*8, extra)
 
     def crypt_init(self, N):
         self.msg = insecurerandstr(N)
         self.key = insecurerandstr(self.keysize)
 
     def crypt(self, N):
-        cryptor = self.klass(self.key)
+        cryptor = self.klass(self.key, **self.kwargs)
         cryptor.process(self.msg)
         
 def bench_ciphers(MAXTIME):
-    for (klass, keysize) in [
-        (aes.AES, 16),
-        (aes.AES, 32),
-        (xsalsa20.XSalsa20, 32),
+    for (klass, keysize, kwargs) in [
+        (aes.AES, 16, {}),
+        (aes.AES, 16, {'parallel_threshold': 1<<20}),
+        (aes.AES, 32, {}),
+        (xsalsa20.XSalsa20, 32, {}),
         ]:
-        ob = BenchCrypt(klass, keysize)
+        ob = BenchCrypt(klass, keysize, **kwargs)
         print ob
         for (legend, size) in [
             ("large (%d B)",  10**7),
@@ -38,8 +41,100 @@ def bench_ciphers(MAXTIME):
     print "nanoseconds per byte crypted"
     print
 
+class BenchAESGCM(object):
+    """ Encrypt many messages of one size under one key, so that the per-key
+    setup is paid once, as it is on a server that keeps its keys around. """
+    def __init__(self, ghash):
+        self.ghash = ghash
+
+    def __repr__(self):
+        return "<AESGCM-128 ghash=%s>" % (aesgcm.AESGCM("k"*16, ghash=self.ghash).ghash,)
+
+    def crypt_init(self, N):
+        self.cryptor = aesgcm.AESGCM(insecurerandstr(16), ghash=self.ghash)
+        self.nonce = insecurerandstr(12)
+        self.msg = insecurerandstr(self.msgsize)
+
+    def crypt(self, N):
+        encrypt = self.cryptor.encrypt
+        for i in xrange(N // self.msgsize):
+            encrypt(self.nonce, "", self.msg)
+
+    def setup(self, N):
+        for i in xrange(N):
+            aesgcm.AESGCM(self.key, ghash=self.ghash)
+
+    def setup_init(self, N):
+        self.key = insecurerandstr(16)
+
+def bench_aesgcm(MAXTIME):
+    from pycryptopp import _pycryptopp
+    modes = ["2k", "64k"]
+    if _pycryptopp.cpu_features()["clmul"]:
+        modes.insert(0, "clmul")
+    for ghash in modes:
+        ob = BenchAESGCM(ghash)
+        print ob
+        for (legend, msgsize) in [
+            ("small (%d B)", 64),
+            ("large (%d B)", 2**20),
+            ]:
+            print legend % msgsize
+            ob.msgsize = msgsize
+            rep_bench(ob.crypt, max(msgsize, 2**20), UNITS_PER_SECOND=UNITS_PER_SECOND, MAXTIME=MAXTIME, MAXREPS=100, initfunc=ob.crypt_init)
+            print
+        print "key setup (nanoseconds per key, both directions)"
+        rep_bench(ob.setup, 100, UNITS_PER_SECOND=UNITS_PER_SECOND, MAXTIME=MAXTIME, MAXREPS=100, initfunc=ob.setup_init)
+        print
+
+    print "nanoseconds per byte crypted"
+    print
+
+class BenchXSalsa20(object):
+    """ Encrypt a stream in pieces of one size, with one keystream kernel. """
+    def __init__(self, kernel):
+        self.kernel = kernel
+
+    def __repr__(self):
+        return "<XSalsa20-256 kernel=%s>" % (self.kernel,)
+
+    def crypt_init(self, N):
+        self.cryptor = xsalsa20.XSalsa20(insecurerandstr(32), insecurerandstr(24), kernel=self.kernel)
+        self.msg = insecurerandstr(self.msgsize)
+
+    def crypt(self, N):
+        process = self.cryptor.process
+        for i in xrange(N // self.msgsize):
+            process(self.msg)
+
+def bench_xsalsa20(MAXTIME):
+    kernels = []
+    for kernel in ["avx2", "sse2", "serial"]:
+        try:
+            xsalsa20.XSalsa20("k"*32, kernel=kernel)
+        except xsalsa20.Error:
+            continue
+        kernels.append(kernel)
+    for kernel in kernels:
+        ob = BenchXSalsa20(kernel)
+        print ob
+        for (legend, msgsize) in [
+            ("small (%d B)", 64),
+            ("medium (%d B)", 1024),
+            ("large (%d B)", 2**20),
+            ]:
+            print legend % msgsize
+            ob.msgsize = msgsize
+            rep_bench(ob.crypt, max(msgsize, 2**20), UNITS_PER_SECOND=UNITS_PER_SECOND, MAXTIME=MAXTIME, MAXREPS=100, initfunc=ob.crypt_init)
+            print
+
+    print "nanoseconds per byte crypted"
+    print
+
 def bench(MAXTIME=10.0):
     bench_ciphers(MAXTIME)
+    bench_aesgcm(MAXTIME)
+    bench_xsalsa20(MAXTIME)
 
 if __name__ == '__main__':
     bench()
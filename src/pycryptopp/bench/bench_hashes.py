@@ -1,4 +1,5 @@
-from pycryptopp.hash import sha256
+from pycryptopp import _pycryptopp
+from pycryptopp.hash import sha256, sha512, merkle, kdf
 
 from common import insecurerandstr, rep_bench
 
@@ -13,11 +14,81 @@ class SHA256(object):
         h.update(self.msg)
         h.digest()
 
+class SHA512(object):
+    """ With the kernel that SHA512 objects use by default. """
+    kernel = None
+
+    def proc_init(self, N):
+        self.msg = insecurerandstr(N)
+
+    def proc(self, N):
+        h = sha512.SHA512(kernel=self.kernel)
+        h.update(self.msg)
+        h.digest()
+
+class SHA512cryptopp(SHA512):
+    kernel = "cryptopp"
+
+class SHA512supercop(SHA512):
+    kernel = "supercop"
+
+class SHA256Many(object):
+    """ Many independent 64-byte messages, hashed one SHA256 object at a
+    time, and then all at once with sha256.hash_many(). """
+    MSGSIZE = 64
+
+    def proc_init(self, N):
+        self.msgs = [insecurerandstr(self.MSGSIZE) for i in range(N // self.MSGSIZE)]
+
+    def loop(self, N):
+        for msg in self.msgs:
+            sha256.SHA256(msg).digest()
+
+    def hash_many(self, N):
+        sha256.hash_many(self.msgs)
+
+class MerkleTree(object):
+    LEAFSIZE = 4096
+
+    def proc_init(self, N):
+        self.msg = insecurerandstr(N)
+
+    def proc(self, N):
+        merkle.tree_hash(self.msg, self.LEAFSIZE)
+
+class HKDFExpand(object):
+    """ Derive many 32-byte keys from one pseudorandom key: with HMAC built
+    from Python's hmac module, one hkdf_expand() call at a time, and all at
+    once with hkdf_expand_many(). """
+    def proc_init(self, N):
+        self.prk = kdf.hkdf_extract(insecurerandstr(32))
+        self.infos = ["file %d" % i for i in range(N)]
+
+    def pyhmac(self, N):
+        import hashlib, hmac
+        for info in self.infos:
+            hmac.new(self.prk, info + "\x01", hashlib.sha256).digest()
+
+    def loop(self, N):
+        for info in self.infos:
+            kdf.hkdf_expand(self.prk, 32, info)
+
+    def expand_many(self, N):
+        kdf.hkdf_expand_many(self.prk, self.infos, 32)
+
+class PBKDF2(object):
+    def proc_init(self, N):
+        self.password = insecurerandstr(16)
+        self.salt = insecurerandstr(16)
+
+    def proc(self, N):
+        kdf.pbkdf2(self.password, self.salt, N)
+
 def generate_hash_benchers():
     try:
         import hashlib
     except ImportError:
-        return [SHA256]
+        return [SHA256, SHA512, SHA512cryptopp, SHA512supercop, MerkleTree]
     else:
         class hashlibSHA256(object):
             def proc_init(self, N):
@@ -27,8 +98,17 @@ def generate_hash_benchers():
                 h = hashlib.sha256()
                 h.update(self.msg)
                 h.digest()
-                
-        return [SHA256, hashlibSHA256]
+
+        class hashlibSHA512(object):
+            def proc_init(self, N):
+                self.msg = insecurerandstr(N)
+
+            def proc(self, N):
+                h = hashlib.sha512()
+                h.update(self.msg)
+                h.digest()
+
+        return [SHA256, SHA512, SHA512cryptopp, SHA512supercop, MerkleTree, hashlibSHA256, hashlibSHA512]
     
 def bench_hashes(MAXTIME):
     for klass in generate_hash_benchers():
@@ -41,7 +121,37 @@ def bench_hashes(MAXTIME):
             rep_bench(ob.proc, size, UNITS_PER_SECOND=UNITS_PER_SECOND, MAXTIME=MAXTIME, MAXREPS=100, initfunc=ob.proc_init)
             print
 
-    print "nanoseconds per byte hashed"
+    print "nanoseconds per byte hashed (SHA256 kernel: %s, SHA512 kernel: %s)" % (_pycryptopp.cpu_features()['sha256'], _pycryptopp.cpu_features()['sha512'])
+    print
+
+    ob = SHA256Many()
+    for (legend, func) in [
+        ("SHA256(x).digest() loop, %d-byte messages", ob.loop),
+        ("hash_many(), %d-byte messages", ob.hash_many),
+        ]:
+        print legend % ob.MSGSIZE
+        rep_bench(func, 10**6, UNITS_PER_SECOND=UNITS_PER_SECOND, MAXTIME=MAXTIME, MAXREPS=100, initfunc=ob.proc_init)
+        print
+    print "nanoseconds per byte hashed (hash_many() kernel: %s)" % (_pycryptopp.cpu_features()['sha256_many'],)
+    print
+
+    ob = HKDFExpand()
+    for (legend, func) in [
+        ("hmac module loop", ob.pyhmac),
+        ("hkdf_expand() loop", ob.loop),
+        ("hkdf_expand_many()", ob.expand_many),
+        ]:
+        print legend
+        rep_bench(func, 10**4, UNITS_PER_SECOND=UNITS_PER_SECOND, MAXTIME=MAXTIME, MAXREPS=100, initfunc=ob.proc_init)
+        print
+    print "nanoseconds per 32-byte key derived"
+    print
+
+    ob = PBKDF2()
+    print "pbkdf2()"
+    rep_bench(ob.proc, 10**5, UNITS_PER_SECOND=UNITS_PER_SECOND, MAXTIME=MAXTIME, MAXREPS=100, initfunc=ob.proc_init)
+    print
+    print "nanoseconds per PBKDF2 iteration"
     print
 
 
@@ -0,0 +1,75 @@
+from pycryptopp import ida
+from pycryptopp.cipher import xsalsa20
+
+from common import insecurerandstr, rep_bench
+
+UNITS_PER_SECOND = 10**9
+
+# file sizes from 1 MiB to 1 GiB; at 1 GiB, 3-of-10 shares take over 4 GB
+FILESIZES = [2**20, 2**24, 2**27, 2**30]
+
+class BenchIDA(object):
+    """ Encode files into n shares, and decode them again from the first k,
+    which are the data itself, or from the last k, which leaves as many data
+    shares as possible to be computed from the check shares. """
+    def __init__(self, k, n, **kwargs):
+        self.k = k
+        self.n = n
+        self.kwargs = kwargs
+
+    def __repr__(self):
+        extra = "".join([" %s=%s" % kv for kv in sorted(self.kwargs.items())])
+        return "<IDA k=%d n=%d%s>" % (self.k, self.n, extra)
+
+    def _data(self, N):
+        # insecurerandstr() is far too slow for a gigabyte
+        return xsalsa20.XSalsa20(insecurerandstr(32)).process("\x00"*N)
+
+    def encode_init(self, N):
+        self.datashares = self.checkshares = None
+        self.data = self._data(N)
+
+    def encode(self, N):
+        ida.encode(self.data, self.k, self.n, **self.kwargs)
+
+    def decode_init(self, N):
+        self.data = None
+        shares = list(enumerate(ida.encode(self._data(N), self.k, self.n, **self.kwargs)))
+        self.datashares = shares[:self.k]
+        self.checkshares = shares[-self.k:]
+
+    def decode_data(self, N):
+        ida.decode(self.datashares, self.k, **self.kwargs)
+
+    def decode_check(self, N):
+        ida.decode(self.checkshares, self.k, **self.kwargs)
+
+def bench_ida(MAXTIME, filesizes=FILESIZES):
+    options = [{}]
+    for kernel in ["avx2", "ssse3", "scalar"]:
+        try:
+            ida.encode("", 1, 1, field="gf2_8", kernel=kernel)
+        except ida.Error:
+            continue
+        options.append({'field': "gf2_8", 'kernel': kernel})
+    for (k, n, kwargs) in [(k, n, kwargs) for (k, n) in [(3, 10), (16, 20)] for kwargs in options]:
+        ob = BenchIDA(k, n, **kwargs)
+        print ob
+        for size in filesizes:
+            print "encode (%d B)" % size
+            rep_bench(ob.encode, size, UNITS_PER_SECOND=UNITS_PER_SECOND, MAXTIME=MAXTIME, MAXREPS=100, initfunc=ob.encode_init)
+            print "decode from shares 0..k-1 (%d B)" % size
+            rep_bench(ob.decode_data, size, UNITS_PER_SECOND=UNITS_PER_SECOND, MAXTIME=MAXTIME, MAXREPS=100, initfunc=ob.decode_init)
+            print "decode from shares n-k..n-1 (%d B)" % size
+            rep_bench(ob.decode_check, size, UNITS_PER_SECOND=UNITS_PER_SECOND, MAXTIME=MAXTIME, MAXREPS=100)
+            print
+        ob.datashares = ob.checkshares = None
+
+    print "nanoseconds per byte of file"
+    print
+
+def bench(MAXTIME=10.0):
+    bench_ida(MAXTIME)
+
+if __name__ == '__main__':
+    bench()
@@ -30,8 +30,15 @@ class ECDSA256(object):
         sig = self.sig
         verifier = self.verifier
         for i in xrange(N):
-            verifier.verify(sig, msg)
+            verifier.verify(msg, sig)
         
+    def ver_precomputed_init(self, N):
+        self.ver_init(N)
+        self.verifier.precompute()
+
+    def ver_precomputed(self, N):
+        self.ver(N)
+
 class Ed25519(object):
     def __init__(self):
         self.seed = insecurerandstr(32)
@@ -60,6 +67,22 @@ class Ed25519(object):
         for i in xrange(N):
             verifier.verify(sig, msg)
         
+    def ver_batch_init(self, N):
+        signer = ed25519.SigningKey(self.seed)
+        verifier = ed25519.VerifyingKey(signer.get_verifying_key_bytes())
+        msgs = [msg + str(i) for i in xrange(N)]
+        self.items = [(verifier, signer.sign(m), m) for m in msgs]
+
+    def ver_batch(self, N):
+        ed25519.verify_batch(self.items[:N])
+
+    def ver_batch_distinct_init(self, N):
+        self.items = []
+        for i in xrange(N):
+            signer = ed25519.SigningKey(insecurerandstr(32))
+            verifier = ed25519.VerifyingKey(signer.get_verifying_key_bytes())
+            self.items.append((verifier, signer.sign(msg), msg))
+
 class RSA2048(object):
     SIZEINBITS=2048
 
@@ -89,6 +112,16 @@ class RSA2048(object):
         for i in xrange(N):
             verifier.verify(msg, sig)
         
+    def sign_many(self, N):
+        self.signer.sign_many([msg] * N)
+
+    def ver_many_init(self, N):
+        self.ver_init(N)
+        self.items = [(msg, self.sig)] * N
+
+    def ver_many(self, N):
+        self.verifier.verify_many(self.items[:N])
+
 class RSA3248(object):
     SIZEINBITS=3248
 
@@ -117,7 +150,17 @@ class RSA3248(object):
         verifier = self.verifier
         for i in xrange(N):
             verifier.verify(msg, sig)
-        
+
+    def sign_many(self, N):
+        self.signer.sign_many([msg] * N)
+
+    def ver_many_init(self, N):
+        self.ver_init(N)
+        self.items = [(msg, self.sig)] * N
+
+    def ver_many(self, N):
+        self.verifier.verify_many(self.items[:N])
+
 def bench_sigs(MAXTIME):
     for klass in [ECDSA256, Ed25519,]:
         print klass
@@ -128,6 +171,14 @@ def bench_sigs(MAXTIME):
         rep_bench(ob.sign, 1000, UNITS_PER_SECOND=1000, initfunc=ob.sign_init, MAXTIME=MAXTIME, MAXREPS=100)
         print "verify"
         rep_bench(ob.ver, 1000, UNITS_PER_SECOND=1000, initfunc=ob.ver_init, MAXTIME=MAXTIME, MAXREPS=100)
+        if hasattr(ob, "ver_precomputed"):
+            print "verify (precomputed)"
+            rep_bench(ob.ver_precomputed, 1000, UNITS_PER_SECOND=1000, initfunc=ob.ver_precomputed_init, MAXTIME=MAXTIME, MAXREPS=100)
+        if hasattr(ob, "ver_batch"):
+            print "verify_batch"
+            rep_bench(ob.ver_batch, 1000, UNITS_PER_SECOND=1000, initfunc=ob.ver_batch_init, MAXTIME=MAXTIME, MAXREPS=100)
+            print "verify_batch (distinct keys)"
+            rep_bench(ob.ver_batch, 1000, UNITS_PER_SECOND=1000, initfunc=ob.ver_batch_distinct_init, MAXTIME=MAXTIME, MAXREPS=100)
         print
 
     for klass in [RSA2048, RSA3248]:
@@ -137,8 +188,12 @@ def bench_sigs(MAXTIME):
         rep_bench(ob.gen, 1, UNITS_PER_SECOND=1000, MAXTIME=MAXTIME, MAXREPS=100)
         print "sign"
         rep_bench(ob.sign, 1000, UNITS_PER_SECOND=1000, initfunc=ob.sign_init, MAXTIME=MAXTIME, MAXREPS=100)
+        print "sign_many"
+        rep_bench(ob.sign_many, 1000, UNITS_PER_SECOND=1000, initfunc=ob.sign_init, MAXTIME=MAXTIME, MAXREPS=100)
         print "verify"
         rep_bench(ob.ver, 10000, UNITS_PER_SECOND=1000, initfunc=ob.ver_init, MAXTIME=MAXTIME, MAXREPS=100)
+        print "verify_many"
+        rep_bench(ob.ver_many, 10000, UNITS_PER_SECOND=1000, initfunc=ob.ver_many_init, MAXTIME=MAXTIME, MAXREPS=100)
         print
 
     print "milliseconds per operation"
@@ -0,0 +1,105 @@
+import threading, time
+
+from pycryptopp.cipher import aes, xsalsa20
+from pycryptopp.hash import sha256
+from pycryptopp.publickey import ecdsa, rsa
+
+from common import insecurerandstr
+
+msg = 'crypto libraries should come with benchmarks'
+
+MSGSIZE = 2**20
+
+def cpu_count():
+    try:
+        import multiprocessing
+        return multiprocessing.cpu_count()
+    except (ImportError, NotImplementedError):
+        return 1
+
+# Each *_job() function is called once per thread and returns a function that
+# does one unit of work, so that every thread has its own objects.
+
+def aes_job(bigmsg):
+    key = insecurerandstr(16)
+    def job():
+        aes.AES(key).process(bigmsg)
+    return job
+
+def xsalsa20_job(bigmsg):
+    key = insecurerandstr(32)
+    def job():
+        xsalsa20.XSalsa20(key).process(bigmsg)
+    return job
+
+def sha256_job(bigmsg):
+    def job():
+        sha256.SHA256(bigmsg).digest()
+    return job
+
+def ecdsa_sign_job(bigmsg):
+    signer = ecdsa.SigningKey(insecurerandstr(32))
+    def job():
+        signer.sign(msg)
+    return job
+
+def rsa_sign_job(bigmsg):
+    signer = rsa.generate(sizeinbits=2048)
+    def job():
+        signer.sign(msg)
+    return job
+
+def run_threads(makejob, bigmsg, nthreads, MAXTIME):
+    jobs = [ makejob(bigmsg) for i in range(nthreads) ]
+    counts = [0] * nthreads
+    start = threading.Event()
+    stopat = []
+
+    def worker(i):
+        job = jobs[i]
+        start.wait()
+        n = 0
+        while time.time() < stopat[0]:
+            job()
+            n += 1
+        counts[i] = n
+
+    threads = [ threading.Thread(target=worker, args=(i,)) for i in range(nthreads) ]
+    for t in threads:
+        t.start()
+    startt = time.time()
+    stopat.append(startt + MAXTIME)
+    start.set()
+    for t in threads:
+        t.join()
+    return sum(counts) / (time.time() - startt)
+
+def bench_threads(MAXTIME, MAXTHREADS=None):
+    if MAXTHREADS is None:
+        MAXTHREADS = max(2, cpu_count())
+    bigmsg = insecurerandstr(MSGSIZE)
+
+    for (name, makejob, unitsize, unitname) in [
+        ("AES-128 process", aes_job, MSGSIZE/2.0**20, "MiB/s"),
+        ("XSalsa20 process", xsalsa20_job, MSGSIZE/2.0**20, "MiB/s"),
+        ("SHA256 update", sha256_job, MSGSIZE/2.0**20, "MiB/s"),
+        ("ECDSA256 sign", ecdsa_sign_job, 1, "ops/s"),
+        ("RSA2048 sign", rsa_sign_job, 1, "ops/s"),
+        ]:
+        print name
+        base = None
+        for nthreads in range(1, MAXTHREADS+1):
+            rate = run_threads(makejob, bigmsg, nthreads, MAXTIME) * unitsize
+            if base is None:
+                base = rate
+            print "%3d threads: %10.2f %s (x%.2f)" % (nthreads, rate, unitname, rate / base)
+        print
+
+    print "aggregate throughput of N threads, each using its own object"
+    print
+
+def bench(MAXTIME=2.0):
+    bench_threads(MAXTIME)
+
+if __name__ == '__main__':
+    bench()
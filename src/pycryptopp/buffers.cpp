@@ -0,0 +1,94 @@
+/**
+ * buffers.cpp -- accept str and buffer-protocol objects as input and output
+ * of the pycryptopp bindings without copying them, and convert other
+ * arguments that several bindings share
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#if (PY_VERSION_HEX < 0x02050000)
+typedef int Py_ssize_t;
+#endif
+
+#include "buffers.hpp"
+
+static int
+precondition_violation(PyObject* obj, PyObject* error, const char* what) {
+    PyObject* typerepr = PyObject_Repr(reinterpret_cast<PyObject*>(obj->ob_type));
+    if (typerepr) {
+        PyErr_Format(error, "Precondition violation: you are required to pass %s (not a unicode or anything else), but you passed %s.", what, PyString_AS_STRING(typerepr));
+        Py_DECREF(typerepr);
+    } else
+        PyErr_Format(error, "Precondition violation: you are required to pass %s (not a unicode or anything else).", what);
+    return -1;
+}
+
+int
+pycryptopp_get_read_buffer(PyObject* obj, Py_buffer* view, bool* pinned, PyObject* error) {
+    if (PyUnicode_Check(obj))
+        return precondition_violation(obj, error, "a Python string or an object supporting the buffer protocol");
+
+    if (PyObject_CheckBuffer(obj)) {
+        *pinned = true;
+        return PyObject_GetBuffer(obj, view, PyBUF_SIMPLE);
+    }
+
+    const void* buf;
+    Py_ssize_t len;
+    if (!PyObject_CheckReadBuffer(obj) || PyObject_AsReadBuffer(obj, &buf, &len)) {
+        PyErr_Clear();
+        return precondition_violation(obj, error, "a Python string or an object supporting the buffer protocol");
+    }
+    *pinned = false;
+    return PyBuffer_FillInfo(view, obj, const_cast<void*>(buf), len, 1, PyBUF_SIMPLE);
+}
+
+int
+pycryptopp_get_write_buffer(PyObject* obj, Py_buffer* view, bool* pinned, PyObject* error) {
+    if (PyObject_CheckBuffer(obj)) {
+        if (PyObject_GetBuffer(obj, view, PyBUF_WRITABLE) == 0) {
+            *pinned = true;
+            return 0;
+        }
+        PyErr_Clear();
+        return precondition_violation(obj, error, "a writable object supporting the buffer protocol");
+    }
+
+    void* buf;
+    Py_ssize_t len;
+    if (PyObject_AsWriteBuffer(obj, &buf, &len)) {
+        PyErr_Clear();
+        return precondition_violation(obj, error, "a writable object supporting the buffer protocol");
+    }
+    *pinned = false;
+    return PyBuffer_FillInfo(view, obj, buf, len, 0, PyBUF_WRITABLE);
+}
+
+int
+pycryptopp_get_offset(PyObject* obj, unsigned PY_LONG_LONG* offset, PyObject* error) {
+    if (PyInt_Check(obj)) {
+        long v = PyInt_AS_LONG(obj);
+        if (v < 0) {
+            PyErr_Format(error, "Precondition violation: the offset is required to be non-negative, but it was %ld.", v);
+            return -1;
+        }
+        *offset = static_cast<unsigned PY_LONG_LONG>(v);
+        return 0;
+    }
+    if (!PyLong_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "an integer is required for the offset, not %.200s", obj->ob_type->tp_name);
+        return -1;
+    }
+    if (_PyLong_Sign(obj) < 0) {
+        PyErr_SetString(error, "Precondition violation: the offset is required to be non-negative.");
+        return -1;
+    }
+    unsigned PY_LONG_LONG v = PyLong_AsUnsignedLongLong(obj);
+    if (v == static_cast<unsigned PY_LONG_LONG>(-1) && PyErr_Occurred()) {
+        PyErr_Clear();
+        PyErr_SetString(error, "Precondition violation: the offset is required to be less than 2**64.");
+        return -1;
+    }
+    *offset = v;
+    return 0;
+}
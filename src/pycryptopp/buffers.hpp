@@ -0,0 +1,31 @@
+#ifndef __INCL_BUFFERS_HPP
+#define __INCL_BUFFERS_HPP
+
+/**
+ * Get a view of the bytes of obj, which may be a str or any object that
+ * supports the buffer protocol (bytearray, memoryview, mmap, array, ...),
+ * but not a unicode object. On failure set `error' (or TypeError) and return
+ * -1. On success return 0; the caller must PyBuffer_Release(view).
+ *
+ * *pinned is set to true if obj guarantees that the memory stays where it is
+ * until the view is released (true for str and for anything exported through
+ * the new-style buffer protocol). Callers must hold the GIL while using an
+ * unpinned view, since another thread could otherwise resize or close obj
+ * underneath them.
+ */
+extern int
+pycryptopp_get_read_buffer(PyObject* obj, Py_buffer* view, bool* pinned, PyObject* error);
+
+/** Like pycryptopp_get_read_buffer(), but the view must be writable. */
+extern int
+pycryptopp_get_write_buffer(PyObject* obj, Py_buffer* view, bool* pinned, PyObject* error);
+
+/**
+ * Convert obj, which must be a non-negative int or long that fits in 64 bits,
+ * to a byte offset into a stream. On failure set `error' (or TypeError) and
+ * return -1.
+ */
+extern int
+pycryptopp_get_offset(PyObject* obj, unsigned PY_LONG_LONG* offset, PyObject* error);
+
+#endif /* #ifndef __INCL_BUFFERS_HPP */
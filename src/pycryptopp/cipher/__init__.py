@@ -2,4 +2,4 @@ import aes
 import xsalsa20
 import aesgcm
 
-quiet_pyflakes=[aes, xsalsa20]
+quiet_pyflakes=[aes, xsalsa20, aesgcm]
@@ -5,9 +5,39 @@ from pycryptopp import _import_my_names
 # doesn't understand that we have to do some funky import trickery
 # below in _import_my_names() in order to get sensible namespaces.
 AESGCM=None
+AESGCMStream=None
 Error=None
 
 _import_my_names(globals(), "aesgcm_")
 
 del _import_my_names
 
+def start_up_self_test():
+    """
+    This is a quick test intended to detect major errors such as the library being
+    miscompiled and segfaulting or returning incorrect answers.
+    These tests were copied from pycryptopp/test/test_aesgcm.py, which has
+    them from the GCM specification.
+    """
+    from binascii import a2b_hex
+
+    key = a2b_hex("feffe9928665731c6d6a8f9467308308")
+    nonce = a2b_hex("cafebabefacedbaddecaf888")
+    aad = a2b_hex("feedfacedeadbeeffeedfacedeadbeefabaddad2")
+    pt = a2b_hex("d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39")
+    ct = a2b_hex("42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091")
+    tag = a2b_hex("5bc94fbc3221a5db94fae95ae7121a47")
+
+    cryptor = AESGCM(key)
+    if cryptor.encrypt(nonce, aad, pt) != (ct, tag):
+        raise Error("pycryptopp failed startup self-test. Please run pycryptopp unit tests.")
+    if cryptor.decrypt(nonce, aad, ct, tag) != pt:
+        raise Error("pycryptopp failed startup self-test. Please run pycryptopp unit tests.")
+    try:
+        cryptor.decrypt(nonce, aad, ct, tag[:-1]+chr(ord(tag[-1])^1))
+    except Error:
+        pass
+    else:
+        raise Error("pycryptopp failed startup self-test. Please run pycryptopp unit tests.")
+
+start_up_self_test()
@@ -9,17 +9,22 @@ typedef int Py_ssize_t;
 #endif
 
 #include "aesgcmmodule.hpp"
+#include "../buffers.hpp"
+#include "../cpufeatures.hpp"
+#include "../gil.hpp"
 
 /* from Crypto++ */
 #ifdef DISABLE_EMBEDDED_CRYPTOPP
+#include <cryptopp/algparam.h>
 #include <cryptopp/gcm.h>
 #include <cryptopp/aes.h>
 #else
+#include <src-cryptopp/algparam.h>
 #include <src-cryptopp/gcm.h>
 #include <src-cryptopp/aes.h>
 #endif
 
-static const char*const aesgcm___doc__ = "_aes gcm mode cipher";
+static const char*const aesgcm___doc__ = "_aesgcm authenticated cipher";
 
 static PyObject *aesgcm_error;
 
@@ -27,39 +32,618 @@ typedef struct {
     PyObject_HEAD
 
     /* internal */
+    /* Keyed once, in __init__. Each message only resynchronizes them to its
+       nonce, which reuses the AES key schedule and the GHASH tables. */
     CryptoPP::GCM<CryptoPP::AES>::Encryption * e;
     CryptoPP::GCM<CryptoPP::AES>::Decryption * d;
-    Py_ssize_t ivsize;
-    const byte *iv;
+    unsigned int tagsize;
+    /* the GHASH implementation that e and d use, for the ghash attribute */
+    const char * ghash;
+    /* the IV passed to the constructor, for decrypt_and_verify(); or NULL */
+    std::string * iv;
+    PyThread_type_lock lock;
 } AESGCM;
 
 PyDoc_STRVAR(AESGCM__doc__,
-"AES GCM Doc");
+"An AES-GCM authenticated cipher object.\n\
+\n\
+The AES key schedule and the GHASH multiplication tables are computed once,\n\
+when the object is created, and reused for every message, so keep the object\n\
+around rather than creating one per message.\n\
+\n\
+Every message must be encrypted with a different nonce: encrypting two\n\
+messages with the same key and nonce reveals their XOR and lets anybody forge\n\
+messages. A 12-byte nonce is recommended, e.g. a message counter.\n\
+\n\
+@param key: the symmetric key; a string of exactly 16, 24 or 32 bytes\n\
+@param iv: the nonce to use for decrypt_and_verify() (deprecated; pass the\n\
+    nonce to each call instead)\n\
+@param tagsize: the length of the authentication tags that this object\n\
+    produces and accepts; from 12 to 16 (default: 16)\n\
+@param ghash: how to do the GF(2^128) multiplications of GHASH: 'clmul' to\n\
+    use the CPU's carry-less multiply instruction, which needs no tables and\n\
+    is the fastest; '2k' or '64k' to use multiplication tables of that many\n\
+    bytes per key (twice over, since the object can both encrypt and\n\
+    decrypt), where the bigger tables are faster; or None for 'clmul' if the\n\
+    CPU supports it and '2k' otherwise (default: None). The .ghash\n\
+    attribute tells which one is in use.\
+");
+
+typedef struct {
+    PyObject_HEAD
+
+    /* internal */
+    CryptoPP::AuthenticatedSymmetricCipher * c;
+    bool encrypting;
+    int state;
+    unsigned int tagsize;
+    PyThread_type_lock lock;
+} AESGCMStream;
+
+/* AESGCMStream.state */
+#define AESGCM_STREAM_AAD 0
+#define AESGCM_STREAM_DATA 1
+#define AESGCM_STREAM_DONE 2
+
+PyDoc_STRVAR(AESGCMStream__doc__,
+"One message being encrypted or decrypted piecewise with AES-GCM; create it\n\
+with AESGCM.encryptor() or AESGCM.decryptor().\n\
+\n\
+Call .update_aad() any number of times with further additional authenticated\n\
+data, then .process() any number of times with the data, and finally\n\
+.finish() to get the tag (when encrypting) or .verify(tag) to check it (when\n\
+decrypting).\n\
+\n\
+When decrypting, the bytes returned by .process() have not been\n\
+authenticated until .verify() has returned: do not act on them before then.");
+
+/** Get read views of the n objects objs, or none of them. On success *pinned
+    is set to whether all of them are pinned. This function is only for
+    internal use by aesgcmmodule.cpp. */
+static int
+AESGCM_get_buffers(PyObject** objs, Py_buffer* views, size_t n, bool* pinned) {
+    *pinned = true;
+    for (size_t i = 0; i < n; i++) {
+        bool p;
+        if (pycryptopp_get_read_buffer(objs[i], &views[i], &p, aesgcm_error)) {
+            while (i > 0)
+                PyBuffer_Release(&views[--i]);
+            return -1;
+        }
+        *pinned = *pinned && p;
+    }
+    return 0;
+}
+
+static void
+AESGCM_release_buffers(Py_buffer* views, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        PyBuffer_Release(&views[i]);
+}
+
+static int
+AESGCM_check_nonce(const Py_buffer* nonce) {
+    if (nonce->len < 1) {
+        PyErr_SetString(aesgcm_error, "Precondition violation: the nonce is required to be at least one byte long.");
+        return -1;
+    }
+    return 0;
+}
+
+static int
+AESGCM_check_tag(unsigned int tagsize, const Py_buffer* tag) {
+    if (tag->len != tagsize) {
+        PyErr_Format(aesgcm_error, "Precondition violation: the tag is required to be %u bytes long, but it was %zd bytes.", tagsize, tag->len);
+        return -1;
+    }
+    return 0;
+}
+
+/** Return 0 if stream may move on to state `to', else set an Error and
+    return -1. This function is only for internal use by aesgcmmodule.cpp. */
+static int
+AESGCMStream_check_state(AESGCMStream* self, int to) {
+    if (self->state == AESGCM_STREAM_DONE) {
+        PyErr_SetString(aesgcm_error, "Precondition violation: this message has already been finished.");
+        return -1;
+    }
+    if (to == AESGCM_STREAM_AAD && self->state != AESGCM_STREAM_AAD) {
+        PyErr_SetString(aesgcm_error, "Precondition violation: all of the additional authenticated data is required to come before any of the message.");
+        return -1;
+    }
+    return 0;
+}
+
+/** Once Crypto++ has thrown, as when a message passes GCM's maximum length,
+    the stream can no longer produce a tag for the bytes it was given, so it
+    is finished. This function is only for internal use by aesgcmmodule.cpp. */
+static void
+AESGCMStream_fail(AESGCMStream* self) {
+    self->state = AESGCM_STREAM_DONE;
+}
 
 static PyObject *
-AESGCM_decrypt_verify(AESGCM* self, PyObject* args) {
-    const char *msg, *tag;
-    Py_ssize_t msgsize, tagsize;
-    PyArg_ParseTuple(args, "t#t#", &msg, &msgsize, &tag, &tagsize);
+AESGCMStream_update_aad(AESGCMStream* self, PyObject* aadobj) {
+    Py_buffer aad;
+    bool pinned;
+    if (pycryptopp_get_read_buffer(aadobj, &aad, &pinned, aesgcm_error))
+        return NULL;
+
+    if (pinned) {
+        PYCRYPTOPP_LOCK_IF_LARGE(self, aad.len);
+    }
+    ENTER_PYCRYPTOPP(self);
+    if (AESGCMStream_check_state(self, AESGCM_STREAM_AAD)) {
+        LEAVE_PYCRYPTOPP(self);
+        PyBuffer_Release(&aad);
+        return NULL;
+    }
+    std::string err;
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && PYCRYPTOPP_RELEASE_GIL_FOR(self, aad.len))
+    try {
+        self->c->Update(reinterpret_cast<const byte*>(aad.buf), aad.len);
+    } catch (CryptoPP::Exception& le) {
+        err = le.what();
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    if (!err.empty())
+        AESGCMStream_fail(self);
+    LEAVE_PYCRYPTOPP(self);
+    PyBuffer_Release(&aad);
+    if (!err.empty())
+        return PyErr_Format(aesgcm_error, "Crypto++ gave this exception: %s", err.c_str());
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(AESGCMStream_update_aad__doc__,
+"Add more additional authenticated data. This must be called before the\n\
+first call to .process().\n\
+\n\
+@param aad: a string or any object supporting the buffer protocol");
+
+/** This function is only for internal use by aesgcmmodule.cpp. */
+static int
+AESGCMStream_process_locked(AESGCMStream* self, byte* out, const byte* in, Py_ssize_t len, bool pinned) {
+    if (pinned) {
+        PYCRYPTOPP_LOCK_IF_LARGE(self, len);
+    }
+    ENTER_PYCRYPTOPP(self);
+    if (AESGCMStream_check_state(self, AESGCM_STREAM_DATA)) {
+        LEAVE_PYCRYPTOPP(self);
+        return -1;
+    }
+    self->state = AESGCM_STREAM_DATA;
+    /* As in aesmodule.cpp: Crypto++'s CTR mode must not be given zero bytes
+       while it holds part of a keystream block. */
+    if (len == 0) {
+        LEAVE_PYCRYPTOPP(self);
+        return 0;
+    }
+    std::string err;
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && PYCRYPTOPP_RELEASE_GIL_FOR(self, len))
+    try {
+        self->c->ProcessData(out, in, len);
+    } catch (CryptoPP::Exception& le) {
+        err = le.what();
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    if (!err.empty())
+        AESGCMStream_fail(self);
+    LEAVE_PYCRYPTOPP(self);
+    if (!err.empty()) {
+        PyErr_Format(aesgcm_error, "Crypto++ gave this exception: %s", err.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *
+AESGCMStream_process(AESGCMStream* self, PyObject* msgobj) {
+    Py_buffer msg;
+    bool pinned;
+    if (pycryptopp_get_read_buffer(msgobj, &msg, &pinned, aesgcm_error))
+        return NULL;
+
+    PyObject* result = PyString_FromStringAndSize(NULL, msg.len);
+    if (result && AESGCMStream_process_locked(self, reinterpret_cast<byte*>(PyString_AS_STRING(result)), reinterpret_cast<const byte*>(msg.buf), msg.len, pinned)) {
+        Py_DECREF(result);
+        result = NULL;
+    }
+    PyBuffer_Release(&msg);
+    return result;
+}
+
+PyDoc_STRVAR(AESGCMStream_process__doc__,
+"Encrypt or decrypt the next bytes of the message, returning the result.\n\
+\n\
+@param msg: a string or any object supporting the buffer protocol");
+
+static PyObject *
+AESGCMStream_process_into(AESGCMStream* self, PyObject* args) {
+    PyObject *srcobj, *dstobj;
+    if (!PyArg_ParseTuple(args, "OO:process_into", &srcobj, &dstobj))
+        return NULL;
+
+    Py_buffer src, dst;
+    bool srcpinned, dstpinned;
+    if (pycryptopp_get_read_buffer(srcobj, &src, &srcpinned, aesgcm_error))
+        return NULL;
+    if (pycryptopp_get_write_buffer(dstobj, &dst, &dstpinned, aesgcm_error)) {
+        PyBuffer_Release(&src);
+        return NULL;
+    }
+    PyObject* result = NULL;
+    if (dst.len < src.len)
+        PyErr_Format(aesgcm_error, "Precondition violation: the output buffer is required to be at least as long as the input (%zd bytes), but it was %zd bytes.", src.len, dst.len);
+    else if (!AESGCMStream_process_locked(self, reinterpret_cast<byte*>(dst.buf), reinterpret_cast<const byte*>(src.buf), src.len, srcpinned && dstpinned))
+        result = PyInt_FromSsize_t(src.len);
+    PyBuffer_Release(&src);
+    PyBuffer_Release(&dst);
+    return result;
+}
+
+PyDoc_STRVAR(AESGCMStream_process_into__doc__,
+"Encrypt or decrypt the next len(src) bytes of the message from src into the\n\
+beginning of dst, returning the number of bytes written.\n\
+\n\
+@param src: a string or any object supporting the buffer protocol\n\
+@param dst: a writable object supporting the buffer protocol, at least as\n\
+    long as src; it may be the same object as src (to work in place), but\n\
+    must not otherwise overlap it");
+
+static PyObject *
+AESGCMStream_finish(AESGCMStream* self, PyObject* dummy) {
+    if (!self->encrypting) {
+        PyErr_SetString(aesgcm_error, "Precondition violation: finish() is for encryption; a decryptor has to be finished with verify(tag).");
+        return NULL;
+    }
+    ENTER_PYCRYPTOPP(self);
+    if (AESGCMStream_check_state(self, AESGCM_STREAM_DONE)) {
+        LEAVE_PYCRYPTOPP(self);
+        return NULL;
+    }
+    byte tag[CryptoPP::AES::BLOCKSIZE];
+    self->c->TruncatedFinal(tag, self->tagsize);
+    self->state = AESGCM_STREAM_DONE;
+    LEAVE_PYCRYPTOPP(self);
+    return PyString_FromStringAndSize(reinterpret_cast<const char*>(tag), self->tagsize);
+}
 
-    assert (msgsize >= 0);
-    assert (tagsize >= 0);
+PyDoc_STRVAR(AESGCMStream_finish__doc__,
+"Finish encrypting the message and return its authentication tag.");
+
+static PyObject *
+AESGCMStream_verify(AESGCMStream* self, PyObject* tagobj) {
+    if (self->encrypting) {
+        PyErr_SetString(aesgcm_error, "Precondition violation: verify() is for decryption; an encryptor has to be finished with finish().");
+        return NULL;
+    }
+    Py_buffer tag;
+    bool pinned;
+    if (pycryptopp_get_read_buffer(tagobj, &tag, &pinned, aesgcm_error))
+        return NULL;
+    if (AESGCM_check_tag(self->tagsize, &tag)) {
+        PyBuffer_Release(&tag);
+        return NULL;
+    }
+    ENTER_PYCRYPTOPP(self);
+    if (AESGCMStream_check_state(self, AESGCM_STREAM_DONE)) {
+        LEAVE_PYCRYPTOPP(self);
+        PyBuffer_Release(&tag);
+        return NULL;
+    }
+    const bool verified = self->c->TruncatedVerify(reinterpret_cast<const byte*>(tag.buf), tag.len);
+    self->state = AESGCM_STREAM_DONE;
+    LEAVE_PYCRYPTOPP(self);
+    PyBuffer_Release(&tag);
 
-    PyStringObject* result = reinterpret_cast<PyStringObject*>(PyString_FromStringAndSize(NULL, msgsize));
+    if (!verified) {
+        PyErr_SetString(aesgcm_error, "The authentication tag did not match: the message, the additional data, the nonce or the tag has been altered, or the wrong key was used.");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(AESGCMStream_verify__doc__,
+"Finish decrypting the message and check its authentication tag, raising\n\
+Error if it does not match.\n\
+\n\
+@param tag: the tag returned by the encryptor's finish()");
+
+static PyMethodDef AESGCMStream_methods[] = {
+    {"update_aad", reinterpret_cast<PyCFunction>(AESGCMStream_update_aad), METH_O, AESGCMStream_update_aad__doc__},
+    {"process", reinterpret_cast<PyCFunction>(AESGCMStream_process), METH_O, AESGCMStream_process__doc__},
+    {"process_into", reinterpret_cast<PyCFunction>(AESGCMStream_process_into), METH_VARARGS, AESGCMStream_process_into__doc__},
+    {"finish", reinterpret_cast<PyCFunction>(AESGCMStream_finish), METH_NOARGS, AESGCMStream_finish__doc__},
+    {"verify", reinterpret_cast<PyCFunction>(AESGCMStream_verify), METH_O, AESGCMStream_verify__doc__},
+    {NULL},
+};
+
+static void
+AESGCMStream_dealloc(PyObject* self) {
+    if (reinterpret_cast<AESGCMStream*>(self)->c)
+        delete reinterpret_cast<AESGCMStream*>(self)->c;
+    PYCRYPTOPP_FREE_LOCK(reinterpret_cast<AESGCMStream*>(self));
+    PyObject_Del(self);
+}
+
+static PyTypeObject AESGCMStream_type = {
+    PyObject_HEAD_INIT(NULL)
+    0,                         /*ob_size*/
+    "_aesgcm.AESGCMStream", /*tp_name*/
+    sizeof(AESGCMStream),             /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    AESGCMStream_dealloc, /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,        /*tp_flags*/
+    AESGCMStream__doc__,           /* tp_doc */
+    0,		               /* tp_traverse */
+    0,		               /* tp_clear */
+    0,		               /* tp_richcompare */
+    0,		               /* tp_weaklistoffset */
+    0,		               /* tp_iter */
+    0,		               /* tp_iternext */
+    AESGCMStream_methods,      /* tp_methods */
+};
+
+static PyObject *
+AESGCM_encrypt(AESGCM* self, PyObject* args) {
+    PyObject *objs[3];
+    if (!PyArg_ParseTuple(args, "OOO:encrypt", &objs[0], &objs[1], &objs[2]))
+        return NULL;
+    Py_buffer views[3];
+    bool pinned;
+    if (AESGCM_get_buffers(objs, views, 3, &pinned))
+        return NULL;
+    const Py_buffer &nonce = views[0], &aad = views[1], &pt = views[2];
+    if (AESGCM_check_nonce(&nonce)) {
+        AESGCM_release_buffers(views, 3);
+        return NULL;
+    }
+
+    PyObject* ct = PyString_FromStringAndSize(NULL, pt.len);
+    PyObject* tag = PyString_FromStringAndSize(NULL, self->tagsize);
+    if (!ct || !tag) {
+        Py_XDECREF(ct);
+        Py_XDECREF(tag);
+        AESGCM_release_buffers(views, 3);
+        return NULL;
+    }
+
+    const Py_ssize_t worklen = aad.len + pt.len;
+    if (pinned) {
+        PYCRYPTOPP_LOCK_IF_LARGE(self, worklen);
+    }
+    ENTER_PYCRYPTOPP(self);
+    std::string err;
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && PYCRYPTOPP_RELEASE_GIL_FOR(self, worklen))
+    try {
+        self->e->EncryptAndAuthenticate(reinterpret_cast<byte*>(PyString_AS_STRING(ct)), reinterpret_cast<byte*>(PyString_AS_STRING(tag)), self->tagsize, reinterpret_cast<const byte*>(nonce.buf), nonce.len, reinterpret_cast<const byte*>(aad.buf), aad.len, reinterpret_cast<const byte*>(pt.buf), pt.len);
+    } catch (CryptoPP::Exception le) {
+        err = le.what();
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    LEAVE_PYCRYPTOPP(self);
+    AESGCM_release_buffers(views, 3);
+
+    if (!err.empty()) {
+        Py_DECREF(ct);
+        Py_DECREF(tag);
+        return PyErr_Format(aesgcm_error, "Crypto++ gave this exception: %s", err.c_str());
+    }
+    PyObject* result = PyTuple_Pack(2, ct, tag);
+    Py_DECREF(ct);
+    Py_DECREF(tag);
+    return result;
+}
+
+PyDoc_STRVAR(AESGCM_encrypt__doc__,
+"Encrypt and authenticate a message, returning the tuple (ciphertext, tag).\n\
+\n\
+@param nonce: a string that is never used twice with the same key\n\
+@param aad: additional data (a string, possibly empty) that is authenticated\n\
+    by the tag along with the message, but not encrypted\n\
+@param pt: the plaintext\n\
+\n\
+Each argument may be a string or any object supporting the buffer protocol.");
+
+/** Decrypt and verify, returning a new str, or NULL with an exception set.
+    This function is only for internal use by aesgcmmodule.cpp. */
+static PyObject *
+AESGCM_decrypt_views(AESGCM* self, const Py_buffer& nonce, const Py_buffer& aad, const Py_buffer& ct, const Py_buffer& tag, bool pinned) {
+    if (AESGCM_check_nonce(&nonce) || AESGCM_check_tag(self->tagsize, &tag))
+        return NULL;
+
+    PyObject* result = PyString_FromStringAndSize(NULL, ct.len);
     if (!result)
         return NULL;
 
-    //virtual bool DecryptAndVerify(byte *message, const byte *mac, size_t macLength, const byte *iv, int ivLength, const byte *header, size_t headerLength, const byte *ciphertext, size_t ciphertextLength);
-    self->d->DecryptAndVerify(reinterpret_cast<byte*>(PyString_AS_STRING(result)), reinterpret_cast<const byte*>(tag), tagsize, self->iv, self->ivsize, NULL, 0, reinterpret_cast<const byte*>(msg), msgsize);
-    return reinterpret_cast<PyObject*>(result);
+    const Py_ssize_t worklen = aad.len + ct.len;
+    if (pinned) {
+        PYCRYPTOPP_LOCK_IF_LARGE(self, worklen);
+    }
+    ENTER_PYCRYPTOPP(self);
+    bool verified = false;
+    std::string err;
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && PYCRYPTOPP_RELEASE_GIL_FOR(self, worklen))
+    try {
+        verified = self->d->DecryptAndVerify(reinterpret_cast<byte*>(PyString_AS_STRING(result)), reinterpret_cast<const byte*>(tag.buf), tag.len, reinterpret_cast<const byte*>(nonce.buf), nonce.len, reinterpret_cast<const byte*>(aad.buf), aad.len, reinterpret_cast<const byte*>(ct.buf), ct.len);
+    } catch (CryptoPP::Exception le) {
+        err = le.what();
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    LEAVE_PYCRYPTOPP(self);
 
+    if (!err.empty() || !verified) {
+        /* Don't leave unauthenticated plaintext lying around in freed memory. */
+        memset(PyString_AS_STRING(result), 0, ct.len);
+        Py_DECREF(result);
+        if (!err.empty())
+            return PyErr_Format(aesgcm_error, "Crypto++ gave this exception: %s", err.c_str());
+        PyErr_SetString(aesgcm_error, "The authentication tag did not match: the message, the additional data, the nonce or the tag has been altered, or the wrong key was used.");
+        return NULL;
+    }
+    return result;
 }
 
-PyDoc_STRVAR(AESGCM_process__doc__,
-"Encrypt or decrypt the next bytes, returning the result.");
+static PyObject *
+AESGCM_decrypt(AESGCM* self, PyObject* args) {
+    PyObject *objs[4];
+    if (!PyArg_ParseTuple(args, "OOOO:decrypt", &objs[0], &objs[1], &objs[2], &objs[3]))
+        return NULL;
+    Py_buffer views[4];
+    bool pinned;
+    if (AESGCM_get_buffers(objs, views, 4, &pinned))
+        return NULL;
+    PyObject* result = AESGCM_decrypt_views(self, views[0], views[1], views[2], views[3], pinned);
+    AESGCM_release_buffers(views, 4);
+    return result;
+}
+
+PyDoc_STRVAR(AESGCM_decrypt__doc__,
+"Verify and decrypt a message, returning the plaintext, or raising Error if\n\
+the tag does not match.\n\
+\n\
+@param nonce: the nonce the message was encrypted with\n\
+@param aad: the additional data it was encrypted with\n\
+@param ct: the ciphertext\n\
+@param tag: the tag returned by encrypt()\n\
+\n\
+Each argument may be a string or any object supporting the buffer protocol.");
+
+static PyObject *
+AESGCM_decrypt_verify(AESGCM* self, PyObject* args) {
+    PyObject *objs[3];
+    objs[2] = NULL;
+    if (!PyArg_ParseTuple(args, "OO|O:decrypt_and_verify", &objs[0], &objs[1], &objs[2]))
+        return NULL;
+    if (!self->iv) {
+        PyErr_SetString(aesgcm_error, "Precondition violation: decrypt_and_verify() needs the iv to have been passed to the constructor; use decrypt() instead.");
+        return NULL;
+    }
+    size_t n = objs[2] ? 3 : 2;
+    Py_buffer views[3];
+    bool pinned;
+    if (AESGCM_get_buffers(objs, views, n, &pinned))
+        return NULL;
+
+    Py_buffer nonce, noaad;
+    PyBuffer_FillInfo(&nonce, NULL, const_cast<char*>(self->iv->data()), self->iv->size(), 1, PyBUF_SIMPLE);
+    PyBuffer_FillInfo(&noaad, NULL, const_cast<char*>(""), 0, 1, PyBUF_SIMPLE);
+    PyObject* result = AESGCM_decrypt_views(self, nonce, n == 3 ? views[2] : noaad, views[0], views[1], pinned);
+    AESGCM_release_buffers(views, n);
+    return result;
+}
+
+PyDoc_STRVAR(AESGCM_decrypt_verify__doc__,
+"Like decrypt(), but with the nonce that was passed to the constructor.\n\
+Deprecated: use decrypt().\n\
+\n\
+@param ct: the ciphertext\n\
+@param tag: the tag\n\
+@param aad: the additional authenticated data (default: empty)");
+
+static PyObject *
+AESGCM_stream(AESGCM* self, PyObject* args, PyObject* kwdict, bool encrypting) {
+    static const char *kwlist[] = { "nonce", "aad", NULL };
+    PyObject *objs[2];
+    objs[1] = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, encrypting ? "O|O:encryptor" : "O|O:decryptor", const_cast<char**>(kwlist), &objs[0], &objs[1]))
+        return NULL;
+    const size_t n = objs[1] ? 2 : 1;
+    Py_buffer views[2];
+    bool pinned;
+    if (AESGCM_get_buffers(objs, views, n, &pinned))
+        return NULL;
+    if (AESGCM_check_nonce(&views[0])) {
+        AESGCM_release_buffers(views, n);
+        return NULL;
+    }
+
+    AESGCMStream* stream = PyObject_New(AESGCMStream, &AESGCMStream_type);
+    if (!stream) {
+        AESGCM_release_buffers(views, n);
+        return NULL;
+    }
+    stream->c = NULL;
+    stream->encrypting = encrypting;
+    stream->state = AESGCM_STREAM_AAD;
+    stream->tagsize = self->tagsize;
+    stream->lock = NULL;
+
+    std::string err;
+    ENTER_PYCRYPTOPP(self);
+    try {
+        /* A copy of a keyed object shares no state with it: the GHASH tables
+           and the key schedule are copied, and Resynchronize() points the
+           copy's CTR mode at its own block cipher. */
+        if (encrypting)
+            stream->c = new CryptoPP::GCM<CryptoPP::AES>::Encryption(*self->e);
+        else
+            stream->c = new CryptoPP::GCM<CryptoPP::AES>::Decryption(*self->d);
+    } catch (CryptoPP::Exception le) {
+        err = le.what();
+    }
+    LEAVE_PYCRYPTOPP(self);
+    if (err.empty()) {
+        try {
+            stream->c->Resynchronize(reinterpret_cast<const byte*>(views[0].buf), views[0].len);
+            if (n == 2)
+                stream->c->Update(reinterpret_cast<const byte*>(views[1].buf), views[1].len);
+        } catch (CryptoPP::Exception le) {
+            err = le.what();
+        }
+    }
+    AESGCM_release_buffers(views, n);
+
+    if (!err.empty()) {
+        Py_DECREF(stream);
+        return PyErr_Format(aesgcm_error, "Crypto++ gave this exception: %s", err.c_str());
+    }
+    return reinterpret_cast<PyObject*>(stream);
+}
+
+static PyObject *
+AESGCM_encryptor(AESGCM* self, PyObject* args, PyObject* kwdict) {
+    return AESGCM_stream(self, args, kwdict, true);
+}
+
+PyDoc_STRVAR(AESGCM_encryptor__doc__,
+"Start encrypting a message piecewise, returning an AESGCMStream.\n\
+\n\
+@param nonce: a string that is never used twice with the same key\n\
+@param aad: the start of the additional authenticated data (default: empty)");
+
+static PyObject *
+AESGCM_decryptor(AESGCM* self, PyObject* args, PyObject* kwdict) {
+    return AESGCM_stream(self, args, kwdict, false);
+}
+
+PyDoc_STRVAR(AESGCM_decryptor__doc__,
+"Start decrypting a message piecewise, returning an AESGCMStream.\n\
+\n\
+@param nonce: the nonce the message was encrypted with\n\
+@param aad: the start of the additional authenticated data (default: empty)");
 
 static PyMethodDef AESGCM_methods[] = {
-    {"decrypt_and_verify", reinterpret_cast<PyCFunction>(AESGCM_decrypt_verify), METH_VARARGS , AESGCM_process__doc__},
+    {"encrypt", reinterpret_cast<PyCFunction>(AESGCM_encrypt), METH_VARARGS, AESGCM_encrypt__doc__},
+    {"decrypt", reinterpret_cast<PyCFunction>(AESGCM_decrypt), METH_VARARGS, AESGCM_decrypt__doc__},
+    {"encryptor", reinterpret_cast<PyCFunction>(AESGCM_encryptor), METH_VARARGS | METH_KEYWORDS, AESGCM_encryptor__doc__},
+    {"decryptor", reinterpret_cast<PyCFunction>(AESGCM_decryptor), METH_VARARGS | METH_KEYWORDS, AESGCM_decryptor__doc__},
+    {"decrypt_and_verify", reinterpret_cast<PyCFunction>(AESGCM_decrypt_verify), METH_VARARGS, AESGCM_decrypt_verify__doc__},
     {NULL},
 };
 
@@ -68,7 +652,12 @@ AESGCM_new(PyTypeObject* type, PyObject *args, PyObject *kwdict) {
     AESGCM* self = reinterpret_cast<AESGCM*>(type->tp_alloc(type, 0));
     if (!self)
         return NULL;
+    self->e = NULL;
     self->d = NULL;
+    self->tagsize = 16;
+    self->ghash = NULL;
+    self->iv = NULL;
+    self->lock = NULL;
     return reinterpret_cast<PyObject*>(self);
 }
 
@@ -76,45 +665,107 @@ static void
 AESGCM_dealloc(PyObject* self) {
     if (reinterpret_cast<AESGCM*>(self)->e)
         delete reinterpret_cast<AESGCM*>(self)->e;
+    if (reinterpret_cast<AESGCM*>(self)->d)
+        delete reinterpret_cast<AESGCM*>(self)->d;
+    if (reinterpret_cast<AESGCM*>(self)->iv)
+        delete reinterpret_cast<AESGCM*>(self)->iv;
+    PYCRYPTOPP_FREE_LOCK(reinterpret_cast<AESGCM*>(self));
     self->ob_type->tp_free(self);
 }
 
 static int
 AESGCM_init(PyObject* self, PyObject *args, PyObject *kwdict) {
-    static const char *kwlist[] = { "key", "iv", NULL };
+    static const char *kwlist[] = { "key", "iv", "tagsize", "ghash", NULL };
     const char *key = NULL;
     Py_ssize_t keysize = 0;
     const char *iv = NULL;
-    const char defaultiv[CryptoPP::AES::BLOCKSIZE] = {0};
     Py_ssize_t ivsize = 0;
-    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#|t#:AESGCM.__init__", const_cast<char**>(kwlist), &key, &keysize, &iv, &ivsize))
+    int tagsize = 16;
+    const char *ghash = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#|z#iz:AESGCM.__init__", const_cast<char**>(kwlist), &key, &keysize, &iv, &ivsize, &tagsize, &ghash))
         return -1;
     assert (keysize >= 0);
     assert (ivsize >= 0);
 
-    if (!iv)
-        iv = defaultiv;
-    else if (ivsize != 16) {
-        //PyErr_Format(aes_error, "Precondition violation: if an IV is passed, it must be exactly 16 bytes, not %d", ivsize);
-        //return -1;
+    /* Checked here rather than left to Crypto++, which crashes on a
+       zero-length AES key. */
+    if (keysize != 16 && keysize != 24 && keysize != 32) {
+        PyErr_Format(aesgcm_error, "Precondition violation: you are required to pass a valid key size (16, 24 or 32 bytes), not %zd bytes.", keysize);
+        return -1;
     }
+    if (iv && ivsize < 1) {
+        PyErr_SetString(aesgcm_error, "Precondition violation: if an IV is passed, it is required to be at least one byte long.");
+        return -1;
+    }
+    if (tagsize < 12 || tagsize > 16) {
+        PyErr_Format(aesgcm_error, "Precondition violation: tagsize is required to be from 12 to 16, not %d", tagsize);
+        return -1;
+    }
+
+    bool useclmul = ghash_clmul_available();
+    int tablesize = 2*1024;
+    if (ghash) {
+        if (!strcmp(ghash, "clmul")) {
+            if (!useclmul) {
+                PyErr_SetString(aesgcm_error, "Precondition violation: ghash='clmul' was requested, but this CPU (or this build of Crypto++) does not support it.");
+                return -1;
+            }
+        } else if (!strcmp(ghash, "2k") || !strcmp(ghash, "64k")) {
+            useclmul = false;
+            tablesize = ghash[0] == '2' ? 2*1024 : 64*1024;
+        } else {
+            PyErr_Format(aesgcm_error, "Precondition violation: ghash is required to be None, 'clmul', '2k' or '64k', not '%s'", ghash);
+            return -1;
+        }
+    }
+#ifndef CRYPTOPP_GCM_OPTIONAL_CLMUL
+    /* This Crypto++ uses CLMUL whenever the CPU has it. */
+    useclmul = ghash_clmul_available();
+#endif
+
+    AESGCM* mself = reinterpret_cast<AESGCM*>(self);
+    if (useclmul)
+        mself->ghash = "clmul";
+    else if (tablesize == 2*1024)
+        mself->ghash = ghash_sse2_tables_available() ? "2k-sse2" : "2k";
+    else
+        mself->ghash = ghash_sse2_tables_available() ? "64k-sse2" : "64k";
+
+    /* Crypto++ insists on an IV along with the key; every message replaces
+       it with its own nonce. Which of the other parameters Crypto++ looks at
+       depends on the CPU, so none of them has to be used. */
+    const byte placeholderiv[12] = {0};
+    CryptoPP::AlgorithmParameters params = CryptoPP::MakeParameters(CryptoPP::Name::IV(), CryptoPP::ConstByteArrayParameter(placeholderiv, sizeof(placeholderiv)))
+        (CryptoPP::Name::TableSize(), tablesize, false)
+#ifdef CRYPTOPP_GCM_OPTIONAL_CLMUL
+        (CryptoPP::Name::UseCLMUL(), useclmul, false)
+#endif
+        ;
     try {
-        //reinterpret_cast<AESGCM*>(self)->d = new CryptoPP::GCM<CryptoPP::AES>::Decryption(reinterpret_cast<const byte*>(key), keysize, reinterpret_cast<const byte*>(iv));
-        reinterpret_cast<AESGCM*>(self)->d = new CryptoPP::GCM<CryptoPP::AES>::Decryption();
-	reinterpret_cast<AESGCM*>(self)->d->SetKeyWithIV(reinterpret_cast<const byte*>(key), keysize, reinterpret_cast<const byte*>(iv), ivsize);
-	reinterpret_cast<AESGCM*>(self)->iv = reinterpret_cast<const byte*>(iv);
- 	reinterpret_cast<AESGCM*>(self)->ivsize = ivsize;
+        mself->e = new CryptoPP::GCM<CryptoPP::AES>::Encryption();
+        mself->e->SetKey(reinterpret_cast<const byte*>(key), keysize, params);
+        mself->d = new CryptoPP::GCM<CryptoPP::AES>::Decryption();
+        mself->d->SetKey(reinterpret_cast<const byte*>(key), keysize, params);
     } catch (CryptoPP::InvalidKeyLength le) {
         PyErr_Format(aesgcm_error, "Precondition violation: you are required to pass a valid key size.  Crypto++ gave this exception: %s", le.what());
         return -1;
     }
-    if (!reinterpret_cast<AESGCM*>(self)->d) {
-        PyErr_NoMemory();
-        return -1;
-    }
+    if (iv)
+        mself->iv = new std::string(iv, ivsize);
+    mself->tagsize = tagsize;
     return 0;
 }
 
+static PyObject *
+AESGCM_get_ghash(AESGCM* self, void* closure) {
+    return PyString_FromString(self->ghash ? self->ghash : "");
+}
+
+static PyGetSetDef AESGCM_getset[] = {
+    {const_cast<char*>("ghash"), reinterpret_cast<getter>(AESGCM_get_ghash), NULL, const_cast<char*>("the GHASH implementation in use: 'clmul', '2k', '2k-sse2', '64k' or '64k-sse2'"), NULL},
+    {NULL},
+};
+
 static PyTypeObject AESGCM_type = {
     PyObject_HEAD_INIT(NULL)
     0,                         /*ob_size*/
@@ -146,7 +797,7 @@ static PyTypeObject AESGCM_type = {
     0,		               /* tp_iternext */
     AESGCM_methods,      /* tp_methods */
     0,                         /* tp_members */
-    0,                         /* tp_getset */
+    AESGCM_getset,             /* tp_getset */
     0,                         /* tp_base */
     0,                         /* tp_dict */
     0,                         /* tp_descr_get */
@@ -164,10 +815,13 @@ init_aesgcm(PyObject*const module) {
     Py_INCREF(&AESGCM_type);
     PyModule_AddObject(module, "aesgcm_AESGCM", (PyObject *)&AESGCM_type);
 
+    if (PyType_Ready(&AESGCMStream_type) < 0)
+        return;
+    Py_INCREF(&AESGCMStream_type);
+    PyModule_AddObject(module, "aesgcm_AESGCMStream", (PyObject *)&AESGCMStream_type);
+
     aesgcm_error = PyErr_NewException(const_cast<char*>("_aesgcm.Error"), NULL, NULL);
     PyModule_AddObject(module, "aesgcm_Error", aesgcm_error);
 
     PyModule_AddStringConstant(module, "aesgcm___doc__", const_cast<char*>(aesgcm___doc__));
 }
-
-
@@ -9,6 +9,9 @@ typedef int Py_ssize_t;
 #endif
 
 #include "aesmodule.hpp"
+#include "../buffers.hpp"
+#include "../gil.hpp"
+#include "../workerpool.hpp"
 
 
 /* from Crypto++ */
@@ -25,11 +28,26 @@ You are advised to run aes.start_up_self_test() after importing this module.";
 
 static PyObject *aes_error;
 
+/* Inputs processed in parallel are cut into slices of at least this many
+   bytes, so that each thread has enough work to be worth waking up. */
+#define AES_MIN_PARALLEL_SLICE (64*1024)
+
 typedef struct {
     PyObject_HEAD
 
     /* internal */
     CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption * e;
+    PyThread_type_lock lock;
+    /* the current position in the key stream, for tell() */
+    CryptoPP::lword pos;
+
+    /* Parallel mode. `cipher' is NULL unless it is enabled; it is a key
+       schedule that the worker threads share, each running its own CTR mode
+       object over it, starting from `iv'. */
+    CryptoPP::AES::Encryption * cipher;
+    byte iv[CryptoPP::AES::BLOCKSIZE];
+    Py_ssize_t parallel_threshold;
+    unsigned int threads;
 } AES;
 
 PyDoc_STRVAR(AES__doc__,
@@ -50,40 +68,242 @@ this:\n\
 Where 'masterkey' is a secret key used only for generating onetimekeys this\
 way, and 'nonce' is a value that is guaranteed to never repeat.\
 \n\
-@param key: the symmetric encryption key; a string of exactly 16 or 32 bytes\
+@param key: the symmetric encryption key; a string of exactly 16 or 32 bytes\n\
+@param iv: the initial counter block; a string of exactly 16 bytes\n\
+    (default: all zero bytes)\n\
+@param parallel_threshold: if not None, calls that process at least this\n\
+    many bytes at once (and at least 128 KiB) split the work across several\n\
+    threads, with the GIL released; the output is exactly what a single\n\
+    thread would produce (default: None, meaning never)\n\
+@param threads: the most threads to use for one call in parallel mode,\n\
+    including the calling thread (default: 0, meaning one per processor)\
 ");
 
+typedef struct {
+    CryptoPP::AES::Encryption* cipher;
+    const byte* iv;
+    byte* out;
+    const byte* in;
+    size_t len;
+    CryptoPP::lword start;
+    size_t nslices;
+    bool failed;
+} AES_ParallelJob;
+
+/** The start of slice i of job, relative to job->in. Every slice but the
+    last is a whole number of blocks, and every slice but the first starts on
+    a block boundary of the key stream. */
+static size_t
+AES_slice_begin(const AES_ParallelJob* job, size_t i) {
+    if (i == 0)
+        return 0;
+    if (i == job->nslices)
+        return job->len;
+    size_t begin = job->len / job->nslices * i;
+    return begin - static_cast<size_t>((job->start + begin) % CryptoPP::AES::BLOCKSIZE);
+}
+
+/** A pycryptopp_task_fn: process slice i of the AES_ParallelJob ctx. */
+static void
+AES_process_slice(void* ctx, size_t i) {
+    AES_ParallelJob* job = reinterpret_cast<AES_ParallelJob*>(ctx);
+    const size_t begin = AES_slice_begin(job, i);
+    const size_t end = AES_slice_begin(job, i+1);
+    try {
+        CryptoPP::CTR_Mode_ExternalCipher::Encryption ctr(*job->cipher, job->iv);
+        ctr.Seek(job->start + begin);
+        ctr.ProcessData(job->out + begin, job->in + begin, end - begin);
+    } catch (...) {
+        job->failed = true;
+    }
+}
+
+/** This function is only for internal use by aesmodule.cpp. Process len
+    bytes at key stream offset start on up to self->threads threads, leaving
+    self->e in an unspecified position. Call without the GIL. */
+static void
+AES_process_parallel(AES* self, byte* out, const byte* in, size_t len, CryptoPP::lword start) {
+    AES_ParallelJob job;
+    job.cipher = self->cipher;
+    job.iv = self->iv;
+    job.out = out;
+    job.in = in;
+    job.len = len;
+    job.start = start;
+    job.nslices = len / AES_MIN_PARALLEL_SLICE;
+    if (job.nslices > self->threads)
+        job.nslices = self->threads;
+    job.failed = false;
+    pycryptopp_parallel_run(AES_process_slice, &job, job.nslices);
+    if (job.failed) {
+        /* Out of memory in some thread, most likely. Redo it all here. */
+        self->e->Seek(start);
+        self->e->ProcessData(out, in, len);
+    }
+}
+
+/**
+ * This function is only for internal use by aesmodule.cpp. If at is not NULL
+ * the bytes are processed at key stream offset *at and the current position
+ * is left alone; otherwise they are processed at, and advance, the current
+ * position.
+ */
+static void
+AES_process_locked(AES* self, byte* out, const byte* in, Py_ssize_t len, bool pinned, const CryptoPP::lword* at) {
+    /* Crypto++'s ProcessData() must not be given zero bytes while it holds
+       part of a keystream block, as it does after an unaligned seek. */
+    if (len == 0)
+        return;
+    if (pinned) {
+        PYCRYPTOPP_LOCK_IF_LARGE(self, len);
+    }
+    ENTER_PYCRYPTOPP(self);
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && PYCRYPTOPP_RELEASE_GIL_FOR(self, len))
+    if (pinned && self->cipher && len >= self->parallel_threshold && self->threads > 1 && len >= 2*AES_MIN_PARALLEL_SLICE) {
+        AES_process_parallel(self, out, in, len, at ? *at : self->pos);
+        if (!at)
+            self->pos += len;
+        self->e->Seek(self->pos);
+    } else if (at) {
+        self->e->Seek(*at);
+        self->e->ProcessData(out, in, len);
+        self->e->Seek(self->pos);
+    } else {
+        self->e->ProcessData(out, in, len);
+        self->pos += len;
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    LEAVE_PYCRYPTOPP(self);
+}
+
 static PyObject *
 AES_process(AES* self, PyObject* msgobj) {
-    if (!PyString_CheckExact(msgobj)) {
-        PyStringObject* typerepr = reinterpret_cast<PyStringObject*>(PyObject_Repr(reinterpret_cast<PyObject*>(msgobj->ob_type)));
-        if (typerepr) {
-            PyErr_Format(aes_error, "Precondition violation: you are required to pass a Python string object (not a unicode, a subclass of string, or anything else), but you passed %s.", PyString_AS_STRING(reinterpret_cast<PyObject*>(typerepr)));
-            Py_DECREF(typerepr);
-        } else
-            PyErr_Format(aes_error, "Precondition violation: you are required to pass a Python string object (not a unicode, a subclass of string, or anything else).");
+    Py_buffer msg;
+    bool pinned;
+    if (pycryptopp_get_read_buffer(msgobj, &msg, &pinned, aes_error))
+        return NULL;
+    assert (msg.len >= 0);
+
+    PyStringObject* result = reinterpret_cast<PyStringObject*>(PyString_FromStringAndSize(NULL, msg.len));
+    if (result)
+        AES_process_locked(self, reinterpret_cast<byte*>(PyString_AS_STRING(result)), reinterpret_cast<const byte*>(msg.buf), msg.len, pinned, NULL);
+    PyBuffer_Release(&msg);
+    return reinterpret_cast<PyObject*>(result);
+}
+
+PyDoc_STRVAR(AES_process__doc__,
+"Encrypt or decrypt the next bytes, returning the result.\n\
+\n\
+@param msg: a string, or any object supporting the buffer protocol (such as\n\
+    a bytearray, memoryview or mmap) -- it is read in place, not copied");
+
+static PyObject *
+AES_process_into(AES* self, PyObject* args) {
+    PyObject *srcobj, *dstobj;
+    if (!PyArg_ParseTuple(args, "OO:process_into", &srcobj, &dstobj))
+        return NULL;
+
+    Py_buffer src, dst;
+    bool srcpinned, dstpinned;
+    if (pycryptopp_get_read_buffer(srcobj, &src, &srcpinned, aes_error))
+        return NULL;
+    if (pycryptopp_get_write_buffer(dstobj, &dst, &dstpinned, aes_error)) {
+        PyBuffer_Release(&src);
         return NULL;
     }
+    if (dst.len < src.len) {
+        PyErr_Format(aes_error, "Precondition violation: the output buffer is required to be at least as long as the input (%zd bytes), but it was %zd bytes.", src.len, dst.len);
+        PyBuffer_Release(&src);
+        PyBuffer_Release(&dst);
+        return NULL;
+    }
+
+    Py_ssize_t len = src.len;
+    AES_process_locked(self, reinterpret_cast<byte*>(dst.buf), reinterpret_cast<const byte*>(src.buf), len, srcpinned && dstpinned, NULL);
+    PyBuffer_Release(&src);
+    PyBuffer_Release(&dst);
+    return PyInt_FromSsize_t(len);
+}
 
-    const char *msg;
-    Py_ssize_t msgsize;
-    if (PyString_AsStringAndSize(msgobj, const_cast<char**>(&msg), &msgsize))
+PyDoc_STRVAR(AES_process_into__doc__,
+"Encrypt or decrypt the next len(src) bytes of src into the beginning of dst,\n\
+returning the number of bytes written.\n\
+\n\
+@param src: a string or any object supporting the buffer protocol\n\
+@param dst: a writable object supporting the buffer protocol, at least as\n\
+    long as src; it may be the same object as src (to work in place), but\n\
+    must not otherwise overlap it");
+
+static PyObject *
+AES_process_at(AES* self, PyObject* args) {
+    PyObject *offsetobj, *msgobj;
+    if (!PyArg_ParseTuple(args, "OO:process_at", &offsetobj, &msgobj))
+        return NULL;
+    unsigned PY_LONG_LONG offset;
+    if (pycryptopp_get_offset(offsetobj, &offset, aes_error))
         return NULL;
-    assert (msgsize >= 0);
 
-    PyStringObject* result = reinterpret_cast<PyStringObject*>(PyString_FromStringAndSize(NULL, msgsize));
-    if (!result)
+    Py_buffer msg;
+    bool pinned;
+    if (pycryptopp_get_read_buffer(msgobj, &msg, &pinned, aes_error))
         return NULL;
+    assert (msg.len >= 0);
 
-    self->e->ProcessData(reinterpret_cast<byte*>(PyString_AS_STRING(result)), reinterpret_cast<const byte*>(msg), msgsize);
+    const CryptoPP::lword at = offset;
+    PyStringObject* result = reinterpret_cast<PyStringObject*>(PyString_FromStringAndSize(NULL, msg.len));
+    if (result)
+        AES_process_locked(self, reinterpret_cast<byte*>(PyString_AS_STRING(result)), reinterpret_cast<const byte*>(msg.buf), msg.len, pinned, &at);
+    PyBuffer_Release(&msg);
     return reinterpret_cast<PyObject*>(result);
 }
 
-PyDoc_STRVAR(AES_process__doc__,
-"Encrypt or decrypt the next bytes, returning the result.");
+PyDoc_STRVAR(AES_process_at__doc__,
+"Encrypt or decrypt msg as if it were found at byte offset `offset' of the\n\
+stream, returning the result. This costs the same as .process(msg) however\n\
+large offset is, and does not change the current position.\n\
+\n\
+@param offset: a non-negative integer\n\
+@param msg: a string or any object supporting the buffer protocol");
+
+static PyObject *
+AES_seek(AES* self, PyObject* offsetobj) {
+    unsigned PY_LONG_LONG offset;
+    if (pycryptopp_get_offset(offsetobj, &offset, aes_error))
+        return NULL;
+
+    ENTER_PYCRYPTOPP(self);
+    self->e->Seek(offset);
+    self->pos = offset;
+    LEAVE_PYCRYPTOPP(self);
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(AES_seek__doc__,
+"Move to byte offset `offset' of the stream, so that the next call to\n\
+.process() continues from there. Seeking is cheap: it does not generate the\n\
+skipped key stream.\n\
+\n\
+@param offset: a non-negative integer");
+
+static PyObject *
+AES_tell(AES* self, PyObject* dummy) {
+    ENTER_PYCRYPTOPP(self);
+    const CryptoPP::lword pos = self->pos;
+    LEAVE_PYCRYPTOPP(self);
+    return PyLong_FromUnsignedLongLong(pos);
+}
+
+PyDoc_STRVAR(AES_tell__doc__,
+"Return the current byte offset in the stream: the number of bytes processed\n\
+since the object was created or since the last .seek(), plus that seek's\n\
+offset.");
 
 static PyMethodDef AES_methods[] = {
     {"process", reinterpret_cast<PyCFunction>(AES_process), METH_O, AES_process__doc__},
+    {"process_into", reinterpret_cast<PyCFunction>(AES_process_into), METH_VARARGS, AES_process_into__doc__},
+    {"process_at", reinterpret_cast<PyCFunction>(AES_process_at), METH_VARARGS, AES_process_at__doc__},
+    {"seek", reinterpret_cast<PyCFunction>(AES_seek), METH_O, AES_seek__doc__},
+    {"tell", reinterpret_cast<PyCFunction>(AES_tell), METH_NOARGS, AES_tell__doc__},
     {NULL},
 };
 
@@ -93,6 +313,11 @@ AES_new(PyTypeObject* type, PyObject *args, PyObject *kwdict) {
     if (!self)
         return NULL;
     self->e = NULL;
+    self->lock = NULL;
+    self->pos = 0;
+    self->cipher = NULL;
+    self->parallel_threshold = 0;
+    self->threads = 0;
     return reinterpret_cast<PyObject*>(self);
 }
 
@@ -100,22 +325,42 @@ static void
 AES_dealloc(PyObject* self) {
     if (reinterpret_cast<AES*>(self)->e)
         delete reinterpret_cast<AES*>(self)->e;
+    if (reinterpret_cast<AES*>(self)->cipher)
+        delete reinterpret_cast<AES*>(self)->cipher;
+    PYCRYPTOPP_FREE_LOCK(reinterpret_cast<AES*>(self));
     self->ob_type->tp_free(self);
 }
 
 static int
 AES_init(PyObject* self, PyObject *args, PyObject *kwdict) {
-    static const char *kwlist[] = { "key", "iv", NULL };
+    static const char *kwlist[] = { "key", "iv", "parallel_threshold", "threads", NULL };
     const char *key = NULL;
     Py_ssize_t keysize = 0;
     const char *iv = NULL;
     const char defaultiv[CryptoPP::AES::BLOCKSIZE] = {0};
     Py_ssize_t ivsize = 0;
-    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#|t#:AES.__init__", const_cast<char**>(kwlist), &key, &keysize, &iv, &ivsize))
+    PyObject *thresholdobj = Py_None;
+    int threads = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#|t#Oi:AES.__init__", const_cast<char**>(kwlist), &key, &keysize, &iv, &ivsize, &thresholdobj, &threads))
         return -1;
     assert (keysize >= 0);
     assert (ivsize >= 0);
 
+    Py_ssize_t threshold = -1;
+    if (thresholdobj != Py_None) {
+        threshold = PyNumber_AsSsize_t(thresholdobj, PyExc_OverflowError);
+        if (threshold == -1 && PyErr_Occurred())
+            return -1;
+        if (threshold < 0) {
+            PyErr_Format(aes_error, "Precondition violation: parallel_threshold is required to be None or non-negative, not %zd", threshold);
+            return -1;
+        }
+    }
+    if (threads < 0) {
+        PyErr_Format(aes_error, "Precondition violation: threads is required to be non-negative, not %d", threads);
+        return -1;
+    }
+
     if (!iv)
         iv = defaultiv;
     else if (ivsize != 16) {
@@ -132,6 +377,15 @@ AES_init(PyObject* self, PyObject *args, PyObject *kwdict) {
         PyErr_NoMemory();
         return -1;
     }
+
+    if (threshold >= 0) {
+        AES* mself = reinterpret_cast<AES*>(self);
+        /* The key has already been checked by the constructor above. */
+        mself->cipher = new CryptoPP::AES::Encryption(reinterpret_cast<const byte*>(key), keysize);
+        memcpy(mself->iv, iv, CryptoPP::AES::BLOCKSIZE);
+        mself->parallel_threshold = threshold;
+        mself->threads = threads ? threads : pycryptopp_cpu_count();
+    }
     return 0;
 }
 
@@ -9,10 +9,15 @@ typedef int Py_ssize_t;
 #endif
 
 #include "xsalsa20module.hpp"
+#include "../buffers.hpp"
+#include "../gil.hpp"
+#include "../cpufeatures.hpp"
 
 #ifdef DISABLE_EMBEDDED_CRYPTOPP
+#include <cryptopp/algparam.h>
 #include <cryptopp/salsa.h>
 #else
+#include <src-cryptopp/algparam.h>
 #include <src-cryptopp/salsa.h>
 #endif
 
@@ -26,6 +31,11 @@ typedef struct {
 	/* internal */
 //	CryptoPP::CTR_Mode<CryptoPP::XSalsa20>::Encryption *e;
 	CryptoPP::XSalsa20::Encryption *e;
+	PyThread_type_lock lock;
+	/* the current position in the key stream, for tell() */
+	CryptoPP::lword pos;
+	/* the keystream kernel that e uses, for the kernel attribute */
+	const char * kernel;
 } XSalsa20;
 
 PyDoc_STRVAR(XSalsa20__doc__,
@@ -35,38 +45,165 @@ This object encrypts/decrypts in CTR mode, using a counter that is initialized\n
 to zero when you instantiate the object. Successive calls to .process() will \n\
 use the current counter and increment it.\n\
 \n\
+@param key: the 32-byte key\n\
+@param iv: the 24-byte nonce (default: all zeroes)\n\
+@param kernel: how many keystream blocks to compute at once: 'avx2' for 8,\n\
+    'sse2' for 4 or 'serial' for one at a time; or None for the most that\n\
+    the CPU can do (default: None). Every kernel gives the same keystream;\n\
+    the .kernel attribute tells which one is in use.\n\
 ");
 
+/**
+ * This function is only for internal use by xsalsa20module.cpp. If at is not
+ * NULL the bytes are processed at key stream offset *at and the current
+ * position is left alone; otherwise they are processed at, and advance, the
+ * current position.
+ */
+static void XSalsa20_process_locked(XSalsa20* self, byte* out, const byte* in, Py_ssize_t len, bool pinned, const CryptoPP::lword* at) {
+	/* Crypto++'s ProcessString() must not be given zero bytes while it holds
+	   part of a keystream block, as it does after an unaligned seek. */
+	if (len == 0)
+		return;
+	if (pinned) {
+		PYCRYPTOPP_LOCK_IF_LARGE(self, len);
+	}
+	ENTER_PYCRYPTOPP(self);
+	PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && PYCRYPTOPP_RELEASE_GIL_FOR(self, len))
+	if (at) {
+		self->e->Seek(*at);
+		self->e->ProcessString(out, in, len);
+		self->e->Seek(self->pos);
+	} else {
+		self->e->ProcessString(out, in, len);
+		self->pos += len;
+	}
+	PYCRYPTOPP_END_ALLOW_THREADS
+	LEAVE_PYCRYPTOPP(self);
+}
+
 static PyObject *XSalsa20_process(XSalsa20* self, PyObject* msgobj) {
-	if(!PyString_CheckExact(msgobj)) {
-		PyStringObject* typerepr = reinterpret_cast<PyStringObject*>(PyObject_Repr(reinterpret_cast<PyObject*>(msgobj->ob_type)));
-		if (typerepr) {
-			PyErr_Format(xsalsa20_error, "Precondition violation: you are required to pass a Python string object (not a unicode, a subclass of string, or anything else), but you passed %s.", PyString_AS_STRING(reinterpret_cast<PyObject*>(typerepr)));
-			Py_DECREF(typerepr);
-		} else
-			PyErr_Format(xsalsa20_error, "Precondition violation: you are required to pass a Python string object (not a unicode, a subclass of string, or anything else).");
+	Py_buffer msg;
+	bool pinned;
+	if (pycryptopp_get_read_buffer(msgobj, &msg, &pinned, xsalsa20_error))
+		return NULL;
+	assert (msg.len >= 0);
+
+	PyStringObject* result = reinterpret_cast<PyStringObject*>(PyString_FromStringAndSize(NULL, msg.len));
+	if (result)
+		XSalsa20_process_locked(self, reinterpret_cast<byte*>(PyString_AS_STRING(result)), reinterpret_cast<const byte*>(msg.buf), msg.len, pinned, NULL);
+	PyBuffer_Release(&msg);
+	return reinterpret_cast<PyObject*>(result);
+}
+
+PyDoc_STRVAR(XSalsa20_process__doc__,
+"Encrypt or decrypt the next bytes, returning the result.\n\
+\n\
+@param msg: a string, or any object supporting the buffer protocol (such as\n\
+    a bytearray, memoryview or mmap) -- it is read in place, not copied");
+
+static PyObject *XSalsa20_process_into(XSalsa20* self, PyObject* args) {
+	PyObject *srcobj, *dstobj;
+	if (!PyArg_ParseTuple(args, "OO:process_into", &srcobj, &dstobj))
+		return NULL;
+
+	Py_buffer src, dst;
+	bool srcpinned, dstpinned;
+	if (pycryptopp_get_read_buffer(srcobj, &src, &srcpinned, xsalsa20_error))
+		return NULL;
+	if (pycryptopp_get_write_buffer(dstobj, &dst, &dstpinned, xsalsa20_error)) {
+		PyBuffer_Release(&src);
+		return NULL;
+	}
+	if (dst.len < src.len) {
+		PyErr_Format(xsalsa20_error, "Precondition violation: the output buffer is required to be at least as long as the input (%zd bytes), but it was %zd bytes.", src.len, dst.len);
+		PyBuffer_Release(&src);
+		PyBuffer_Release(&dst);
 		return NULL;
 	}
 
-	const char* msg;
-	Py_ssize_t msgsize;
-	if (PyString_AsStringAndSize(msgobj, const_cast<char**>(&msg), &msgsize))
+	Py_ssize_t len = src.len;
+	XSalsa20_process_locked(self, reinterpret_cast<byte*>(dst.buf), reinterpret_cast<const byte*>(src.buf), len, srcpinned && dstpinned, NULL);
+	PyBuffer_Release(&src);
+	PyBuffer_Release(&dst);
+	return PyInt_FromSsize_t(len);
+}
+
+PyDoc_STRVAR(XSalsa20_process_into__doc__,
+"Encrypt or decrypt the next len(src) bytes of src into the beginning of dst,\n\
+returning the number of bytes written.\n\
+\n\
+@param src: a string or any object supporting the buffer protocol\n\
+@param dst: a writable object supporting the buffer protocol, at least as\n\
+    long as src; it may be the same object as src (to work in place), but\n\
+    must not otherwise overlap it");
+
+static PyObject *XSalsa20_process_at(XSalsa20* self, PyObject* args) {
+	PyObject *offsetobj, *msgobj;
+	if (!PyArg_ParseTuple(args, "OO:process_at", &offsetobj, &msgobj))
+		return NULL;
+	unsigned PY_LONG_LONG offset;
+	if (pycryptopp_get_offset(offsetobj, &offset, xsalsa20_error))
 		return NULL;
-	assert (msgsize >= 0);
 
-	PyStringObject* result = reinterpret_cast<PyStringObject*>(PyString_FromStringAndSize(NULL, msgsize));
-	if (!result)
+	Py_buffer msg;
+	bool pinned;
+	if (pycryptopp_get_read_buffer(msgobj, &msg, &pinned, xsalsa20_error))
 		return NULL;
+	assert (msg.len >= 0);
 
-	self->e->ProcessString(reinterpret_cast<byte*>(PyString_AS_STRING(result)), reinterpret_cast<const byte*>(msg), msgsize);
+	const CryptoPP::lword at = offset;
+	PyStringObject* result = reinterpret_cast<PyStringObject*>(PyString_FromStringAndSize(NULL, msg.len));
+	if (result)
+		XSalsa20_process_locked(self, reinterpret_cast<byte*>(PyString_AS_STRING(result)), reinterpret_cast<const byte*>(msg.buf), msg.len, pinned, &at);
+	PyBuffer_Release(&msg);
 	return reinterpret_cast<PyObject*>(result);
 }
 
-PyDoc_STRVAR(XSalsa20_process__doc__,
-"Encrypt or decrypt the next bytes, returning the result.");
+PyDoc_STRVAR(XSalsa20_process_at__doc__,
+"Encrypt or decrypt msg as if it were found at byte offset `offset' of the\n\
+stream, returning the result. This costs the same as .process(msg) however\n\
+large offset is, and does not change the current position.\n\
+\n\
+@param offset: a non-negative integer\n\
+@param msg: a string or any object supporting the buffer protocol");
+
+static PyObject *XSalsa20_seek(XSalsa20* self, PyObject* offsetobj) {
+	unsigned PY_LONG_LONG offset;
+	if (pycryptopp_get_offset(offsetobj, &offset, xsalsa20_error))
+		return NULL;
+
+	ENTER_PYCRYPTOPP(self);
+	self->e->Seek(offset);
+	self->pos = offset;
+	LEAVE_PYCRYPTOPP(self);
+	Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(XSalsa20_seek__doc__,
+"Move to byte offset `offset' of the stream, so that the next call to\n\
+.process() continues from there. Seeking is cheap: it does not generate the\n\
+skipped key stream.\n\
+\n\
+@param offset: a non-negative integer");
+
+static PyObject *XSalsa20_tell(XSalsa20* self, PyObject* dummy) {
+	ENTER_PYCRYPTOPP(self);
+	const CryptoPP::lword pos = self->pos;
+	LEAVE_PYCRYPTOPP(self);
+	return PyLong_FromUnsignedLongLong(pos);
+}
+
+PyDoc_STRVAR(XSalsa20_tell__doc__,
+"Return the current byte offset in the stream: the number of bytes processed\n\
+since the object was created or since the last .seek(), plus that seek's\n\
+offset.");
 
 static PyMethodDef XSalsa20_methods[] = {
 	{"process", reinterpret_cast<PyCFunction>(XSalsa20_process), METH_O, XSalsa20_process__doc__},
+	{"process_into", reinterpret_cast<PyCFunction>(XSalsa20_process_into), METH_VARARGS, XSalsa20_process_into__doc__},
+	{"process_at", reinterpret_cast<PyCFunction>(XSalsa20_process_at), METH_VARARGS, XSalsa20_process_at__doc__},
+	{"seek", reinterpret_cast<PyCFunction>(XSalsa20_seek), METH_O, XSalsa20_seek__doc__},
+	{"tell", reinterpret_cast<PyCFunction>(XSalsa20_tell), METH_NOARGS, XSalsa20_tell__doc__},
 	{NULL},
 };
 
@@ -75,23 +212,28 @@ static PyObject* XSalsa20_new(PyTypeObject* type, PyObject *args, PyObject *kwdi
 	if (!self)
 		return NULL;
 	self->e = NULL;
+	self->lock = NULL;
+	self->pos = 0;
+	self->kernel = NULL;
 	return reinterpret_cast<PyObject*>(self);
 }
 
 static void XSalsa20_dealloc(PyObject* self) {
 	if (reinterpret_cast<XSalsa20*>(self)->e)
 		delete reinterpret_cast<XSalsa20*>(self)->e;
+	PYCRYPTOPP_FREE_LOCK(reinterpret_cast<XSalsa20*>(self));
 	self->ob_type->tp_free(self);
 }
 
 static int XSalsa20_init(PyObject* self, PyObject *args, PyObject *kwdict) {
-	static const char *kwlist[] = { "key", "iv", NULL};
+	static const char *kwlist[] = { "key", "iv", "kernel", NULL};
 	const char *key = NULL;
 	Py_ssize_t keysize = 0;
 	const char *iv = NULL;
 	const char defaultiv[24] = {0};
 	Py_ssize_t ivsize = 0;
-	if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#|t#:XSalsa20.__init__", const_cast<char**>(kwlist), &key, &keysize, &iv, &ivsize))
+	const char *kernel = NULL;
+	if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#|t#z:XSalsa20.__init__", const_cast<char**>(kwlist), &key, &keysize, &iv, &ivsize, &kernel))
 		return -1;
 	assert (keysize >= 0);
 	assert (ivsize >= 0);
@@ -103,8 +245,34 @@ static int XSalsa20_init(PyObject* self, PyObject *args, PyObject *kwdict) {
             return -1;
         }
 
+	const unsigned int most = xsalsa20_max_blocks_per_pass();
+	unsigned int blocksperpass = most;
+	if (kernel) {
+		if (!strcmp(kernel, "avx2"))
+			blocksperpass = 8;
+		else if (!strcmp(kernel, "sse2"))
+			blocksperpass = 4;
+		else if (!strcmp(kernel, "serial"))
+			blocksperpass = 1;
+		else {
+			PyErr_Format(xsalsa20_error, "Precondition violation: kernel is required to be None, 'avx2', 'sse2' or 'serial', not '%s'", kernel);
+			return -1;
+		}
+		if (blocksperpass > most || (blocksperpass != most && !xsalsa20_blocks_per_pass_selectable())) {
+			PyErr_Format(xsalsa20_error, "Precondition violation: kernel='%s' was requested, but this CPU (or this build of Crypto++) does not support it.", kernel);
+			return -1;
+		}
+	}
+
 	try {
-		reinterpret_cast<XSalsa20*>(self)->e = new CryptoPP::XSalsa20::Encryption(reinterpret_cast<const byte*>(key), keysize, reinterpret_cast<const byte*>(iv));
+		CryptoPP::XSalsa20::Encryption *e = new CryptoPP::XSalsa20::Encryption();
+		reinterpret_cast<XSalsa20*>(self)->e = e;
+		e->SetKey(reinterpret_cast<const byte*>(key), keysize, CryptoPP::MakeParameters(CryptoPP::Name::IV(), CryptoPP::ConstByteArrayParameter(reinterpret_cast<const byte*>(iv), 24))
+#ifdef CRYPTOPP_SALSA_SIMD_INTRINSICS
+			(CryptoPP::Name::BlocksPerPass(), (int)blocksperpass, false)
+#endif
+			);
+		reinterpret_cast<XSalsa20*>(self)->kernel = xsalsa20_kernel_name(e->OptimalBlockSize() / 64);
 	}
 	catch (CryptoPP::InvalidKeyLength le)
 	{
@@ -120,6 +288,16 @@ static int XSalsa20_init(PyObject* self, PyObject *args, PyObject *kwdict) {
 }
 
 
+static PyObject *
+XSalsa20_get_kernel(XSalsa20* self, void* closure) {
+	return PyString_FromString(self->kernel ? self->kernel : "");
+}
+
+static PyGetSetDef XSalsa20_getsets[] = {
+	{const_cast<char*>("kernel"), reinterpret_cast<getter>(XSalsa20_get_kernel), NULL, const_cast<char*>("the keystream kernel in use: 'avx2', 'sse2' or 'serial'"), NULL},
+	{NULL}
+};
+
 static PyTypeObject XSalsa20_type = {
 	PyObject_HEAD_INIT(NULL)
 	0,                       /*ob_size*/
@@ -151,7 +329,7 @@ static PyTypeObject XSalsa20_type = {
 	0,   			 /*tp_iternext*/
 	XSalsa20_methods,  	 /*tp_methods*/
 	0,   			 /*tp_members*/
-	0,    			 /*tp_getset*/
+	XSalsa20_getsets,	 /*tp_getset*/
 	0,   			 /*tp_base*/
 	0,   			 /*tp_dict*/
 	0,   			 /*tp_descr_get*/
@@ -0,0 +1,187 @@
+/**
+ * cpufeatures.cpp -- report which of Crypto++'s runtime-dispatched kernels
+ * are compiled in and which ones this CPU will actually run
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#if (PY_VERSION_HEX < 0x02050000)
+typedef int Py_ssize_t;
+#endif
+
+#include "cpufeatures.hpp"
+#include "hash/sha256mb.hpp"
+#include "hash/sha512module.hpp"
+#include "idamodule.hpp"
+
+/* from Crypto++ */
+#ifdef DISABLE_EMBEDDED_CRYPTOPP
+#include <cryptopp/config.h>
+#include <cryptopp/cpu.h>
+#include <cryptopp/salsa.h>
+#else
+#include <src-cryptopp/config.h>
+#include <src-cryptopp/cpu.h>
+#include <src-cryptopp/salsa.h>
+#endif
+
+USING_NAMESPACE(CryptoPP)
+
+/* The selection logic below mirrors the #if/Has*() ladders in rijndael.cpp,
+   gcm.cpp, sha.cpp, salsa.cpp and integer.cpp, so that it names the kernel those files pick.
+   sha256mb.cpp, idamodule.cpp and sha512module.cpp do their own choosing. */
+
+static const char*
+aes_kernel() {
+#ifdef CRYPTOPP_CPUID_AVAILABLE
+#if CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
+    if (HasAESNI())
+        return "aesni";
+#endif
+#if (CRYPTOPP_BOOL_SSE2_ASM_AVAILABLE || defined(CRYPTOPP_X64_MASM_AVAILABLE)) && !defined(CRYPTOPP_DISABLE_RIJNDAEL_ASM)
+    if (HasSSE2())
+        return "sse2";
+#endif
+#endif
+    return "table";
+}
+
+bool
+ghash_clmul_available() {
+#if defined(CRYPTOPP_CPUID_AVAILABLE) && CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
+    return HasCLMUL();
+#else
+    return false;
+#endif
+}
+
+bool
+ghash_sse2_tables_available() {
+#if defined(CRYPTOPP_CPUID_AVAILABLE) && (CRYPTOPP_BOOL_SSE2_ASM_AVAILABLE || defined(CRYPTOPP_X64_MASM_AVAILABLE))
+    return HasSSE2();
+#else
+    return false;
+#endif
+}
+
+static const char*
+ghash_kernel() {
+    if (ghash_clmul_available())
+        return "clmul";
+    if (ghash_sse2_tables_available())
+        return "sse2";
+    return "table";
+}
+
+static const char*
+sha256_kernel() {
+#if CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE
+    if (HasSHA())
+        return "shani";
+#endif
+#if defined(CRYPTOPP_X86_ASM_AVAILABLE) || defined(CRYPTOPP_X32_ASM_AVAILABLE) || defined(CRYPTOPP_X64_MASM_AVAILABLE)
+    return "asm";
+#else
+    return "portable";
+#endif
+}
+
+unsigned int
+xsalsa20_max_blocks_per_pass() {
+#if defined(CRYPTOPP_SALSA_SIMD_INTRINSICS)
+#if CRYPTOPP_BOOL_AVX2_INTRINSICS_AVAILABLE
+    if (HasAVX2())
+        return 8;
+#endif
+    return HasSSE2() ? 4 : 1;
+#elif defined(CRYPTOPP_X64_MASM_AVAILABLE)
+    return 4;
+#elif defined(CRYPTOPP_CPUID_AVAILABLE) && CRYPTOPP_BOOL_SSE2_ASM_AVAILABLE && !defined(CRYPTOPP_DISABLE_SALSA_ASM)
+    return HasSSE2() ? 4 : 1;
+#else
+    return 1;
+#endif
+}
+
+bool
+xsalsa20_blocks_per_pass_selectable() {
+#ifdef CRYPTOPP_SALSA_SIMD_INTRINSICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char*
+xsalsa20_kernel_name(unsigned int blocksperpass) {
+    if (blocksperpass >= 8)
+        return "avx2";
+    if (blocksperpass >= 4)
+        return "sse2";
+    return "serial";
+}
+
+static const char*
+integer_kernel() {
+#if defined(CRYPTOPP_X64_MASM_AVAILABLE) || (defined(CRYPTOPP_X64_ASM_AVAILABLE) && defined(__GNUC__) && defined(CRYPTOPP_WORD128_AVAILABLE))
+    return "x64";
+#elif defined(CRYPTOPP_CPUID_AVAILABLE) && CRYPTOPP_BOOL_SSE2_ASM_AVAILABLE && CRYPTOPP_BOOL_X86
+    if (HasSSE2())
+        return "sse2";
+    return "portable";
+#else
+    return "portable";
+#endif
+}
+
+PyObject *
+cpu_features(PyObject *dummy, PyObject *noargs) {
+    bool asm_enabled = false;
+#if defined(CRYPTOPP_X86_ASM_AVAILABLE) || defined(CRYPTOPP_X64_ASM_AVAILABLE) || defined(CRYPTOPP_X64_MASM_AVAILABLE)
+    asm_enabled = true;
+#endif
+
+    bool sse2 = false, ssse3 = false, aesni = false, clmul = false, sha = false, avx2 = false;
+#ifdef CRYPTOPP_CPUID_AVAILABLE
+    sse2 = HasSSE2();
+    ssse3 = HasSSSE3();
+    aesni = HasAESNI();
+    clmul = HasCLMUL();
+#if CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE
+    sha = HasSHA();
+#endif
+#if CRYPTOPP_BOOL_AVX2_INTRINSICS_AVAILABLE
+    avx2 = HasAVX2();
+#endif
+#endif
+
+    return Py_BuildValue("{s:N,s:N,s:N,s:N,s:N,s:N,s:N,s:s,s:s,s:s,s:s,s:s,s:s,s:s,s:s}",
+                         "asm", PyBool_FromLong(asm_enabled),
+                         "sse2", PyBool_FromLong(sse2),
+                         "ssse3", PyBool_FromLong(ssse3),
+                         "aesni", PyBool_FromLong(aesni),
+                         "clmul", PyBool_FromLong(clmul),
+                         "sha", PyBool_FromLong(sha),
+                         "avx2", PyBool_FromLong(avx2),
+                         "aes", aes_kernel(),
+                         "ghash", ghash_kernel(),
+                         "sha256", sha256_kernel(),
+                         "integer", integer_kernel(),
+                         "sha256_many", sha256mb_kernel_name(sha256mb_best_kernel()),
+                         "xsalsa20", xsalsa20_kernel_name(xsalsa20_max_blocks_per_pass()),
+                         "ida_gf2_8", ida_gf2_8_kernel_name(),
+                         "sha512", sha512_kernel_name());
+}
+
+const char*const cpu_features__doc__ = "Return a dict describing the CPU and the Crypto++ kernels in use.\n\
+\n\
+'asm' is True if this build was compiled with Crypto++'s inline assembly\n\
+(see setup.py --enable-embedded-cryptopp-asm). 'sse2', 'ssse3', 'aesni',\n\
+'clmul', 'sha' and 'avx2' are what the CPU reports. 'aes', 'ghash',\n\
+'sha256' and 'integer' name the implementation that AES, GCM's GHASH,\n\
+SHA-256 and big-integer arithmetic will actually use on this machine,\n\
+'sha256_many' the kernel behind sha256.hash_many(), 'xsalsa20' the one\n\
+that XSalsa20 objects use unless told otherwise, 'ida_gf2_8' the one\n\
+that ida.encode() and ida.decode() use for field='gf2_8' and 'sha512'\n\
+the SHA-512 implementation ('cryptopp' or 'supercop') that SHA512\n\
+objects use unless told otherwise.";
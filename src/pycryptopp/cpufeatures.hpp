@@ -0,0 +1,27 @@
+#ifndef __INCL_CPUFEATURES_HPP
+#define __INCL_CPUFEATURES_HPP
+
+extern PyObject *
+cpu_features(PyObject *dummy, PyObject *noargs);
+extern const char*const cpu_features__doc__;
+
+/* Whether gcm.cpp will multiply in GF(2^128) with CLMUL (if it is allowed
+   to), and whether its multiplication-table code will use SSE2. */
+extern bool
+ghash_clmul_available();
+extern bool
+ghash_sse2_tables_available();
+
+/* The most keystream blocks salsa.cpp will compute per pass on this CPU: 8
+   with AVX2, 4 with SSE2, otherwise 1. XSalsa20 objects may be told to use
+   fewer. */
+extern unsigned int
+xsalsa20_max_blocks_per_pass();
+/* Whether XSalsa20 objects can be told how many blocks to do per pass. */
+extern bool
+xsalsa20_blocks_per_pass_selectable();
+/* "avx2", "sse2" or "serial" for 8, 4 or 1 blocks per pass */
+extern const char*
+xsalsa20_kernel_name(unsigned int blocksperpass);
+
+#endif /* #ifndef __INCL_CPUFEATURES_HPP */
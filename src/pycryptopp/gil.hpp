@@ -0,0 +1,69 @@
+#ifndef __INCL_GIL_HPP
+#define __INCL_GIL_HPP
+
+/**
+ * gil.hpp -- helpers for running Crypto++ code with the GIL released
+ *
+ * This follows the scheme used by CPython's hashlib: an object that may do
+ * work with the GIL released carries a PyThread_type_lock, and every method
+ * that touches the underlying Crypto++ object holds that lock, so that two
+ * Python threads can never be inside the same Crypto++ object at once.
+ *
+ * Objects whose operations are cheap for small inputs (ciphers, hashes)
+ * allocate the lock lazily, the first time they see an input of at least
+ * PYCRYPTOPP_GIL_MINSIZE bytes; below that size, releasing the GIL costs
+ * more than it gains. Objects whose every operation is expensive (signing
+ * keys) allocate the lock up front and always release the GIL.
+ */
+
+#include <pythread.h>
+
+/* Inputs at least this long are processed with the GIL released. */
+#define PYCRYPTOPP_GIL_MINSIZE 2048
+
+/* Acquire obj->lock if it exists. If another thread holds it, wait for it
+   without holding the GIL, since that thread might be waiting for the GIL in
+   order to finish. */
+#define ENTER_PYCRYPTOPP(obj) \
+    if ((obj)->lock) { \
+        if (!PyThread_acquire_lock((obj)->lock, 0)) { \
+            Py_BEGIN_ALLOW_THREADS \
+            PyThread_acquire_lock((obj)->lock, 1); \
+            Py_END_ALLOW_THREADS \
+        } \
+    }
+
+#define LEAVE_PYCRYPTOPP(obj) \
+    if ((obj)->lock) { \
+        PyThread_release_lock((obj)->lock); \
+    }
+
+/* Make sure obj->lock exists if len is large enough that the caller is going
+   to release the GIL. Call with the GIL held and before ENTER_PYCRYPTOPP. */
+#define PYCRYPTOPP_LOCK_IF_LARGE(obj, len) \
+    if (!(obj)->lock && (len) >= PYCRYPTOPP_GIL_MINSIZE) \
+        (obj)->lock = PyThread_allocate_lock();
+
+/* True if an operation on len bytes should run with the GIL released. */
+#define PYCRYPTOPP_RELEASE_GIL_FOR(obj, len) \
+    ((obj)->lock && (len) >= PYCRYPTOPP_GIL_MINSIZE)
+
+/* Like Py_BEGIN_ALLOW_THREADS ... Py_END_ALLOW_THREADS, but the GIL is
+   released only if cond is true. No C++ exception may propagate out of the
+   enclosed code, or the GIL would never be taken back. */
+#define PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(cond) \
+    { \
+        PyThreadState *_save = (cond) ? PyEval_SaveThread() : NULL;
+
+#define PYCRYPTOPP_END_ALLOW_THREADS \
+        if (_save) \
+            PyEval_RestoreThread(_save); \
+    }
+
+#define PYCRYPTOPP_FREE_LOCK(obj) \
+    if ((obj)->lock) { \
+        PyThread_free_lock((obj)->lock); \
+        (obj)->lock = NULL; \
+    }
+
+#endif /* #ifndef __INCL_GIL_HPP */
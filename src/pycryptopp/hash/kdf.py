@@ -0,0 +1,15 @@
+from pycryptopp import _import_my_names
+
+# These initializations to None are just to pacify pyflakes, which
+# doesn't understand that we have to do some funky import trickery
+# below in _import_my_names() in order to get sensible namespaces.
+hkdf=None
+hkdf_extract=None
+hkdf_expand=None
+hkdf_expand_many=None
+pbkdf2=None
+Error=None
+
+_import_my_names(globals(), "kdf_")
+
+del _import_my_names
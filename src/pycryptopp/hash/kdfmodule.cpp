@@ -0,0 +1,301 @@
+/**
+ * kdfmodule.cpp -- key derivation with HMAC-SHA-256: HKDF (RFC 5869) and
+ * PBKDF2 (PKCS #5, RFC 8018), from Crypto++'s hkdf.h and pwdbased.h
+ *
+ * hkdf_expand_many() derives a whole batch of keys from one pseudorandom key
+ * in one call, so that a key hierarchy costs one trip into C per level
+ * rather than a few Python hash objects per key.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#if (PY_VERSION_HEX < 0x02050000)
+typedef int Py_ssize_t;
+#endif
+
+#include <assert.h>
+#include <string.h>
+
+#include <new>
+#include <vector>
+
+#include "kdfmodule.hpp"
+#include "../buffers.hpp"
+#include "../gil.hpp"
+
+/* from Crypto++ */
+#ifdef DISABLE_EMBEDDED_CRYPTOPP
+#include <cryptopp/sha.h>
+#include <cryptopp/hmac.h>
+#include <cryptopp/hkdf.h>
+#include <cryptopp/pwdbased.h>
+#else
+#include <src-cryptopp/sha.h>
+#include <src-cryptopp/hmac.h>
+#include <src-cryptopp/hkdf.h>
+#include <src-cryptopp/pwdbased.h>
+#endif
+
+#define KDF_HASHSIZE 32
+
+/* RFC 5869: the expand step counts its blocks in one byte. */
+#define KDF_HKDF_MAX_LENGTH (255*KDF_HASHSIZE)
+
+static const char*const kdf___doc__ = "_kdf -- key derivation functions built on HMAC-SHA-256\n\
+\n\
+hkdf() is the whole of HKDF (RFC 5869); hkdf_extract() and hkdf_expand()\n\
+are its two steps, and hkdf_expand_many() runs the second step for a list\n\
+of info strings at once. pbkdf2() is PBKDF2 from PKCS #5, for deriving keys\n\
+from passwords; it releases the GIL while it iterates.";
+
+static PyObject *kdf_error;
+
+typedef CryptoPP::HMAC<CryptoPP::SHA256> KDF_HMAC;
+
+/** This function is only for internal use by kdfmodule.cpp. The HKDF expand
+    step: len bytes of output keying material for info, from hmac, which is
+    keyed with the pseudorandom key. */
+static void
+kdf_expand(KDF_HMAC& hmac, const byte* info, size_t infolen, byte* out, size_t len) {
+    assert (len <= KDF_HKDF_MAX_LENGTH);
+    byte t[KDF_HASHSIZE];
+    byte block = 0;
+    while (len) {
+        if (block)
+            hmac.Update(t, sizeof(t));
+        hmac.Update(info, infolen);
+        block++;
+        hmac.Update(&block, 1);
+        hmac.Final(t);
+        const size_t n = len < sizeof(t) ? len : sizeof(t);
+        memcpy(out, t, n);
+        out += n;
+        len -= n;
+    }
+}
+
+static int
+kdf_check_hkdf_length(Py_ssize_t length) {
+    if (length < 0 || length > KDF_HKDF_MAX_LENGTH) {
+        PyErr_Format(kdf_error, "Precondition violation: length is required to be between 0 and %d, not %zd", KDF_HKDF_MAX_LENGTH, length);
+        return -1;
+    }
+    return 0;
+}
+
+static int
+kdf_check_prk(Py_ssize_t prksize) {
+    if (prksize < KDF_HASHSIZE) {
+        PyErr_Format(kdf_error, "Precondition violation: prk is required to be at least %d bytes, not %zd; get one from hkdf_extract()", KDF_HASHSIZE, prksize);
+        return -1;
+    }
+    return 0;
+}
+
+PyObject *
+kdf_hkdf(PyObject *dummy, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "ikm", "length", "salt", "info", NULL };
+    const char *ikm, *salt = "", *info = "";
+    Py_ssize_t ikmsize, length, saltsize = 0, infosize = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#n|t#t#:hkdf", const_cast<char**>(kwlist), &ikm, &ikmsize, &length, &salt, &saltsize, &info, &infosize))
+        return NULL;
+    if (kdf_check_hkdf_length(length))
+        return NULL;
+    /* Crypto++ asserts that there is some input keying material. */
+    if (!ikmsize)
+        return PyErr_Format(kdf_error, "Precondition violation: ikm is required to be non-empty");
+
+    PyObject* result = PyString_FromStringAndSize(NULL, length);
+    if (!result || !length)
+        return result;
+    CryptoPP::HKDF<CryptoPP::SHA256>().DeriveKey(reinterpret_cast<byte*>(PyString_AS_STRING(result)), length, reinterpret_cast<const byte*>(ikm), ikmsize, reinterpret_cast<const byte*>(salt), saltsize, reinterpret_cast<const byte*>(info), infosize);
+    return result;
+}
+
+const char*const kdf_hkdf__doc__ = "Return length bytes of keying material derived from ikm with HKDF-SHA-256.\n\
+This is hkdf_expand(hkdf_extract(ikm, salt), length, info).\n\
+\n\
+@param ikm: the input keying material; not empty\n\
+@param length: the number of bytes to return, at most 8160\n\
+@param salt: a non-secret random value (default: none)\n\
+@param info: what the key is for, to tell it apart from others derived from\n\
+    the same ikm (default: '')";
+
+PyObject *
+kdf_hkdf_extract(PyObject *dummy, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "ikm", "salt", NULL };
+    const char *ikm, *salt = "";
+    Py_ssize_t ikmsize, saltsize = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#|t#:hkdf_extract", const_cast<char**>(kwlist), &ikm, &ikmsize, &salt, &saltsize))
+        return NULL;
+
+    byte prk[KDF_HASHSIZE];
+    KDF_HMAC(reinterpret_cast<const byte*>(salt), saltsize).CalculateDigest(prk, reinterpret_cast<const byte*>(ikm), ikmsize);
+    return PyString_FromStringAndSize(reinterpret_cast<const char*>(prk), sizeof(prk));
+}
+
+const char*const kdf_hkdf_extract__doc__ = "Return the 32-byte pseudorandom key that HKDF-SHA-256 extracts from ikm.\n\
+\n\
+@param ikm: the input keying material\n\
+@param salt: a non-secret random value (default: none)";
+
+PyObject *
+kdf_hkdf_expand(PyObject *dummy, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "prk", "length", "info", NULL };
+    const char *prk, *info = "";
+    Py_ssize_t prksize, length, infosize = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#n|t#:hkdf_expand", const_cast<char**>(kwlist), &prk, &prksize, &length, &info, &infosize))
+        return NULL;
+    if (kdf_check_prk(prksize) || kdf_check_hkdf_length(length))
+        return NULL;
+
+    PyObject* result = PyString_FromStringAndSize(NULL, length);
+    if (!result)
+        return NULL;
+    KDF_HMAC hmac(reinterpret_cast<const byte*>(prk), prksize);
+    kdf_expand(hmac, reinterpret_cast<const byte*>(info), infosize, reinterpret_cast<byte*>(PyString_AS_STRING(result)), length);
+    return result;
+}
+
+const char*const kdf_hkdf_expand__doc__ = "Return length bytes of keying material that HKDF-SHA-256 expands from prk.\n\
+\n\
+@param prk: a pseudorandom key of at least 32 bytes, as from hkdf_extract()\n\
+@param length: the number of bytes to return, at most 8160\n\
+@param info: what the key is for (default: '')";
+
+PyObject *
+kdf_hkdf_expand_many(PyObject *dummy, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "prk", "infos", "length", NULL };
+    const char *prk;
+    Py_ssize_t prksize, length;
+    PyObject *infosobj;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#On:hkdf_expand_many", const_cast<char**>(kwlist), &prk, &prksize, &infosobj, &length))
+        return NULL;
+    if (kdf_check_prk(prksize) || kdf_check_hkdf_length(length))
+        return NULL;
+
+    PyObject *seq = PySequence_Fast(infosobj, "hkdf_expand_many() requires a sequence of info strings");
+    if (!seq)
+        return NULL;
+    const Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    PyObject *result = PyList_New(n);
+    std::vector<Py_buffer> infos;
+    bool pinned = true;
+    bool nomem = false;
+    if (!result)
+        goto fail;
+    try {
+        infos.reserve(n);
+    } catch (std::bad_alloc&) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+    for (Py_ssize_t i = 0; i < n; i++) {
+        Py_buffer info;
+        bool infopinned;
+        if (pycryptopp_get_read_buffer(PySequence_Fast_GET_ITEM(seq, i), &info, &infopinned, kdf_error))
+            goto fail;
+        infos.push_back(info);
+        pinned = pinned && infopinned;
+        PyObject* key = PyString_FromStringAndSize(NULL, length);
+        if (!key)
+            goto fail;
+        PyList_SET_ITEM(result, i, key);
+    }
+
+    /* The output strings are not yet visible to any other thread. */
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && n*(length+KDF_HASHSIZE) >= PYCRYPTOPP_GIL_MINSIZE)
+    try {
+        KDF_HMAC hmac(reinterpret_cast<const byte*>(prk), prksize);
+        for (Py_ssize_t i = 0; i < n; i++)
+            kdf_expand(hmac, reinterpret_cast<const byte*>(infos[i].buf), infos[i].len, reinterpret_cast<byte*>(PyString_AS_STRING(PyList_GET_ITEM(result, i))), length);
+    } catch (std::bad_alloc&) {
+        nomem = true;
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    if (nomem) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+
+    for (size_t i = 0; i < infos.size(); i++)
+        PyBuffer_Release(&infos[i]);
+    Py_DECREF(seq);
+    return result;
+
+ fail:
+    for (size_t i = 0; i < infos.size(); i++)
+        PyBuffer_Release(&infos[i]);
+    Py_XDECREF(result);
+    Py_DECREF(seq);
+    return NULL;
+}
+
+const char*const kdf_hkdf_expand_many__doc__ = "Return a list of keys that HKDF-SHA-256 expands from prk, one for each\n\
+of infos, each of length bytes. This gives the same keys as calling\n\
+hkdf_expand(prk, length, info) for each info, in one call.\n\
+\n\
+@param prk: a pseudorandom key of at least 32 bytes, as from hkdf_extract()\n\
+@param infos: a sequence of strings (or objects supporting the buffer\n\
+    protocol), one per key, each telling what its key is for\n\
+@param length: the number of bytes in each key, at most 8160";
+
+PyObject *
+kdf_pbkdf2(PyObject *dummy, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "password", "salt", "iterations", "length", NULL };
+    const char *password, *salt;
+    Py_ssize_t passwordsize, saltsize, length = KDF_HASHSIZE;
+    long iterations;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#t#l|n:pbkdf2", const_cast<char**>(kwlist), &password, &passwordsize, &salt, &saltsize, &iterations, &length))
+        return NULL;
+    if (iterations < 1 || static_cast<unsigned long>(iterations) > 0xffffffffUL)
+        return PyErr_Format(kdf_error, "Precondition violation: iterations is required to be between 1 and 2**32-1, not %ld", iterations);
+    if (length < 0)
+        return PyErr_Format(kdf_error, "Precondition violation: length is required to be non-negative, not %zd", length);
+
+    PyObject* result = PyString_FromStringAndSize(NULL, length);
+    if (!result)
+        return NULL;
+
+    /* Copies, since the arguments may be buffers that another thread could
+       change while the GIL is released. */
+    CryptoPP::SecByteBlock pw, s;
+    try {
+        pw.Assign(reinterpret_cast<const byte*>(password), passwordsize);
+        s.Assign(reinterpret_cast<const byte*>(salt), saltsize);
+    } catch (std::bad_alloc&) {
+        Py_DECREF(result);
+        return PyErr_NoMemory();
+    }
+
+    bool nomem = false;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        CryptoPP::PKCS5_PBKDF2_HMAC<CryptoPP::SHA256>().DeriveKey(reinterpret_cast<byte*>(PyString_AS_STRING(result)), length, 0, pw, pw.size(), s, s.size(), static_cast<unsigned int>(iterations));
+    } catch (std::bad_alloc&) {
+        nomem = true;
+    }
+    Py_END_ALLOW_THREADS
+    if (nomem) {
+        Py_DECREF(result);
+        return PyErr_NoMemory();
+    }
+    return result;
+}
+
+const char*const kdf_pbkdf2__doc__ = "Return length bytes derived from password with PBKDF2-HMAC-SHA-256, running\n\
+the iterations with the GIL released.\n\
+\n\
+@param password: the password\n\
+@param salt: a random value, stored along with whatever the key protects\n\
+@param iterations: how many times to apply HMAC-SHA-256 per 32 bytes of\n\
+    output; the more, the slower a password guessing attack\n\
+@param length: the number of bytes to return (default: 32)";
+
+void
+init_kdf(PyObject*const module) {
+    kdf_error = PyErr_NewException(const_cast<char*>("_kdf.Error"), NULL, NULL);
+    PyModule_AddObject(module, "kdf_Error", kdf_error);
+
+    PyModule_AddStringConstant(module, "kdf___doc__", const_cast<char*>(kdf___doc__));
+}
@@ -0,0 +1,27 @@
+#ifndef __INCL_KDFMODULE_HPP
+#define __INCL_KDFMODULE_HPP
+
+extern void
+init_kdf(PyObject* module);
+
+extern PyObject *
+kdf_hkdf(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const kdf_hkdf__doc__;
+
+extern PyObject *
+kdf_hkdf_extract(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const kdf_hkdf_extract__doc__;
+
+extern PyObject *
+kdf_hkdf_expand(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const kdf_hkdf_expand__doc__;
+
+extern PyObject *
+kdf_hkdf_expand_many(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const kdf_hkdf_expand_many__doc__;
+
+extern PyObject *
+kdf_pbkdf2(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const kdf_pbkdf2__doc__;
+
+#endif /* #ifndef __INCL_KDFMODULE_HPP */
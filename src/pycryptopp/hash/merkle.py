@@ -0,0 +1,15 @@
+from pycryptopp import _import_my_names
+
+# These initializations to None are just to pacify pyflakes, which
+# doesn't understand that we have to do some funky import trickery
+# below in _import_my_names() in order to get sensible namespaces.
+MerkleTree=None
+tree_hash=None
+leaf_hash=None
+pair_hash=None
+check_proof=None
+Error=None
+
+_import_my_names(globals(), "merkle_")
+
+del _import_my_names
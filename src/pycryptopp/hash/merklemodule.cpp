@@ -0,0 +1,675 @@
+/**
+ * merklemodule.cpp -- SHA-256 hash trees, built natively, with the leaves
+ * hashed on several threads
+ *
+ * The data is cut into leaves of leafsize bytes (the last one may be
+ * shorter; empty data is one empty leaf). The tree is the complete binary
+ * tree over the leaves, padded on the right up to a power of two, with
+ *
+ *   leaf hash    = SHA-256(0x00 || leaf)
+ *   interior hash = SHA-256(0x01 || left child || right child)
+ *
+ * and every padding leaf taking the hash of an empty leaf. The prefixes
+ * keep a leaf from ever being taken for an interior node. Nodes are
+ * numbered as in a heap: the root is 0 and the children of node i are
+ * 2i+1 and 2i+2.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#if (PY_VERSION_HEX < 0x02050000)
+typedef int Py_ssize_t;
+#endif
+
+#include <assert.h>
+#include <string.h>
+
+#include <new>
+#include <vector>
+
+#include "merklemodule.hpp"
+#include "../buffers.hpp"
+#include "../gil.hpp"
+#include "../workerpool.hpp"
+
+/* from Crypto++ */
+#ifdef DISABLE_EMBEDDED_CRYPTOPP
+#include <cryptopp/sha.h>
+#else
+#include <src-cryptopp/sha.h>
+#endif
+
+#define MERKLE_HASHSIZE 32
+
+/* Hashing is split across threads only in slices of at least this many
+   bytes. */
+#define MERKLE_MIN_PARALLEL_SLICE (64*1024)
+
+/* The deepest tree this module can describe; far beyond any buffer. */
+#define MERKLE_MAX_DEPTH 64
+
+static const char*const merkle___doc__ = "_merkle -- SHA-256 hash trees\n\
+\n\
+tree_hash(data, leafsize) returns the root of the tree over data, and\n\
+MerkleTree(leafsize) builds the same tree from data appended a piece at a\n\
+time, and hands out the uncle chain that proves a leaf is in it.\n\
+\n\
+Leaves are hashed as SHA-256(0x00 || leaf) and interior nodes as\n\
+SHA-256(0x01 || left || right). The tree is padded on the right with empty\n\
+leaves up to a power of two, and its nodes are numbered as in a heap: the\n\
+root is 0 and the children of node i are 2i+1 and 2i+2.";
+
+static PyObject *merkle_error;
+
+typedef struct {
+    byte h[MERKLE_HASHSIZE];
+} MerkleHash;
+
+/* pad[k] is the root of a subtree of 2^k padding leaves */
+static MerkleHash merkle_pad[MERKLE_MAX_DEPTH+1];
+
+static void
+merkle_leaf(MerkleHash* out, const byte* leaf, size_t len) {
+    static const byte tag = 0;
+    CryptoPP::SHA256 h;
+    h.Update(&tag, 1);
+    h.Update(leaf, len);
+    h.Final(out->h);
+}
+
+static void
+merkle_pair(MerkleHash* out, const MerkleHash& left, const MerkleHash& right) {
+    static const byte tag = 1;
+    CryptoPP::SHA256 h;
+    h.Update(&tag, 1);
+    h.Update(left.h, MERKLE_HASHSIZE);
+    h.Update(right.h, MERKLE_HASHSIZE);
+    h.Final(out->h);
+}
+
+/* count leaves of data (if data is not NULL) or count pairs of nodes from
+   in, to be hashed into out, in nslices slices */
+typedef struct {
+    MerkleHash* out;
+    const byte* data;
+    size_t leafsize;
+    const MerkleHash* in;
+    size_t count;
+    size_t nslices;
+} Merkle_HashJob;
+
+/** A pycryptopp_task_fn: hash slice i of the Merkle_HashJob ctx. */
+static void
+Merkle_hash_slice(void* ctx, size_t i) {
+    const Merkle_HashJob* job = reinterpret_cast<const Merkle_HashJob*>(ctx);
+    const size_t begin = job->count / job->nslices * i;
+    const size_t end = i+1 == job->nslices ? job->count : job->count / job->nslices * (i+1);
+    for (size_t j = begin; j < end; j++) {
+        if (job->data)
+            merkle_leaf(&job->out[j], job->data + j*job->leafsize, job->leafsize);
+        else
+            merkle_pair(&job->out[j], job->in[2*j], job->in[2*j+1]);
+    }
+}
+
+/** This function is only for internal use by merklemodule.cpp. Hash count
+    leaves of data, or count pairs from in, into out, on up to threads
+    threads. */
+static void
+Merkle_hash_many(MerkleHash* out, const byte* data, size_t leafsize, const MerkleHash* in, size_t count, unsigned int threads) {
+    Merkle_HashJob job;
+    job.out = out;
+    job.data = data;
+    job.leafsize = leafsize;
+    job.in = in;
+    job.count = count;
+    const size_t itemsize = data ? leafsize : 2*MERKLE_HASHSIZE;
+    job.nslices = count / (MERKLE_MIN_PARALLEL_SLICE / itemsize + 1);
+    if (job.nslices > threads)
+        job.nslices = threads;
+    if (job.nslices > count)
+        job.nslices = count;
+    if (job.nslices < 1)
+        job.nslices = 1;
+    pycryptopp_parallel_run(Merkle_hash_slice, &job, job.nslices);
+}
+
+/* The tree over everything appended so far. m_levels[k] holds the nodes k
+   levels above the leaves whose subtrees hold nothing but whole leaves;
+   nodes over the last, partial, leaf or over padding are computed when
+   they are asked for. */
+class MerkleCore
+{
+public:
+    MerkleCore(size_t leafsize) : m_leafsize(leafsize), m_length(0), m_levels(1) {}
+
+    /* Does not need the GIL. */
+    void Append(const byte* data, size_t len, unsigned int threads) {
+        m_length += len;
+        if (!m_partial.empty()) {
+            const size_t take = len < m_leafsize - m_partial.size() ? len : m_leafsize - m_partial.size();
+            m_partial.insert(m_partial.end(), data, data + take);
+            data += take;
+            len -= take;
+            if (m_partial.size() < m_leafsize)
+                return;
+            m_levels[0].push_back(MerkleHash());
+            merkle_leaf(&m_levels[0].back(), &m_partial[0], m_leafsize);
+            m_partial.clear();
+        }
+
+        const size_t nfull = len / m_leafsize;
+        if (nfull) {
+            const size_t old = m_levels[0].size();
+            m_levels[0].resize(old + nfull);
+            Merkle_hash_many(&m_levels[0][old], data, m_leafsize, NULL, nfull, threads);
+            data += nfull * m_leafsize;
+            len -= nfull * m_leafsize;
+        }
+        m_partial.assign(data, data + len);
+
+        for (size_t k = 0; m_levels[k].size() >= 2; k++) {
+            if (k+1 == m_levels.size())
+                m_levels.push_back(std::vector<MerkleHash>());
+            const size_t old = m_levels[k+1].size();
+            const size_t have = m_levels[k].size() / 2;
+            if (have == old)
+                break;
+            m_levels[k+1].resize(have);
+            Merkle_hash_many(&m_levels[k+1][old], NULL, 0, &m_levels[k][2*old], have - old, threads);
+        }
+    }
+
+    unsigned long long Length() const {
+        return m_length;
+    }
+
+    size_t NumLeaves() const {
+        return m_levels[0].size() + ((!m_partial.empty() || m_levels[0].empty()) ? 1 : 0);
+    }
+
+    /* the number of levels below the root */
+    unsigned int Depth() const {
+        unsigned int depth = 0;
+        while ((static_cast<size_t>(1) << depth) < NumLeaves())
+            depth++;
+        return depth;
+    }
+
+    /* node i of the level k above the leaves */
+    MerkleHash Node(unsigned int k, size_t i) const {
+        if (k < m_levels.size() && i < m_levels[k].size())
+            return m_levels[k][i];
+        if (i > ((NumLeaves() - 1) >> k))
+            return merkle_pad[k];
+        MerkleHash h;
+        if (k == 0)
+            merkle_leaf(&h, m_partial.empty() ? NULL : &m_partial[0], m_partial.size());
+        else
+            merkle_pair(&h, Node(k-1, 2*i), Node(k-1, 2*i+1));
+        return h;
+    }
+
+    MerkleHash Root() const {
+        return Node(Depth(), 0);
+    }
+
+    /* all of the nodes, in heap order */
+    void Nodes(std::vector<MerkleHash>& out) const {
+        const unsigned int depth = Depth();
+        const size_t last = NumLeaves() - 1;
+        out.resize((static_cast<size_t>(2) << depth) - 1);
+        for (unsigned int k = 0; k <= depth; k++) {
+            const size_t width = static_cast<size_t>(1) << (depth - k);
+            MerkleHash* level = &out[width - 1];
+            const MerkleHash* below = &out[2*width - 1];
+            for (size_t i = 0; i < width; i++) {
+                if (k < m_levels.size() && i < m_levels[k].size())
+                    level[i] = m_levels[k][i];
+                else if (i > (last >> k))
+                    level[i] = merkle_pad[k];
+                else if (k == 0)
+                    level[i] = Node(0, i);
+                else
+                    merkle_pair(&level[i], below[2*i], below[2*i+1]);
+            }
+        }
+    }
+
+    /* the uncle chain of leaf leafnum, from the bottom up, as (node number,
+       hash) pairs */
+    void Proof(size_t leafnum, std::vector<std::pair<size_t, MerkleHash> >& out) const {
+        const unsigned int depth = Depth();
+        size_t node = (static_cast<size_t>(1) << depth) - 1 + leafnum;
+        size_t i = leafnum;
+        out.clear();
+        for (unsigned int k = 0; k < depth; k++) {
+            const size_t sibling = (node & 1) ? node + 1 : node - 1;
+            out.push_back(std::make_pair(sibling, Node(k, i ^ 1)));
+            node = (node - 1) / 2;
+            i >>= 1;
+        }
+    }
+
+private:
+    size_t m_leafsize;
+    unsigned long long m_length;
+    std::vector<std::vector<MerkleHash> > m_levels;
+    std::vector<byte> m_partial;
+};
+
+static PyObject *
+merkle_hash_to_string(const MerkleHash& h) {
+    return PyString_FromStringAndSize(reinterpret_cast<const char*>(h.h), MERKLE_HASHSIZE);
+}
+
+/** This function is only for internal use by merklemodule.cpp. A list of
+    all of core's nodes, in heap order. */
+static PyObject *
+merkle_nodes_to_list(const MerkleCore& core) {
+    std::vector<MerkleHash> nodes;
+    core.Nodes(nodes);
+    PyObject* result = PyList_New(nodes.size());
+    if (!result)
+        return NULL;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        PyObject* h = merkle_hash_to_string(nodes[i]);
+        if (!h) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, i, h);
+    }
+    return result;
+}
+
+static int
+merkle_check_leafsize_and_threads(Py_ssize_t leafsize, int threads) {
+    if (leafsize < 1) {
+        PyErr_Format(merkle_error, "Precondition violation: leafsize is required to be positive, not %zd", leafsize);
+        return -1;
+    }
+    if (threads < 0) {
+        PyErr_Format(merkle_error, "Precondition violation: threads is required to be non-negative, not %d", threads);
+        return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    PyObject_HEAD
+
+    /* internal */
+    MerkleCore* core;
+    unsigned int threads;
+    PyThread_type_lock lock;
+} MerkleTree;
+
+PyDoc_STRVAR(MerkleTree__doc__,
+"A SHA-256 hash tree that grows as data is appended to it.\n\
+\n\
+@param leafsize: the number of bytes in each leaf\n\
+@param threads: the most threads to hash one append()'s leaves on,\n\
+    including the calling thread (default: 0, meaning one per processor)");
+
+static PyObject *
+MerkleTree_append(MerkleTree* self, PyObject* msgobj) {
+    Py_buffer msg;
+    bool pinned;
+    if (pycryptopp_get_read_buffer(msgobj, &msg, &pinned, merkle_error))
+        return NULL;
+
+    if (pinned) {
+        PYCRYPTOPP_LOCK_IF_LARGE(self, msg.len);
+    }
+    bool nomem = false;
+    ENTER_PYCRYPTOPP(self);
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && PYCRYPTOPP_RELEASE_GIL_FOR(self, msg.len))
+    try {
+        self->core->Append(reinterpret_cast<const byte*>(msg.buf), msg.len, self->threads);
+    } catch (std::bad_alloc&) {
+        nomem = true;
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    LEAVE_PYCRYPTOPP(self);
+    PyBuffer_Release(&msg);
+    if (nomem)
+        return PyErr_NoMemory();
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(MerkleTree_append__doc__,
+"Add data to the end of the tree's leaves. Repeated calls are equivalent to\n\
+a single call with the concatenation of all the data.");
+
+static PyObject *
+MerkleTree_root(MerkleTree* self, PyObject* dummy) {
+    ENTER_PYCRYPTOPP(self);
+    MerkleHash root = self->core->Root();
+    LEAVE_PYCRYPTOPP(self);
+    return merkle_hash_to_string(root);
+}
+
+PyDoc_STRVAR(MerkleTree_root__doc__,
+"Return the root hash of the tree over everything appended so far.");
+
+static PyObject *
+MerkleTree_nodes(MerkleTree* self, PyObject* dummy) {
+    ENTER_PYCRYPTOPP(self);
+    PyObject* result = merkle_nodes_to_list(*self->core);
+    LEAVE_PYCRYPTOPP(self);
+    return result;
+}
+
+PyDoc_STRVAR(MerkleTree_nodes__doc__,
+"Return a list of the hashes of all of the tree's nodes, in heap order, so\n\
+that the root is first and the leaves are last.");
+
+static PyObject *
+MerkleTree_proof(MerkleTree* self, PyObject* args) {
+    Py_ssize_t leafnum;
+    if (!PyArg_ParseTuple(args, "n:proof", &leafnum))
+        return NULL;
+
+    std::vector<std::pair<size_t, MerkleHash> > chain;
+    ENTER_PYCRYPTOPP(self);
+    const size_t numleaves = self->core->NumLeaves();
+    if (leafnum >= 0 && static_cast<size_t>(leafnum) < numleaves)
+        self->core->Proof(leafnum, chain);
+    LEAVE_PYCRYPTOPP(self);
+    if (leafnum < 0 || static_cast<size_t>(leafnum) >= numleaves)
+        return PyErr_Format(merkle_error, "Precondition violation: leafnum is required to be less than the number of leaves, %zu, but it was %zd", numleaves, leafnum);
+
+    PyObject* result = PyList_New(chain.size());
+    if (!result)
+        return NULL;
+    for (size_t i = 0; i < chain.size(); i++) {
+        PyObject* item = Py_BuildValue("(nN)", static_cast<Py_ssize_t>(chain[i].first), merkle_hash_to_string(chain[i].second));
+        if (!item) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, i, item);
+    }
+    return result;
+}
+
+PyDoc_STRVAR(MerkleTree_proof__doc__,
+"Return the uncle chain that proves leaf leafnum is in the tree: a list of\n\
+(node number, hash) pairs, one for the sibling of each node on the path\n\
+from the leaf up to (but not including) the root. check_proof() checks it.");
+
+static PyObject *
+MerkleTree_num_leaves(MerkleTree* self, PyObject* dummy) {
+    ENTER_PYCRYPTOPP(self);
+    const size_t numleaves = self->core->NumLeaves();
+    LEAVE_PYCRYPTOPP(self);
+    return PyInt_FromSize_t(numleaves);
+}
+
+PyDoc_STRVAR(MerkleTree_num_leaves__doc__,
+"Return the number of leaves, not counting padding. The last one may be\n\
+shorter than leafsize, and a tree over no data has one empty leaf.");
+
+static PyObject *
+MerkleTree_length(MerkleTree* self, PyObject* dummy) {
+    ENTER_PYCRYPTOPP(self);
+    const unsigned long long length = self->core->Length();
+    LEAVE_PYCRYPTOPP(self);
+    return PyLong_FromUnsignedLongLong(length);
+}
+
+PyDoc_STRVAR(MerkleTree_length__doc__,
+"Return the number of bytes appended so far.");
+
+static PyMethodDef MerkleTree_methods[] = {
+    {"append", reinterpret_cast<PyCFunction>(MerkleTree_append), METH_O, MerkleTree_append__doc__},
+    {"root", reinterpret_cast<PyCFunction>(MerkleTree_root), METH_NOARGS, MerkleTree_root__doc__},
+    {"nodes", reinterpret_cast<PyCFunction>(MerkleTree_nodes), METH_NOARGS, MerkleTree_nodes__doc__},
+    {"proof", reinterpret_cast<PyCFunction>(MerkleTree_proof), METH_VARARGS, MerkleTree_proof__doc__},
+    {"num_leaves", reinterpret_cast<PyCFunction>(MerkleTree_num_leaves), METH_NOARGS, MerkleTree_num_leaves__doc__},
+    {"length", reinterpret_cast<PyCFunction>(MerkleTree_length), METH_NOARGS, MerkleTree_length__doc__},
+    {NULL},
+};
+
+static PyObject *
+MerkleTree_new(PyTypeObject* type, PyObject *args, PyObject *kwdict) {
+    MerkleTree* self = reinterpret_cast<MerkleTree*>(type->tp_alloc(type, 0));
+    if (!self)
+        return NULL;
+    self->core = NULL;
+    self->threads = 1;
+    self->lock = NULL;
+    return reinterpret_cast<PyObject*>(self);
+}
+
+static void
+MerkleTree_dealloc(MerkleTree* self) {
+    delete self->core;
+    PYCRYPTOPP_FREE_LOCK(self);
+    self->ob_type->tp_free((PyObject*)self);
+}
+
+static int
+MerkleTree_init(PyObject* self, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "leafsize", "threads", NULL };
+    Py_ssize_t leafsize;
+    int threads = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "n|i:MerkleTree.__init__", const_cast<char**>(kwlist), &leafsize, &threads))
+        return -1;
+    if (merkle_check_leafsize_and_threads(leafsize, threads))
+        return -1;
+
+    /* append() and root() use the core with the GIL released, so it is
+       never replaced once it exists. */
+    MerkleTree* mself = reinterpret_cast<MerkleTree*>(self);
+    if (mself->core) {
+        PyErr_Format(merkle_error, "Precondition violation: a MerkleTree is required to be initialized only once");
+        return -1;
+    }
+    mself->core = new MerkleCore(leafsize);
+    mself->threads = threads ? threads : pycryptopp_cpu_count();
+    return 0;
+}
+
+static PyTypeObject MerkleTree_type = {
+    PyObject_HEAD_INIT(NULL)
+    0,                         /*ob_size*/
+    "_merkle.MerkleTree", /*tp_name*/
+    sizeof(MerkleTree),             /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    reinterpret_cast<destructor>(MerkleTree_dealloc), /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+    MerkleTree__doc__,           /* tp_doc */
+    0,		               /* tp_traverse */
+    0,		               /* tp_clear */
+    0,		               /* tp_richcompare */
+    0,		               /* tp_weaklistoffset */
+    0,		               /* tp_iter */
+    0,		               /* tp_iternext */
+    MerkleTree_methods,      /* tp_methods */
+    0,                         /* tp_members */
+    0,                         /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    MerkleTree_init,               /* tp_init */
+    0,                         /* tp_alloc */
+    MerkleTree_new,                /* tp_new */
+};
+
+PyObject *
+merkle_tree_hash(PyObject *dummy, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "data", "leafsize", "nodes", "threads", NULL };
+    PyObject *dataobj;
+    Py_ssize_t leafsize;
+    PyObject *wantnodes = Py_False;
+    int threads = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "On|Oi:tree_hash", const_cast<char**>(kwlist), &dataobj, &leafsize, &wantnodes, &threads))
+        return NULL;
+    if (merkle_check_leafsize_and_threads(leafsize, threads))
+        return NULL;
+    const int nodes = PyObject_IsTrue(wantnodes);
+    if (nodes < 0)
+        return NULL;
+
+    Py_buffer data;
+    bool pinned;
+    if (pycryptopp_get_read_buffer(dataobj, &data, &pinned, merkle_error))
+        return NULL;
+
+    MerkleCore core(leafsize);
+    bool nomem = false;
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && data.len >= PYCRYPTOPP_GIL_MINSIZE)
+    try {
+        core.Append(reinterpret_cast<const byte*>(data.buf), data.len, threads ? threads : pycryptopp_cpu_count());
+    } catch (std::bad_alloc&) {
+        nomem = true;
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    PyBuffer_Release(&data);
+    if (nomem)
+        return PyErr_NoMemory();
+
+    if (!nodes)
+        return merkle_hash_to_string(core.Root());
+    PyObject* nodelist = merkle_nodes_to_list(core);
+    if (!nodelist)
+        return NULL;
+    return Py_BuildValue("(NN)", merkle_hash_to_string(core.Root()), nodelist);
+}
+
+const char*const merkle_tree_hash__doc__ = "Return the root hash of the tree over data, or if nodes is true, a tuple of\n\
+the root hash and a list of the hashes of all of the nodes, in heap order.\n\
+The leaves are hashed on several threads, with the GIL released.\n\
+\n\
+@param data: a string, or any object supporting the buffer protocol\n\
+@param leafsize: the number of bytes in each leaf\n\
+@param nodes: whether to return every node as well as the root\n\
+@param threads: the most threads to use, including the calling thread\n\
+    (default: 0, meaning one per processor)";
+
+PyObject *
+merkle_leaf_hash(PyObject *dummy, PyObject *args) {
+    const char *leaf;
+    Py_ssize_t leafsize;
+    if (!PyArg_ParseTuple(args, "t#:leaf_hash", &leaf, &leafsize))
+        return NULL;
+    MerkleHash h;
+    merkle_leaf(&h, reinterpret_cast<const byte*>(leaf), leafsize);
+    return merkle_hash_to_string(h);
+}
+
+const char*const merkle_leaf_hash__doc__ = "Return the hash of the leaf holding the given bytes.";
+
+PyObject *
+merkle_pair_hash(PyObject *dummy, PyObject *args) {
+    const char *left, *right;
+    Py_ssize_t leftsize, rightsize;
+    if (!PyArg_ParseTuple(args, "t#t#:pair_hash", &left, &leftsize, &right, &rightsize))
+        return NULL;
+    if (leftsize != MERKLE_HASHSIZE || rightsize != MERKLE_HASHSIZE)
+        return PyErr_Format(merkle_error, "Precondition violation: hashes are required to be of length %d, but they were %zd and %zd", MERKLE_HASHSIZE, leftsize, rightsize);
+    MerkleHash l, r, h;
+    memcpy(l.h, left, MERKLE_HASHSIZE);
+    memcpy(r.h, right, MERKLE_HASHSIZE);
+    merkle_pair(&h, l, r);
+    return merkle_hash_to_string(h);
+}
+
+const char*const merkle_pair_hash__doc__ = "Return the hash of the interior node with the given children's hashes.";
+
+PyObject *
+merkle_check_proof(PyObject *dummy, PyObject *args) {
+    const char *root, *leafhash;
+    Py_ssize_t rootsize, leafhashsize, leafnum;
+    PyObject *proofobj;
+    if (!PyArg_ParseTuple(args, "t#nt#O:check_proof", &root, &rootsize, &leafnum, &leafhash, &leafhashsize, &proofobj))
+        return NULL;
+    if (rootsize != MERKLE_HASHSIZE || leafhashsize != MERKLE_HASHSIZE)
+        return PyErr_Format(merkle_error, "Precondition violation: hashes are required to be of length %d, but they were %zd and %zd", MERKLE_HASHSIZE, rootsize, leafhashsize);
+    if (leafnum < 0)
+        return PyErr_Format(merkle_error, "Precondition violation: leafnum is required to be non-negative, not %zd", leafnum);
+
+    PyObject *seq = PySequence_Fast(proofobj, "check_proof() requires a sequence of (node number, hash) pairs");
+    if (!seq)
+        return NULL;
+    const Py_ssize_t depth = PySequence_Fast_GET_SIZE(seq);
+    if (depth >= MERKLE_MAX_DEPTH || static_cast<size_t>(leafnum) >> depth) {
+        Py_DECREF(seq);
+        Py_RETURN_FALSE;
+    }
+
+    MerkleHash h;
+    memcpy(h.h, leafhash, MERKLE_HASHSIZE);
+    size_t node = (static_cast<size_t>(1) << depth) - 1 + leafnum;
+    bool ok = true;
+    for (Py_ssize_t k = 0; ok && k < depth; k++) {
+        Py_ssize_t sibling;
+        const char *sibhash;
+        Py_ssize_t sibhashsize;
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(seq, k), "nt#:check_proof", &sibling, &sibhash, &sibhashsize)) {
+            Py_DECREF(seq);
+            return NULL;
+        }
+        const size_t expected = (node & 1) ? node + 1 : node - 1;
+        if (sibhashsize != MERKLE_HASHSIZE || sibling < 0 || static_cast<size_t>(sibling) != expected) {
+            ok = false;
+            break;
+        }
+        MerkleHash s;
+        memcpy(s.h, sibhash, MERKLE_HASHSIZE);
+        if (node & 1)
+            merkle_pair(&h, h, s);
+        else
+            merkle_pair(&h, s, h);
+        node = (node - 1) / 2;
+    }
+    Py_DECREF(seq);
+
+    if (ok && memcmp(h.h, root, MERKLE_HASHSIZE) == 0)
+        Py_RETURN_TRUE;
+    Py_RETURN_FALSE;
+}
+
+const char*const merkle_check_proof__doc__ = "Return whether proof, an uncle chain as returned by MerkleTree.proof(),\n\
+shows that a leaf with hash leafhash is leaf number leafnum of the tree with\n\
+the given root hash.\n\
+\n\
+@param root: the root hash\n\
+@param leafnum: the number of the leaf, counting from 0\n\
+@param leafhash: the leaf's hash, as from leaf_hash()\n\
+@param proof: a list of (node number, hash) pairs";
+
+void
+init_merkle(PyObject*const module) {
+    merkle_leaf(&merkle_pad[0], NULL, 0);
+    for (unsigned int k = 0; k < MERKLE_MAX_DEPTH; k++)
+        merkle_pair(&merkle_pad[k+1], merkle_pad[k], merkle_pad[k]);
+
+    if (PyType_Ready(&MerkleTree_type) < 0)
+        return;
+    Py_INCREF(&MerkleTree_type);
+    PyModule_AddObject(module, "merkle_MerkleTree", (PyObject *)&MerkleTree_type);
+
+    merkle_error = PyErr_NewException(const_cast<char*>("_merkle.Error"), NULL, NULL);
+    PyModule_AddObject(module, "merkle_Error", merkle_error);
+
+    PyModule_AddStringConstant(module, "merkle___doc__", const_cast<char*>(merkle___doc__));
+}
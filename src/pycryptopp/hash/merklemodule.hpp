@@ -0,0 +1,23 @@
+#ifndef __INCL_MERKLEMODULE_HPP
+#define __INCL_MERKLEMODULE_HPP
+
+extern void
+init_merkle(PyObject* module);
+
+extern PyObject *
+merkle_tree_hash(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const merkle_tree_hash__doc__;
+
+extern PyObject *
+merkle_leaf_hash(PyObject *dummy, PyObject *args);
+extern const char*const merkle_leaf_hash__doc__;
+
+extern PyObject *
+merkle_pair_hash(PyObject *dummy, PyObject *args);
+extern const char*const merkle_pair_hash__doc__;
+
+extern PyObject *
+merkle_check_proof(PyObject *dummy, PyObject *args);
+extern const char*const merkle_check_proof__doc__;
+
+#endif /* #ifndef __INCL_MERKLEMODULE_HPP */
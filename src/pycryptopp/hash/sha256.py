@@ -4,6 +4,7 @@ from pycryptopp import _import_my_names
 # doesn't understand that we have to do some funky import trickery
 # below in _import_my_names() in order to get sensible namespaces.
 SHA256=None
+hash_many=None
 Error=None
 
 _import_my_names(globals(), "sha256_")
@@ -0,0 +1,390 @@
+/**
+ * sha256mb.cpp -- multi-buffer SHA-256
+ *
+ * Each SIMD lane carries its own message. The driver pads every message
+ * up front (only its last one or two blocks need copying), hands the
+ * kernel one block per lane, and refills a lane with the next message as
+ * soon as the one in it is done. Messages are started longest first, so
+ * that the lanes run out of work at about the same time.
+ *
+ * In the kernels, word i of the state of lane l is at state[i*LANES + l],
+ * so that a whole state word loads as one vector.
+ */
+
+#include "sha256mb.hpp"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+/* from Crypto++ */
+#ifdef DISABLE_EMBEDDED_CRYPTOPP
+#include <cryptopp/config.h>
+#include <cryptopp/cpu.h>
+#include <cryptopp/sha.h>
+#else
+#include <src-cryptopp/config.h>
+#include <src-cryptopp/cpu.h>
+#include <src-cryptopp/sha.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SHA256MB_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/* AVX2 code is compiled with a target attribute, so that the rest of the
+   module still runs on CPUs without it. */
+#if defined(SHA256MB_HAVE_SSE2) && defined(CRYPTOPP_CPUID_AVAILABLE) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SHA256MB_HAVE_AVX2 1
+#include <immintrin.h>
+#define SHA256MB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#define SHA256MB_MAX_LANES 8
+
+/* Messages longer than this are hashed on their own with Crypto++, rather
+   than keeping a lane busy while the others sit idle. */
+#define SHA256MB_LONG_MESSAGE (64*1024)
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t IV[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+typedef void (*sha256mb_compress_fn)(uint32_t* state, const unsigned char*const* blocks);
+
+#ifdef SHA256MB_HAVE_SSE2
+
+/* Turns rows r[0..3], each four consecutive words of one lane's block, into
+   columns, each one word of all four lanes, in place. */
+static inline void
+transpose4(__m128i r[4]) {
+    const __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+    const __m128i t1 = _mm_unpacklo_epi32(r[2], r[3]);
+    const __m128i t2 = _mm_unpackhi_epi32(r[0], r[1]);
+    const __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+    r[0] = _mm_unpacklo_epi64(t0, t1);
+    r[1] = _mm_unpackhi_epi64(t0, t1);
+    r[2] = _mm_unpacklo_epi64(t2, t3);
+    r[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+static inline __m128i
+bswap32_sse2(__m128i x) {
+    x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    x = _mm_shufflelo_epi16(x, 0xB1);
+    return _mm_shufflehi_epi16(x, 0xB1);
+}
+
+#define ROTR4(x, n) _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32-(n)))
+#define XOR4(a, b, c) _mm_xor_si128(_mm_xor_si128(a, b), c)
+
+static void
+compress_sse2(uint32_t* state, const unsigned char*const* blocks) {
+    __m128i w[16];
+    for (int c = 0; c < 4; c++) {
+        for (int l = 0; l < 4; l++)
+            w[4*c+l] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[l] + 16*c));
+        transpose4(&w[4*c]);
+        for (int j = 0; j < 4; j++)
+            w[4*c+j] = bswap32_sse2(w[4*c+j]);
+    }
+
+    __m128i s[8], v[8];
+    for (int i = 0; i < 8; i++)
+        s[i] = v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4*i));
+
+    for (int t = 0; t < 64; t++) {
+        if (t >= 16) {
+            const __m128i w15 = w[(t-15)&15], w2 = w[(t-2)&15];
+            const __m128i s0 = XOR4(ROTR4(w15, 7), ROTR4(w15, 18), _mm_srli_epi32(w15, 3));
+            const __m128i s1 = XOR4(ROTR4(w2, 17), ROTR4(w2, 19), _mm_srli_epi32(w2, 10));
+            w[t&15] = _mm_add_epi32(_mm_add_epi32(w[t&15], s0), _mm_add_epi32(w[(t-7)&15], s1));
+        }
+        const __m128i e = v[4], a = v[0];
+        const __m128i ch = _mm_xor_si128(_mm_and_si128(e, v[5]), _mm_andnot_si128(e, v[6]));
+        const __m128i maj = _mm_or_si128(_mm_and_si128(a, v[1]), _mm_and_si128(_mm_or_si128(a, v[1]), v[2]));
+        __m128i t1 = _mm_add_epi32(v[7], XOR4(ROTR4(e, 6), ROTR4(e, 11), ROTR4(e, 25)));
+        t1 = _mm_add_epi32(_mm_add_epi32(t1, ch), _mm_add_epi32(_mm_set1_epi32(K[t]), w[t&15]));
+        const __m128i t2 = _mm_add_epi32(XOR4(ROTR4(a, 2), ROTR4(a, 13), ROTR4(a, 22)), maj);
+        v[7] = v[6]; v[6] = v[5]; v[5] = v[4];
+        v[4] = _mm_add_epi32(v[3], t1);
+        v[3] = v[2]; v[2] = v[1]; v[1] = v[0];
+        v[0] = _mm_add_epi32(t1, t2);
+    }
+
+    for (int i = 0; i < 8; i++)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4*i), _mm_add_epi32(s[i], v[i]));
+}
+
+#undef ROTR4
+#undef XOR4
+
+#endif /* #ifdef SHA256MB_HAVE_SSE2 */
+
+#ifdef SHA256MB_HAVE_AVX2
+
+#define ROTR8(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32-(n)))
+#define XOR8(a, b, c) _mm256_xor_si256(_mm256_xor_si256(a, b), c)
+
+SHA256MB_TARGET_AVX2 static void
+compress_avx2(uint32_t* state, const unsigned char*const* blocks) {
+    const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                          12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m256i w[16];
+    for (int c = 0; c < 4; c++) {
+        __m128i lo[4], hi[4];
+        for (int l = 0; l < 4; l++) {
+            lo[l] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[l] + 16*c));
+            hi[l] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[l+4] + 16*c));
+        }
+        transpose4(lo);
+        transpose4(hi);
+        for (int j = 0; j < 4; j++)
+            w[4*c+j] = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo[j]), hi[j], 1), bswap);
+    }
+
+    __m256i s[8], v[8];
+    for (int i = 0; i < 8; i++)
+        s[i] = v[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state + 8*i));
+
+    for (int t = 0; t < 64; t++) {
+        if (t >= 16) {
+            const __m256i w15 = w[(t-15)&15], w2 = w[(t-2)&15];
+            const __m256i s0 = XOR8(ROTR8(w15, 7), ROTR8(w15, 18), _mm256_srli_epi32(w15, 3));
+            const __m256i s1 = XOR8(ROTR8(w2, 17), ROTR8(w2, 19), _mm256_srli_epi32(w2, 10));
+            w[t&15] = _mm256_add_epi32(_mm256_add_epi32(w[t&15], s0), _mm256_add_epi32(w[(t-7)&15], s1));
+        }
+        const __m256i e = v[4], a = v[0];
+        const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, v[5]), _mm256_andnot_si256(e, v[6]));
+        const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, v[1]), _mm256_and_si256(_mm256_or_si256(a, v[1]), v[2]));
+        __m256i t1 = _mm256_add_epi32(v[7], XOR8(ROTR8(e, 6), ROTR8(e, 11), ROTR8(e, 25)));
+        t1 = _mm256_add_epi32(_mm256_add_epi32(t1, ch), _mm256_add_epi32(_mm256_set1_epi32(K[t]), w[t&15]));
+        const __m256i t2 = _mm256_add_epi32(XOR8(ROTR8(a, 2), ROTR8(a, 13), ROTR8(a, 22)), maj);
+        v[7] = v[6]; v[6] = v[5]; v[5] = v[4];
+        v[4] = _mm256_add_epi32(v[3], t1);
+        v[3] = v[2]; v[2] = v[1]; v[1] = v[0];
+        v[0] = _mm256_add_epi32(t1, t2);
+    }
+
+    for (int i = 0; i < 8; i++)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(state + 8*i), _mm256_add_epi32(s[i], v[i]));
+}
+
+#undef ROTR8
+#undef XOR8
+
+/* AVX2 needs the CPU to support it and the OS to save the YMM registers. */
+static bool
+cpu_has_avx2() {
+    CryptoPP::word32 id[4];
+    if (!CryptoPP::CpuId(0, id) || id[0] < 7)
+        return false;
+    CryptoPP::CpuId(1, id);
+    const CryptoPP::word32 osxsave_avx = (1 << 27) | (1 << 28);
+    if ((id[2] & osxsave_avx) != osxsave_avx)
+        return false;
+    uint32_t xcr0_lo, xcr0_hi;
+    __asm__ __volatile__ ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+    if ((xcr0_lo & 6) != 6)
+        return false;
+    CryptoPP::CpuId(7, id);
+    return (id[1] & (1 << 5)) != 0;
+}
+
+#endif /* #ifdef SHA256MB_HAVE_AVX2 */
+
+static bool has_sse2 = false;
+static bool has_avx2 = false;
+static bool has_sha = false;
+
+void
+sha256mb_init() {
+#if defined(SHA256MB_HAVE_SSE2) && defined(CRYPTOPP_CPUID_AVAILABLE)
+    has_sse2 = CryptoPP::HasSSE2();
+#elif defined(SHA256MB_HAVE_SSE2)
+    has_sse2 = true;
+#endif
+#ifdef SHA256MB_HAVE_AVX2
+    has_avx2 = has_sse2 && cpu_has_avx2();
+#endif
+#if defined(CRYPTOPP_CPUID_AVAILABLE) && CRYPTOPP_BOOL_SSE_SHA_INTRINSICS_AVAILABLE
+    has_sha = CryptoPP::HasSHA();
+#endif
+}
+
+bool
+sha256mb_kernel_available(sha256mb_kernel kernel) {
+    switch (kernel) {
+    case SHA256MB_AVX2:
+        return has_avx2;
+    case SHA256MB_SSE2:
+        return has_sse2;
+    default:
+        return true;
+    }
+}
+
+sha256mb_kernel
+sha256mb_best_kernel() {
+    /* One stream through the SHA extensions beats eight AVX2 lanes, even
+       for 32-byte messages. */
+    if (has_sha)
+        return SHA256MB_SERIAL;
+    if (has_avx2)
+        return SHA256MB_AVX2;
+    if (has_sse2)
+        return SHA256MB_SSE2;
+    return SHA256MB_SERIAL;
+}
+
+const char*
+sha256mb_kernel_name(sha256mb_kernel kernel) {
+    switch (kernel) {
+    case SHA256MB_AVX2:
+        return "avx2";
+    case SHA256MB_SSE2:
+        return "sse2";
+    default:
+        return "serial";
+    }
+}
+
+typedef struct {
+    bool busy;
+    size_t msg;
+    const unsigned char* data;
+    size_t fullblocks;  /* blocks read straight from data */
+    size_t nblocks;     /* including the one or two in tail */
+    size_t block;
+    unsigned char tail[128];
+} sha256mb_lane;
+
+/* Start msg in lane l. */
+static void
+lane_start(sha256mb_lane* lane, size_t l, unsigned int lanes, uint32_t* state, size_t msg, const unsigned char* data, size_t len) {
+    lane->busy = true;
+    lane->msg = msg;
+    lane->data = data;
+    lane->fullblocks = len / 64;
+    lane->block = 0;
+
+    const size_t rem = len % 64;
+    const size_t tailsize = rem + 9 > 64 ? 128 : 64;
+    memcpy(lane->tail, data + 64*lane->fullblocks, rem);
+    lane->tail[rem] = 0x80;
+    memset(lane->tail + rem + 1, 0, tailsize - rem - 1);
+    const uint64_t bits = static_cast<uint64_t>(len) * 8;
+    for (int i = 0; i < 8; i++)
+        lane->tail[tailsize - 1 - i] = static_cast<unsigned char>(bits >> (8*i));
+    lane->nblocks = lane->fullblocks + tailsize / 64;
+
+    for (int i = 0; i < 8; i++)
+        state[i*lanes + l] = IV[i];
+}
+
+struct sha256mb_longer_first {
+    const size_t* lens;
+    bool operator()(size_t a, size_t b) const {
+        return lens[a] > lens[b];
+    }
+};
+
+static void
+run_lanes(sha256mb_compress_fn compress, unsigned int lanes, const unsigned char*const* msgs, const size_t* lens, const std::vector<size_t>& order, unsigned char* out) {
+    static const unsigned char idle[64] = { 0 };
+    uint32_t state[8*SHA256MB_MAX_LANES];
+    sha256mb_lane lane[SHA256MB_MAX_LANES];
+    const unsigned char* blocks[SHA256MB_MAX_LANES];
+    size_t next = 0, busy = 0;
+
+    for (unsigned int l = 0; l < lanes; l++) {
+        lane[l].busy = false;
+        if (next < order.size()) {
+            lane_start(&lane[l], l, lanes, state, order[next], msgs[order[next]], lens[order[next]]);
+            next++;
+            busy++;
+        }
+    }
+
+    while (busy) {
+        for (unsigned int l = 0; l < lanes; l++) {
+            const sha256mb_lane& ln = lane[l];
+            if (!ln.busy)
+                blocks[l] = idle;
+            else if (ln.block < ln.fullblocks)
+                blocks[l] = ln.data + 64*ln.block;
+            else
+                blocks[l] = ln.tail + 64*(ln.block - ln.fullblocks);
+        }
+        compress(state, blocks);
+
+        for (unsigned int l = 0; l < lanes; l++) {
+            sha256mb_lane& ln = lane[l];
+            if (!ln.busy || ++ln.block < ln.nblocks)
+                continue;
+            unsigned char* digest = out + 32*ln.msg;
+            for (int i = 0; i < 8; i++) {
+                const uint32_t x = state[i*lanes + l];
+                digest[4*i] = static_cast<unsigned char>(x >> 24);
+                digest[4*i+1] = static_cast<unsigned char>(x >> 16);
+                digest[4*i+2] = static_cast<unsigned char>(x >> 8);
+                digest[4*i+3] = static_cast<unsigned char>(x);
+            }
+            ln.busy = false;
+            busy--;
+            if (next < order.size()) {
+                lane_start(&ln, l, lanes, state, order[next], msgs[order[next]], lens[order[next]]);
+                next++;
+                busy++;
+            }
+        }
+    }
+}
+
+void
+sha256mb_hash_many(const unsigned char*const* msgs, const size_t* lens, size_t n, unsigned char* out, sha256mb_kernel kernel) {
+    sha256mb_compress_fn compress = NULL;
+    unsigned int lanes = 1;
+#ifdef SHA256MB_HAVE_AVX2
+    if (kernel == SHA256MB_AVX2) {
+        compress = compress_avx2;
+        lanes = 8;
+    }
+#endif
+#ifdef SHA256MB_HAVE_SSE2
+    if (kernel == SHA256MB_SSE2) {
+        compress = compress_sse2;
+        lanes = 4;
+    }
+#endif
+
+    std::vector<size_t> order;
+    for (size_t i = 0; i < n; i++) {
+        if (!compress || lens[i] > SHA256MB_LONG_MESSAGE)
+            CryptoPP::SHA256().CalculateDigest(out + 32*i, msgs[i], lens[i]);
+        else
+            order.push_back(i);
+    }
+    if (order.empty())
+        return;
+
+    sha256mb_longer_first cmp;
+    cmp.lens = lens;
+    std::stable_sort(order.begin(), order.end(), cmp);
+    run_lanes(compress, lanes, msgs, lens, order, out);
+}
@@ -0,0 +1,38 @@
+#ifndef __INCL_SHA256MB_HPP
+#define __INCL_SHA256MB_HPP
+
+/**
+ * sha256mb.hpp -- SHA-256 of many independent messages at once, one
+ * message per SIMD lane: four lanes with SSE2, eight with AVX2.
+ *
+ * The kernel is picked at run time from what the CPU supports. The
+ * serial kernel hashes the messages one after another with Crypto++, which
+ * is the quickest way on CPUs with the SHA extensions.
+ */
+
+#include <stddef.h>
+
+typedef enum {
+    SHA256MB_SERIAL,
+    SHA256MB_SSE2,
+    SHA256MB_AVX2
+} sha256mb_kernel;
+
+/* Detects the CPU's features. Must be called once before anything else
+   here. */
+extern void sha256mb_init();
+
+/* The quickest kernel that is compiled in and that this CPU can run. */
+extern sha256mb_kernel sha256mb_best_kernel();
+
+extern bool sha256mb_kernel_available(sha256mb_kernel kernel);
+
+/* "serial", "sse2" or "avx2" */
+extern const char* sha256mb_kernel_name(sha256mb_kernel kernel);
+
+/* Writes the digest of the lens[i] bytes at msgs[i] to out + 32*i, for
+   each i < n, using kernel, which must be available. Does not need the GIL.
+   May throw std::bad_alloc. */
+extern void sha256mb_hash_many(const unsigned char*const* msgs, const size_t* lens, size_t n, unsigned char* out, sha256mb_kernel kernel);
+
+#endif /* #ifndef __INCL_SHA256MB_HPP */
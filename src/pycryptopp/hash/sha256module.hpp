@@ -4,4 +4,12 @@
 extern void
 init_sha256(PyObject* module);
 
+extern PyObject *
+sha256_hash_many(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const sha256_hash_many__doc__;
+
+extern PyObject *
+sha256__hash_many_with(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const sha256__hash_many_with__doc__;
+
 #endif /* #ifndef __INCL_SHA256MODULE_HPP */
@@ -0,0 +1,36 @@
+from pycryptopp import _import_my_names
+
+# These initializations to None are just to pacify pyflakes, which
+# doesn't understand that we have to do some funky import trickery
+# below in _import_my_names() in order to get sensible namespaces.
+SHA512=None
+Error=None
+
+_import_my_names(globals(), "sha512_")
+
+del _import_my_names
+
+def start_up_self_test():
+    """
+    This is a quick test intended to detect major errors such as the library being
+    miscompiled and segfaulting or returning incorrect answers, as in sha256.py.
+    It runs with each kernel by name, so that importing this module doesn't
+    set off the timing that picks the default one.
+
+    Test that updating a hasher with various sized inputs yields the
+    expected answer, finalizing hashes of every length from empty to one
+    whole 128-byte block along the way.
+    """
+    s = ''.join([ chr(c) for c in range(129) ])
+    for kernel in ('cryptopp', 'supercop'):
+        hx = SHA512(kernel=kernel)
+        for i in range(0, 129):
+            hy = SHA512(s[:i], kernel=kernel).digest()
+            hx.update(hy)
+        for i in range(0, 129):
+            hx.update(chr(0xFE))
+            hx.update(s[:128])
+        if hx.hexdigest().lower() != '5feb7524bcd6bce31b3949b979155a54bb20b9449059693ebe6cd11f836cd9483b3c538a4c98dde6bd310a723dd641c6a357bfa4f92477b7f37aaadb74c71a5b':
+            raise Error("pycryptopp failed startup self-test. Please run pycryptopp unit tests.")
+
+start_up_self_test()
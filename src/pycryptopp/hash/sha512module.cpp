@@ -0,0 +1,439 @@
+/**
+ * sha512module.cpp -- Python wrappers around SHA-512, computed either by
+ * Crypto++ or by the SUPERCOP "ref" code that Ed25519 signs with
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#if (PY_VERSION_HEX < 0x02050000)
+typedef int Py_ssize_t;
+#endif
+
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+#include <new>
+#include <string>
+
+#include "sha512module.hpp"
+#include "../gil.hpp"
+
+/* from Crypto++ */
+#ifdef DISABLE_EMBEDDED_CRYPTOPP
+#include <cryptopp/sha.h>
+#include <cryptopp/hex.h>
+#include <cryptopp/filters.h>
+#else
+#include <src-cryptopp/sha.h>
+#include <src-cryptopp/hex.h>
+#include <src-cryptopp/filters.h>
+#endif
+
+/* from src-ed25519/supercop-ref/sha512-blocks.c: compress the whole 128-byte
+   blocks of in into the 64 big-endian state bytes and return the number of
+   bytes left over */
+extern "C" int crypto_hashblocks(unsigned char *statebytes, const unsigned char *in, unsigned long long inlen);
+
+static const char*const sha512___doc__ = "_sha512 hash function";
+
+static PyObject *sha512_error;
+
+/* The incremental hashing that src-ed25519/supercop-ref/sha512-hash.c does in
+   one call, so that crypto_hashblocks() can stand in for Crypto++'s SHA512. */
+class SupercopSHA512 : public CryptoPP::HashTransformation {
+public:
+    SupercopSHA512() {Restart();}
+
+    std::string AlgorithmName() const {return "SHA-512";}
+    unsigned int DigestSize() const {return 64;}
+    unsigned int BlockSize() const {return 128;}
+    unsigned int OptimalBlockSize() const {return 128;}
+
+    void Restart();
+    void Update(const byte *input, size_t length);
+    void TruncatedFinal(byte *digest, size_t digestSize);
+
+private:
+    byte m_state[64];
+    byte m_buffer[128];
+    unsigned int m_buffered;
+    CryptoPP::word64 m_length;
+};
+
+void
+SupercopSHA512::Restart() {
+    /* the same initial state as sha512-hash.c's */
+    static const byte iv[64] = {
+        0x6a,0x09,0xe6,0x67,0xf3,0xbc,0xc9,0x08,
+        0xbb,0x67,0xae,0x85,0x84,0xca,0xa7,0x3b,
+        0x3c,0x6e,0xf3,0x72,0xfe,0x94,0xf8,0x2b,
+        0xa5,0x4f,0xf5,0x3a,0x5f,0x1d,0x36,0xf1,
+        0x51,0x0e,0x52,0x7f,0xad,0xe6,0x82,0xd1,
+        0x9b,0x05,0x68,0x8c,0x2b,0x3e,0x6c,0x1f,
+        0x1f,0x83,0xd9,0xab,0xfb,0x41,0xbd,0x6b,
+        0x5b,0xe0,0xcd,0x19,0x13,0x7e,0x21,0x79
+    };
+    memcpy(m_state, iv, sizeof(m_state));
+    m_buffered = 0;
+    m_length = 0;
+}
+
+void
+SupercopSHA512::Update(const byte *input, size_t length) {
+    m_length += length;
+    if (m_buffered) {
+        size_t n = 128 - m_buffered;
+        if (n > length)
+            n = length;
+        memcpy(m_buffer + m_buffered, input, n);
+        m_buffered += n;
+        input += n;
+        length -= n;
+        if (m_buffered < 128)
+            return;
+        crypto_hashblocks(m_state, m_buffer, 128);
+        m_buffered = 0;
+    }
+    const size_t whole = length & ~static_cast<size_t>(127);
+    if (whole)
+        crypto_hashblocks(m_state, input, whole);
+    m_buffered = length - whole;
+    memcpy(m_buffer, input + whole, m_buffered);
+}
+
+void
+SupercopSHA512::TruncatedFinal(byte *digest, size_t digestSize) {
+    ThrowIfInvalidTruncatedSize(digestSize);
+
+    /* 0x80, zeroes and the 128-bit big-endian length in bits, filling out one
+       block or, if fewer than 17 bytes are left in this one, two */
+    byte padded[256];
+    memcpy(padded, m_buffer, m_buffered);
+    padded[m_buffered] = 0x80;
+    const unsigned int padlen = m_buffered < 112 ? 128 : 256;
+    memset(padded + m_buffered + 1, 0, padlen - m_buffered - 1);
+    padded[padlen-9] = static_cast<byte>(m_length >> 61);
+    for (unsigned int i = 0; i < 8; i++)
+        padded[padlen-1-i] = static_cast<byte>((m_length << 3) >> (8*i));
+    crypto_hashblocks(m_state, padded, padlen);
+
+    memcpy(digest, m_state, digestSize);
+    Restart();
+}
+
+enum sha512_kernel { SHA512_CRYPTOPP, SHA512_SUPERCOP };
+
+static const char*
+sha512_kernel_name(sha512_kernel kernel) {
+    return kernel == SHA512_SUPERCOP ? "supercop" : "cryptopp";
+}
+
+static CryptoPP::HashTransformation*
+sha512_new_hash(sha512_kernel kernel) {
+    if (kernel == SHA512_SUPERCOP)
+        return new SupercopSHA512();
+    return new CryptoPP::SHA512();
+}
+
+/** This function is only for internal use by sha512module.cpp. The processor
+ * time, in clock() ticks, that the best of three runs of kernel takes to hash
+ * 32 KiB. */
+static clock_t
+sha512_time_kernel(sha512_kernel kernel) {
+    static const byte zeroes[4096] = {0};
+    byte digest[64];
+    CryptoPP::HashTransformation* h = sha512_new_hash(kernel);
+    clock_t best = 0;
+    for (int run = 0; run < 3; run++) {
+        const clock_t start = clock();
+        for (int i = 0; i < 8; i++)
+            h->Update(zeroes, sizeof(zeroes));
+        h->Final(digest);
+        const clock_t elapsed = clock() - start;
+        if (run == 0 || elapsed < best)
+            best = elapsed;
+    }
+    delete h;
+    return best;
+}
+
+/** This function is only for internal use by sha512module.cpp. Which kernel
+ * SHA512 objects use by default: the one chosen when pycryptopp was built
+ * (setup.py --sha512-kernel=NAME), or else whichever hashes faster here.
+ * The timing is done the first time it is asked for rather than at import,
+ * and the SUPERCOP code has to win by an eighth, so that where the two are
+ * close the choice doesn't change from run to run: it stays Crypto++'s. */
+static sha512_kernel
+sha512_default_kernel() {
+#if defined(PYCRYPTOPP_SHA512_SUPERCOP)
+    return SHA512_SUPERCOP;
+#elif defined(PYCRYPTOPP_SHA512_CRYPTOPP)
+    return SHA512_CRYPTOPP;
+#else
+    /* only read or written with the GIL held */
+    static bool chosen = false;
+    static sha512_kernel kernel = SHA512_CRYPTOPP;
+    if (!chosen) {
+        try {
+            const clock_t supercop = sha512_time_kernel(SHA512_SUPERCOP);
+            const clock_t cryptopp = sha512_time_kernel(SHA512_CRYPTOPP);
+            if (supercop + supercop/8 < cryptopp)
+                kernel = SHA512_SUPERCOP;
+        } catch (std::bad_alloc&) {
+        }
+        chosen = true;
+    }
+    return kernel;
+#endif
+}
+
+const char*
+sha512_kernel_name() {
+    return sha512_kernel_name(sha512_default_kernel());
+}
+
+/** This function is only for internal use by sha512module.cpp. Sets *kernel
+ * from its name, or to the default if name is NULL; returns -1 with a Python
+ * exception set if name is not a kernel. */
+static int
+sha512_parse_kernel(const char* name, sha512_kernel* kernel) {
+    if (!name)
+        *kernel = sha512_default_kernel();
+    else if (!strcmp(name, "cryptopp"))
+        *kernel = SHA512_CRYPTOPP;
+    else if (!strcmp(name, "supercop"))
+        *kernel = SHA512_SUPERCOP;
+    else {
+        PyErr_Format(sha512_error, "Precondition violation: kernel is required to be None, 'cryptopp' or 'supercop', not '%s'", name);
+        return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    PyObject_HEAD
+
+    /* internal */
+    CryptoPP::HashTransformation* h;
+    PyStringObject* digest;
+    PyThread_type_lock lock;
+    sha512_kernel kernel;
+} SHA512;
+
+PyDoc_STRVAR(SHA512__doc__,
+"a SHA512 hash object\n\
+Its constructor takes an optional string, which has the same effect as\n\
+calling .update() with that string.\n\
+\n\
+@param kernel: 'cryptopp' for Crypto++'s SHA-512, 'supercop' for the one\n\
+    that Ed25519 signs with, or None for whichever of the two was found\n\
+    to be faster on this machine, unless setup.py was told which one to\n\
+    use (default: None). Both give the same digests; the .kernel attribute\n\
+    tells which one is in use, and it is fixed when the object is made.");
+
+/** This function is only for internal use by sha512module.cpp. */
+static void
+SHA512_update_locked(SHA512* self, const char* msg, Py_ssize_t msgsize) {
+    PYCRYPTOPP_LOCK_IF_LARGE(self, msgsize);
+    ENTER_PYCRYPTOPP(self);
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(PYCRYPTOPP_RELEASE_GIL_FOR(self, msgsize))
+    self->h->Update(reinterpret_cast<const byte*>(msg), msgsize);
+    PYCRYPTOPP_END_ALLOW_THREADS
+    LEAVE_PYCRYPTOPP(self);
+}
+
+static PyObject *
+SHA512_update(SHA512* self, PyObject* msgobj) {
+    if (self->digest)
+        return PyErr_Format(sha512_error, "Precondition violation: once .digest() has been called you are required to never call .update() again.");
+
+    const char *msg;
+    Py_ssize_t msgsize;
+    if (PyString_AsStringAndSize(msgobj, const_cast<char**>(&msg), &msgsize))
+        return NULL;
+    SHA512_update_locked(self, msg, msgsize);
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(SHA512_update__doc__,
+"Update the hash object with the string msg. Repeated calls are equivalent to\n\
+a single call with the concatenation of all the messages.");
+
+static PyObject *
+SHA512_digest(SHA512* self, PyObject* dummy) {
+    if (!self->digest) {
+        assert (self->h);
+        PyStringObject* digest = reinterpret_cast<PyStringObject*>(PyString_FromStringAndSize(NULL, self->h->DigestSize()));
+        if (!digest)
+            return NULL;
+        ENTER_PYCRYPTOPP(self);
+        self->h->Final(reinterpret_cast<byte*>(PyString_AS_STRING(digest)));
+        LEAVE_PYCRYPTOPP(self);
+        /* ENTER_PYCRYPTOPP may have let another thread finish first. */
+        if (self->digest)
+            Py_DECREF(digest);
+        else
+            self->digest = digest;
+    }
+
+    Py_INCREF(self->digest);
+    return reinterpret_cast<PyObject*>(self->digest);
+}
+
+PyDoc_STRVAR(SHA512_digest__doc__,
+"Return the binary digest of the messages that were passed to the update()\n\
+method (including the initial message if any).");
+
+static PyObject *
+SHA512_hexdigest(SHA512* self, PyObject* dummy) {
+    PyObject* digest = SHA512_digest(self, NULL);
+    if (!digest)
+        return NULL;
+    Py_ssize_t dsize = PyString_GET_SIZE(digest);
+    PyStringObject* hexdigest = reinterpret_cast<PyStringObject*>(PyString_FromStringAndSize(NULL, dsize*2));
+    if (!hexdigest) {
+        Py_DECREF(digest);
+        return NULL;
+    }
+    CryptoPP::ArraySink* as = new CryptoPP::ArraySink(reinterpret_cast<byte*>(PyString_AS_STRING(hexdigest)), dsize*2);
+    CryptoPP::HexEncoder enc;
+    enc.Attach(as);
+    enc.Put(reinterpret_cast<const byte*>(PyString_AS_STRING(digest)), static_cast<size_t>(dsize));
+    Py_DECREF(digest); digest = NULL;
+
+    return reinterpret_cast<PyObject*>(hexdigest);
+}
+
+PyDoc_STRVAR(SHA512_hexdigest__doc__,
+"Return the hex-encoded digest of the messages that were passed to the update()\n\
+method (including the initial message if any).");
+
+static PyMethodDef SHA512_methods[] = {
+    {"update", reinterpret_cast<PyCFunction>(SHA512_update), METH_O, SHA512_update__doc__},
+    {"digest", reinterpret_cast<PyCFunction>(SHA512_digest), METH_NOARGS, SHA512_digest__doc__},
+    {"hexdigest", reinterpret_cast<PyCFunction>(SHA512_hexdigest), METH_NOARGS, SHA512_hexdigest__doc__},
+    {NULL},
+};
+
+static PyObject *
+SHA512_get_kernel(SHA512* self, void* closure) {
+    return PyString_FromString(sha512_kernel_name(self->kernel));
+}
+
+static PyGetSetDef SHA512_getsets[] = {
+    {const_cast<char*>("kernel"), reinterpret_cast<getter>(SHA512_get_kernel), NULL, const_cast<char*>("the SHA-512 implementation in use: 'cryptopp' or 'supercop'"), NULL},
+    {NULL}
+};
+
+static PyObject *
+SHA512_new(PyTypeObject* type, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "msg", "kernel", NULL };
+    const char *msg = NULL;
+    Py_ssize_t msgsize = 0;
+    const char *kernelname = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "|t#z:SHA512.__new__", const_cast<char**>(kwlist), &msg, &msgsize, &kernelname))
+        return NULL;
+    sha512_kernel kernel;
+    if (sha512_parse_kernel(kernelname, &kernel))
+        return NULL;
+
+    SHA512* self = reinterpret_cast<SHA512*>(type->tp_alloc(type, 0));
+    if (!self)
+        return NULL;
+    self->kernel = kernel;
+    self->h = sha512_new_hash(kernel);
+    self->digest = NULL;
+    self->lock = NULL;
+    return reinterpret_cast<PyObject*>(self);
+}
+
+static void
+SHA512_dealloc(SHA512* self) {
+    Py_XDECREF(self->digest);
+    delete self->h;
+    PYCRYPTOPP_FREE_LOCK(self);
+    self->ob_type->tp_free((PyObject*)self);
+}
+
+static int
+SHA512_init(PyObject* self, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "msg", "kernel", NULL };
+    const char *msg = NULL;
+    Py_ssize_t msgsize = 0;
+    const char *kernelname = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "|t#z:SHA512.__init__", const_cast<char**>(kwlist), &msg, &msgsize, &kernelname))
+        return -1;
+
+    /* The kernel was settled by __new__. The hash object is never replaced,
+       since another thread may be using it with the GIL released. */
+    SHA512* mself = reinterpret_cast<SHA512*>(self);
+    if (kernelname) {
+        sha512_kernel kernel;
+        if (sha512_parse_kernel(kernelname, &kernel))
+            return -1;
+        if (kernel != mself->kernel) {
+            PyErr_Format(sha512_error, "Precondition violation: the kernel of a SHA512 object is required to stay '%s', the one it was made with", sha512_kernel_name(mself->kernel));
+            return -1;
+        }
+    }
+
+    if (msg)
+        SHA512_update_locked(mself, msg, msgsize);
+    return 0;
+}
+
+static PyTypeObject SHA512_type = {
+    PyObject_HEAD_INIT(NULL)
+    0,                         /*ob_size*/
+    "_sha512.SHA512", /*tp_name*/
+    sizeof(SHA512),             /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    reinterpret_cast<destructor>(SHA512_dealloc), /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+    SHA512__doc__,           /* tp_doc */
+    0,		               /* tp_traverse */
+    0,		               /* tp_clear */
+    0,		               /* tp_richcompare */
+    0,		               /* tp_weaklistoffset */
+    0,		               /* tp_iter */
+    0,		               /* tp_iternext */
+    SHA512_methods,      /* tp_methods */
+    0,                         /* tp_members */
+    SHA512_getsets,            /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    SHA512_init,               /* tp_init */
+    0,                         /* tp_alloc */
+    SHA512_new,                /* tp_new */
+};
+
+void
+init_sha512(PyObject* module) {
+    if (PyType_Ready(&SHA512_type) < 0)
+        return;
+    Py_INCREF(&SHA512_type);
+    PyModule_AddObject(module, "sha512_SHA512", (PyObject *)&SHA512_type);
+
+    sha512_error = PyErr_NewException(const_cast<char*>("_sha512.Error"), NULL, NULL);
+    PyModule_AddObject(module, "sha512_Error", sha512_error);
+
+    PyModule_AddStringConstant(module, "sha512___doc__", const_cast<char*>(sha512___doc__));
+}
@@ -0,0 +1,12 @@
+#ifndef __INCL_SHA512MODULE_HPP
+#define __INCL_SHA512MODULE_HPP
+
+extern void
+init_sha512(PyObject* module);
+
+/* "cryptopp" or "supercop": the implementation that SHA512 objects use
+   unless the caller asks for the other */
+extern const char*
+sha512_kernel_name();
+
+#endif /* #ifndef __INCL_SHA512MODULE_HPP */
@@ -0,0 +1,361 @@
+/**
+ * idamodule.cpp -- information dispersal: split a string into n shares, any k
+ * of which recover it, with the arithmetic of Crypto++'s ida.h
+ *
+ * Crypto++'s InformationDispersal and InformationRecovery filters push the
+ * data through a message queue per share, 4 bytes at a time. Here the
+ * shares are computed whole, from and into contiguous buffers, by
+ * BlockIDA, which gives the same shares as RawIDA.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#if (PY_VERSION_HEX < 0x02050000)
+typedef int Py_ssize_t;
+#endif
+
+#include <string.h>
+
+#include <new>
+#include <vector>
+
+#include "idamodule.hpp"
+#include "buffers.hpp"
+#include "gil.hpp"
+
+/* from Crypto++ */
+#ifdef DISABLE_EMBEDDED_CRYPTOPP
+#include <cryptopp/ida.h>
+#else
+#include <src-cryptopp/ida.h>
+#endif
+
+/* Share numbers fit in a byte, as they do in zfec and in Tahoe-LAFS. */
+#define IDA_MAX_SHARES 256
+
+static const char*const ida___doc__ = "_ida -- information dispersal\n\
+\n\
+encode() splits a string into n shares such that any k of them are enough\n\
+to recover it with decode(). The data is padded with a 1 byte and then\n\
+zeros, and the first k shares are the padded data dealt out byte by byte:\n\
+byte m of share j is byte m*k+j of the padded data, the same layout as\n\
+Crypto++'s InformationDispersal. The others are Reed-Solomon check shares\n\
+over GF(2^32), as InformationDispersal makes them. Each share is 1/k of the\n\
+size of the data, plus up to 4 bytes of padding, since it holds whole\n\
+4-byte words.\n\
+\n\
+With field='gf2_8' the check shares are over GF(2^8) instead, which is\n\
+several times faster: the shares are computed 32 bytes at a time with AVX2\n\
+where the CPU has it, or 16 at a time with SSSE3. The data shares are\n\
+dealt out the same way, but padded only to whole bytes, so each share has\n\
+at most 1 byte of padding.";
+
+static PyObject *ida_error;
+
+static const char*const ida_kernel_names[] = { "default", "scalar", "ssse3", "avx2" };
+
+const char*
+ida_gf2_8_kernel_name() {
+    return ida_kernel_names[CryptoPP::BlockIDA::GetBestKernel(CryptoPP::BlockIDA::GF256_FIELD)];
+}
+
+/** This function is only for internal use by idamodule.cpp. Turn the field=
+    and kernel= arguments into what BlockIDA takes, or set ida_error and
+    return -1. */
+static int
+ida_parse_options(const char* fieldname, const char* kernelname, CryptoPP::BlockIDA::Field* field, CryptoPP::BlockIDA::Kernel* kernel) {
+    if (!strcmp(fieldname, "gf2_32"))
+        *field = CryptoPP::BlockIDA::GF2_32_FIELD;
+    else if (!strcmp(fieldname, "gf2_8"))
+        *field = CryptoPP::BlockIDA::GF256_FIELD;
+    else {
+        PyErr_Format(ida_error, "Precondition violation: field is required to be 'gf2_32' or 'gf2_8', not '%s'", fieldname);
+        return -1;
+    }
+
+    *kernel = CryptoPP::BlockIDA::DEFAULT_KERNEL;
+    if (kernelname) {
+        int i;
+        for (i = CryptoPP::BlockIDA::SCALAR_KERNEL; i <= CryptoPP::BlockIDA::AVX2_KERNEL; i++)
+            if (!strcmp(kernelname, ida_kernel_names[i]))
+                break;
+        if (i > CryptoPP::BlockIDA::AVX2_KERNEL) {
+            PyErr_Format(ida_error, "Precondition violation: kernel is required to be 'scalar', 'ssse3' or 'avx2', not '%s'", kernelname);
+            return -1;
+        }
+        if (i > CryptoPP::BlockIDA::GetBestKernel(*field)) {
+            PyErr_Format(ida_error, "The '%s' kernel is not available for field '%s' on this CPU", kernelname, fieldname);
+            return -1;
+        }
+        *kernel = static_cast<CryptoPP::BlockIDA::Kernel>(i);
+    }
+    return 0;
+}
+
+/** This function is only for internal use by idamodule.cpp. Deal out the
+    data, with its padding (a 1 byte and then zeros), across the first k
+    shares: byte m of share j is byte m*k+j of the padded data. */
+static void
+ida_split(const byte* data, size_t len, unsigned int k, byte*const* shares, size_t sharesize) {
+    const size_t fullrows = len / k;
+    for (size_t m = 0; m < fullrows; m++, data += k)
+        for (unsigned int j = 0; j < k; j++)
+            shares[j][m] = data[j];
+
+    std::vector<byte> tail((sharesize - fullrows) * k);
+    const size_t rest = len - fullrows*k;
+    memcpy(&tail[0], data, rest);
+    tail[rest] = 1;
+    for (size_t m = fullrows; m < sharesize; m++)
+        for (unsigned int j = 0; j < k; j++)
+            shares[j][m] = tail[(m - fullrows)*k + j];
+}
+
+/** This function is only for internal use by idamodule.cpp. The inverse of
+    ida_split(): gather the k data shares into out and return the length of
+    the data without its padding, or -1 if the padding is not there. */
+static Py_ssize_t
+ida_join(byte*const* shares, unsigned int k, size_t sharesize, unsigned int symbolsize, byte* out) {
+    for (size_t m = 0; m < sharesize; m++)
+        for (unsigned int j = 0; j < k; j++)
+            *out++ = shares[j][m];
+
+    const size_t len = sharesize * k;
+    const byte* p = out;
+    while (p > out - len && p[-1] == 0)
+        p--;
+    /* The padding is a 1 byte and then fewer than symbolsize*k zeros. */
+    if (p == out - len || p[-1] != 1 || size_t(out - p) >= symbolsize*k)
+        return -1;
+    return (p - 1) - (out - len);
+}
+
+PyObject *
+ida_encode(PyObject *dummy, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "data", "k", "n", "field", "kernel", NULL };
+    PyObject *dataobj;
+    int k, n;
+    const char *fieldname = "gf2_32", *kernelname = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "Oii|sz:encode", const_cast<char**>(kwlist), &dataobj, &k, &n, &fieldname, &kernelname))
+        return NULL;
+    if (k < 1 || n < k || n > IDA_MAX_SHARES)
+        return PyErr_Format(ida_error, "Precondition violation: 1 <= k <= n <= %d is required, not k=%d, n=%d", IDA_MAX_SHARES, k, n);
+    CryptoPP::BlockIDA::Field field;
+    CryptoPP::BlockIDA::Kernel kernel;
+    if (ida_parse_options(fieldname, kernelname, &field, &kernel))
+        return NULL;
+    const unsigned int symbolsize = field == CryptoPP::BlockIDA::GF256_FIELD ? 1 : 4;
+
+    Py_buffer data;
+    bool pinned;
+    if (pycryptopp_get_read_buffer(dataobj, &data, &pinned, ida_error))
+        return NULL;
+
+    /* one more byte for the padding, rounded up to whole symbols in each share */
+    const size_t sharesize = symbolsize * ((static_cast<size_t>(data.len) + symbolsize*k) / (symbolsize*k));
+    std::vector<byte*> shares;
+    std::vector<CryptoPP::word32> ids;
+    CryptoPP::BlockIDA coder;
+    bool nomem = false;
+
+    PyObject *result = PyList_New(n);
+    if (!result)
+        goto fail;
+    for (int i = 0; i < n; i++) {
+        PyObject* share = PyString_FromStringAndSize(NULL, sharesize);
+        if (!share)
+            goto fail;
+        PyList_SET_ITEM(result, i, share);
+    }
+    try {
+        shares.resize(n);
+        ids.resize(n);
+        for (int i = 0; i < n; i++) {
+            shares[i] = reinterpret_cast<byte*>(PyString_AS_STRING(PyList_GET_ITEM(result, i)));
+            ids[i] = i;
+        }
+        coder.Initialize(k, &ids[0], &ids[0] + k, n - k, field, kernel);
+    } catch (std::bad_alloc&) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+
+    /* The shares are not yet visible to any other thread. */
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && data.len >= PYCRYPTOPP_GIL_MINSIZE)
+    try {
+        ida_split(reinterpret_cast<const byte*>(data.buf), data.len, k, &shares[0], sharesize);
+        coder.Compute(&shares[0] + k, &shares[0], sharesize);
+    } catch (std::bad_alloc&) {
+        nomem = true;
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    if (nomem) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+
+    PyBuffer_Release(&data);
+    return result;
+
+ fail:
+    PyBuffer_Release(&data);
+    Py_XDECREF(result);
+    return NULL;
+}
+
+const char*const ida_encode__doc__ = "Return a list of n shares of data, any k of which are enough to recover\n\
+it. Share i (counting from 0) is the i'th element of the list; keep its\n\
+number along with it, since decode() needs both.\n\
+\n\
+@param data: a string (or an object supporting the buffer protocol)\n\
+@param k: the number of shares needed to recover data, at least 1\n\
+@param n: the number of shares to make, at least k and at most 256\n\
+@param field: 'gf2_32' (the default) for Crypto++'s shares, or 'gf2_8'\n\
+@param kernel: for 'gf2_8', 'avx2', 'ssse3' or 'scalar' to override the\n\
+    choice of the fastest one this CPU has; all of them give the same shares";
+
+PyObject *
+ida_decode(PyObject *dummy, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "shares", "k", "field", "kernel", NULL };
+    PyObject *sharesobj;
+    int k;
+    const char *fieldname = "gf2_32", *kernelname = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "Oi|sz:decode", const_cast<char**>(kwlist), &sharesobj, &k, &fieldname, &kernelname))
+        return NULL;
+    if (k < 1 || k > IDA_MAX_SHARES)
+        return PyErr_Format(ida_error, "Precondition violation: 1 <= k <= %d is required, not k=%d", IDA_MAX_SHARES, k);
+    CryptoPP::BlockIDA::Field field;
+    CryptoPP::BlockIDA::Kernel kernel;
+    if (ida_parse_options(fieldname, kernelname, &field, &kernel))
+        return NULL;
+    const unsigned int symbolsize = field == CryptoPP::BlockIDA::GF256_FIELD ? 1 : 4;
+
+    PyObject *seq = PyDict_Check(sharesobj) ? PyDict_Items(sharesobj) : PySequence_Fast(sharesobj, "decode() requires a dict or a sequence of (sharenum, share) pairs");
+    if (!seq)
+        return NULL;
+    PyObject *result = NULL;
+    std::vector<Py_buffer> inputs;
+    std::vector<CryptoPP::word32> ids, missing;
+    std::vector<byte*> columns;
+    std::vector<byte> recovered;
+    CryptoPP::BlockIDA coder;
+    bool seen[IDA_MAX_SHARES] = { false };
+    bool pinned = true;
+    bool nomem = false;
+    size_t sharesize = 0;
+    Py_ssize_t len = 0;
+
+    if (PySequence_Fast_GET_SIZE(seq) < k) {
+        PyErr_Format(ida_error, "Precondition violation: k=%d shares are required, but %zd were given", k, PySequence_Fast_GET_SIZE(seq));
+        goto fail;
+    }
+    try {
+        inputs.reserve(k);
+        ids.reserve(k);
+    } catch (std::bad_alloc&) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+    /* Any k shares will do; take the first k. */
+    for (int j = 0; j < k; j++) {
+        int sharenum;
+        PyObject *shareobj;
+        if (!PyArg_Parse(PySequence_Fast_GET_ITEM(seq, j), "(iO):decode", &sharenum, &shareobj))
+            goto fail;
+        if (sharenum < 0 || sharenum >= IDA_MAX_SHARES) {
+            PyErr_Format(ida_error, "Precondition violation: share numbers are required to be between 0 and %d, not %d", IDA_MAX_SHARES-1, sharenum);
+            goto fail;
+        }
+        if (seen[sharenum]) {
+            PyErr_Format(ida_error, "Precondition violation: share %d was given twice", sharenum);
+            goto fail;
+        }
+        seen[sharenum] = true;
+
+        Py_buffer share;
+        bool sharepinned;
+        if (pycryptopp_get_read_buffer(shareobj, &share, &sharepinned, ida_error))
+            goto fail;
+        inputs.push_back(share);
+        ids.push_back(sharenum);
+        pinned = pinned && sharepinned;
+        if (j == 0)
+            sharesize = share.len;
+        if (static_cast<size_t>(share.len) != sharesize || !sharesize || sharesize % symbolsize) {
+            PyErr_Format(ida_error, "Precondition violation: the shares are required to be of one non-zero length, a multiple of %u, as from encode(), but share %d is %zd bytes", symbolsize, sharenum, share.len);
+            goto fail;
+        }
+    }
+
+    result = PyString_FromStringAndSize(NULL, sharesize*k);
+    if (!result)
+        goto fail;
+    try {
+        for (int j = 0; j < k; j++)
+            if (!seen[j])
+                missing.push_back(j);
+        columns.resize(k);
+        recovered.resize(missing.size()*sharesize);
+        coder.Initialize(k, &ids[0], missing.empty() ? NULL : &missing[0], static_cast<unsigned int>(missing.size()), field, kernel);
+    } catch (std::bad_alloc&) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && sharesize*k >= PYCRYPTOPP_GIL_MINSIZE)
+    try {
+        std::vector<const byte*> in(k);
+        std::vector<byte*> out(missing.size());
+        for (int j = 0; j < k; j++) {
+            in[j] = reinterpret_cast<const byte*>(inputs[j].buf);
+            if (ids[j] < static_cast<CryptoPP::word32>(k))
+                columns[ids[j]] = const_cast<byte*>(in[j]);
+        }
+        for (size_t i = 0; i < missing.size(); i++)
+            columns[missing[i]] = out[i] = &recovered[i*sharesize];
+        coder.Compute(out.empty() ? NULL : &out[0], &in[0], sharesize);
+        len = ida_join(&columns[0], k, sharesize, symbolsize, reinterpret_cast<byte*>(PyString_AS_STRING(result)));
+    } catch (std::bad_alloc&) {
+        nomem = true;
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    if (nomem) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+    if (len < 0) {
+        PyErr_Format(ida_error, "The recovered data does not end with the padding that encode() adds; the shares are corrupt, or were not made by encode() with k=%d", k);
+        goto fail;
+    }
+    if (_PyString_Resize(&result, len))
+        goto fail;
+
+    for (size_t i = 0; i < inputs.size(); i++)
+        PyBuffer_Release(&inputs[i]);
+    Py_DECREF(seq);
+    return result;
+
+ fail:
+    for (size_t i = 0; i < inputs.size(); i++)
+        PyBuffer_Release(&inputs[i]);
+    Py_XDECREF(result);
+    Py_DECREF(seq);
+    return NULL;
+}
+
+const char*const ida_decode__doc__ = "Return the data that encode() split into shares, from any k of them.\n\
+\n\
+@param shares: a dict mapping share numbers to shares, or a sequence of\n\
+    (sharenum, share) pairs; if there are more than k, the first k are\n\
+    used\n\
+@param k: the k that the shares were made with\n\
+@param field: the field that the shares were made with (default: 'gf2_32')\n\
+@param kernel: as for encode()";
+
+void
+init_ida(PyObject*const module) {
+    ida_error = PyErr_NewException(const_cast<char*>("_ida.Error"), NULL, NULL);
+    PyModule_AddObject(module, "ida_Error", ida_error);
+
+    PyModule_AddStringConstant(module, "ida___doc__", const_cast<char*>(ida___doc__));
+}
@@ -0,0 +1,20 @@
+#ifndef __INCL_IDAMODULE_HPP
+#define __INCL_IDAMODULE_HPP
+
+extern void
+init_ida(PyObject* module);
+
+/* "avx2", "ssse3" or "scalar": the kernel that GF(2^8) shares are computed
+   with on this CPU unless the caller asks for another */
+extern const char*
+ida_gf2_8_kernel_name();
+
+extern PyObject *
+ida_encode(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const ida_encode__doc__;
+
+extern PyObject *
+ida_decode(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const ida_decode__doc__;
+
+#endif /* #ifndef __INCL_IDAMODULE_HPP */
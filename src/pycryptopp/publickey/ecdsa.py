@@ -3,3 +3,64 @@ from pycryptopp import _import_my_names
 _import_my_names(globals(), "ecdsa_")
 
 del _import_my_names
+
+import threading
+
+class VerifyingKeyCache(object):
+    """
+    Hold precomputed VerifyingKeys for the most recently used public keys,
+    so that code which checks many signatures from a few signers pays for
+    decoding and precomputation once per signer.
+
+    Keys handed out by the cache are shared; don't call precompute() on them.
+    """
+    def __init__(self, maxsize=128, storage=32):
+        if maxsize < 1:
+            raise ValueError("maxsize is required to be at least 1")
+        self.maxsize = maxsize
+        self.storage = storage
+        self._lock = threading.Lock()
+        self._keys = {} # serialized key -> [last use, VerifyingKey]
+        self._clock = 0
+
+    def __len__(self):
+        return len(self._keys)
+
+    def get(self, serializedverifyingkey):
+        """
+        Return a precomputed VerifyingKey for the serialized key, constructing
+        it (and evicting the least recently used one) if it isn't cached.
+        """
+        self._lock.acquire()
+        try:
+            self._clock += 1
+            entry = self._keys.get(serializedverifyingkey)
+            if entry is not None:
+                entry[0] = self._clock
+                return entry[1]
+        finally:
+            self._lock.release()
+
+        vk = VerifyingKey(serializedverifyingkey)
+        vk.precompute(self.storage)
+
+        self._lock.acquire()
+        try:
+            entry = self._keys.get(serializedverifyingkey)
+            if entry is not None:
+                # another thread got here first
+                return entry[1]
+            if len(self._keys) >= self.maxsize:
+                oldest = min(self._keys.iteritems(), key=lambda item: item[1][0])[0]
+                del self._keys[oldest]
+            self._keys[serializedverifyingkey] = [self._clock, vk]
+            return vk
+        finally:
+            self._lock.release()
+
+    def clear(self):
+        self._lock.acquire()
+        try:
+            self._keys.clear()
+        finally:
+            self._lock.release()
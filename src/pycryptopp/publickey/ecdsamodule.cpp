@@ -23,6 +23,10 @@
  * http://www.users.zetnet.co.uk/hopwood/crypto/scan/prf.html#KDF2
  * to generate private (signing) keys from unguessable seeds -- see
  * source code for details and doc string for usage.
+ *
+ * Where the compiler has a 128-bit integer type, the curve arithmetic for
+ * signing and verifying is done by p256.cpp rather than by Crypto++'s
+ * generic ECP code. Keys and encodings are Crypto++'s either way.
  */
 
 #define PY_SSIZE_T_CLEAN
@@ -33,7 +37,12 @@ typedef int Py_ssize_t;
 
 #include <math.h>
 
+#include <new>
+
 #include "ecdsamodule.hpp"
+#include "p256.hpp"
+#include "../gil.hpp"
+#include "../threadrng.hpp"
 
 /* from Crypto++ */
 #ifdef DISABLE_EMBEDDED_CRYPTOPP
@@ -70,15 +79,135 @@ To create a new ECDSA signing key (deterministically from a 32-byte seed), const
 \n\
 To get a verifying key from a signing key, call get_verifying_key() on the signing key instance.\n\
 \n\
-To deserialize an ECDSA verifying key from a string, call VerifyingKey(serialized_verifying_key).";
+To deserialize an ECDSA verifying key from a string, call VerifyingKey(serialized_verifying_key).\n\
+\n\
+A verifying key that will check many signatures can be sped up with precompute(). VerifyingKeyCache keeps precomputed keys for the most recently used serialized keys.";
 
 static PyObject *ecdsa_error;
 
+#ifdef PYCRYPTOPP_HAVE_P256
+/* ECDSA<ECP, SHA256>, but with k*G, and u1*G + u2*Q, computed by p256.cpp.
+   The message representative and the choice of k are as in
+   DL_SignerBase::SignAndRestart and DL_VerifierBase::VerifyAndRestart, so
+   given the same random numbers the signatures are the same bytes. */
+class P256Signer : public ECDSA<ECP, SHA256>::Signer
+{
+public:
+    P256Signer(const DL_GroupParameters_EC<ECP>& params, const Integer& x)
+        : ECDSA<ECP, SHA256>::Signer(params, x) {}
+
+    size_t SignAndRestart(RandomNumberGenerator &rng, PK_MessageAccumulator &messageAccumulator, byte *signature, bool restart) const {
+        CRYPTOPP_UNUSED(restart);
+        PK_MessageAccumulatorBase &ma = static_cast<PK_MessageAccumulatorBase &>(messageAccumulator);
+        SecByteBlock representative(this->MessageRepresentativeLength());
+        this->GetMessageEncodingInterface().ComputeMessageRepresentative(
+            rng, ma.m_recoverableMessage, ma.m_recoverableMessage.size(),
+            ma.AccessHash(), this->GetHashIdentifier(), ma.m_empty,
+            representative, this->MessageRepresentativeBitLength());
+        ma.m_empty = true;
+
+        if (rng.CanIncorporateEntropy())
+            rng.IncorporateEntropy(representative, representative.size());
+        const Integer& q = this->GetKey().GetGroupParameters().GetSubgroupOrder();
+        Integer k;
+        do {
+            k.Randomize(rng, 1, q-1);
+        } while (!SignWithNonce(k, representative, signature));
+        return this->SignatureLength();
+    }
+
+    /* the signature with nonce k on the 32-byte message representative e;
+       false, in practice never, if k was unusable */
+    bool SignWithNonce(const Integer& k, const byte* e, byte* signature) const {
+        SecByteBlock kbytes(32), d(32);
+        k.Encode(kbytes, kbytes.size());
+        this->GetKey().GetPrivateExponent().Encode(d, d.size());
+        return p256_sign(signature, d, kbytes, e) == 0;
+    }
+};
+
+class P256Verifier : public ECDSA<ECP, SHA256>::Verifier
+{
+public:
+    P256Verifier(const DL_GroupParameters_EC<ECP>& params, const ECP::Point& q)
+        : ECDSA<ECP, SHA256>::Verifier(params, q) {
+        q.x.Encode(m_x, sizeof(m_x));
+        q.y.Encode(m_y, sizeof(m_y));
+        m_pre.width = 0;
+    }
+
+    /* the public point comes from p256.cpp too, since this computation
+       involves the private exponent */
+    P256Verifier(const P256Signer& signer) {
+        SecByteBlock d(32);
+        signer.GetKey().GetPrivateExponent().Encode(d, d.size());
+        p256_public_point(m_x, m_y, d);
+        this->AccessKey().Initialize(signer.GetKey().GetGroupParameters(),
+                                     ECP::Point(Integer(m_x, sizeof(m_x)), Integer(m_y, sizeof(m_y))));
+        m_pre.width = 0;
+    }
+
+    bool VerifyAndRestart(PK_MessageAccumulator &messageAccumulator) const {
+        PK_MessageAccumulatorBase &ma = static_cast<PK_MessageAccumulatorBase &>(messageAccumulator);
+        SecByteBlock representative(this->MessageRepresentativeLength());
+        this->GetMessageEncodingInterface().ComputeMessageRepresentative(
+            NullRNG(), ma.m_recoverableMessage, ma.m_recoverableMessage.size(),
+            ma.AccessHash(), this->GetHashIdentifier(), ma.m_empty,
+            representative, this->MessageRepresentativeBitLength());
+        ma.m_empty = true;
+
+        byte signature[64];
+        if (ma.m_semisignature.size() != 32 || ma.m_s.ByteCount() > 32)
+            return false;
+        memcpy(signature, ma.m_semisignature, 32);
+        ma.m_s.Encode(signature+32, 32);
+        return p256_verify(signature, representative, m_x, m_y, m_pre.width ? &m_pre : NULL);
+    }
+
+    void PrecomputeP256(unsigned int storage) {
+        p256_precompute(&m_pre, m_x, m_y, storage);
+    }
+
+private:
+    byte m_x[32], m_y[32];
+    p256_precomputed m_pre;
+};
+#else
+typedef ECDSA<ECP, SHA256>::Signer P256Signer;
+typedef ECDSA<ECP, SHA256>::Verifier P256Verifier;
+#endif
+
+/* Past this, bigger tables no longer make signing faster, while every new
+   key still pays to copy them. Also the default for the table of multiples
+   of a public point that VerifyingKey.precompute() builds. */
+static const unsigned int DEFAULT_BASE_PRECOMPUTATION_STORAGE = 32;
+
+/* Every key is initialized from a copy of this, so the curve is parsed and
+   the fixed-base table for the generator is built once per process rather
+   than once per key. It is only read or replaced with the GIL held. */
+static DL_GroupParameters_EC<ECP>* secp256r1_params = NULL;
+
+static DL_GroupParameters_EC<ECP>*
+new_secp256r1_params(unsigned int storage) {
+    DL_GroupParameters_EC<ECP>* params = new DL_GroupParameters_EC<ECP>(ASN1::secp256r1());
+    params->SetPointCompression(true);
+#ifdef PYCRYPTOPP_HAVE_P256
+    /* P256Signer and P256Verifier take multiples of the generator from the
+       comb that p256_init() builds, and never read Crypto++'s table, so
+       don't build one for every key to copy. */
+    CRYPTOPP_UNUSED(storage);
+#else
+    params->Precompute(storage);
+#endif
+    return params;
+}
+
 typedef struct {
     PyObject_HEAD
 
     /* internal */
-    ECDSA<ECP, SHA256>::Verifier *k;
+    P256Verifier *k;
+    PyThread_type_lock lock;
 } VerifyingKey;
 
 PyDoc_STRVAR(VerifyingKey__doc__,
@@ -100,15 +229,20 @@ VerifyingKey___init__(PyObject* self, PyObject* args, PyObject* kwdict) {
     }
 
     VerifyingKey *mself = reinterpret_cast<VerifyingKey*>(self);
+    if (!mself->lock) {
+        mself->lock = PyThread_allocate_lock();
+        if (!mself->lock) {
+            PyErr_NoMemory();
+            return -1;
+        }
+    }
 
     StringSource ss(reinterpret_cast<const byte*>(serializedverifyingkey), serializedverifyingkeysize, true);
 
     ECP::Element element;
-    DL_GroupParameters_EC<ECP> params(ASN1::secp256r1());
-    params.SetPointCompression(true);
     try {
-        element = params.DecodeElement(reinterpret_cast<const byte*>(serializedverifyingkey), true);
-        mself->k = new ECDSA<ECP, SHA256>::Verifier(params, element);
+        element = secp256r1_params->DecodeElement(reinterpret_cast<const byte*>(serializedverifyingkey), true);
+        mself->k = new P256Verifier(*secp256r1_params, element);
         if (!mself->k) {
             PyErr_NoMemory();
             return -1;
@@ -125,22 +259,32 @@ static void
 VerifyingKey_dealloc(VerifyingKey* self) {
     if (self->k)
         delete self->k;
+    PYCRYPTOPP_FREE_LOCK(self);
     self->ob_type->tp_free((PyObject*)self);
 }
 
 static PyObject *
 VerifyingKey_verify(VerifyingKey *self, PyObject *args, PyObject *kwdict) {
     static const char *kwlist[] = { "msg", "signature", NULL };
-    const char *msg;
-    Py_ssize_t msgsize;
-    const char *signature;
-    Py_ssize_t signaturesize = 0;
-    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#t#:verify", const_cast<char**>(kwlist), &msg, &msgsize, &signature, &signaturesize))
+    Py_buffer msg;
+    Py_buffer signature;
+    /* s* rather than t#, so that the buffers stay put while the GIL is
+       released */
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "s*s*:verify", const_cast<char**>(kwlist), &msg, &signature))
         return NULL;
-    assert (msgsize >= 0);
-    assert (signaturesize >= 0);
-
-    if (self->k->VerifyMessage(reinterpret_cast<const byte*>(msg), msgsize, reinterpret_cast<const byte*>(signature), signaturesize))
+    assert (msg.len >= 0);
+    assert (signature.len >= 0);
+
+    bool verified;
+    ENTER_PYCRYPTOPP(self);
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(self->lock != NULL)
+    verified = self->k->VerifyMessage(reinterpret_cast<const byte*>(msg.buf), msg.len, reinterpret_cast<const byte*>(signature.buf), signature.len);
+    PYCRYPTOPP_END_ALLOW_THREADS
+    LEAVE_PYCRYPTOPP(self);
+
+    PyBuffer_Release(&msg);
+    PyBuffer_Release(&signature);
+    if (verified)
         Py_RETURN_TRUE;
     else
         Py_RETURN_FALSE;
@@ -149,10 +293,47 @@ VerifyingKey_verify(VerifyingKey *self, PyObject *args, PyObject *kwdict) {
 PyDoc_STRVAR(VerifyingKey_verify__doc__,
 "Return whether the signature is a valid signature on the msg.");
 
+static PyObject *
+VerifyingKey_precompute(VerifyingKey *self, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "storage", NULL };
+    int storage = DEFAULT_BASE_PRECOMPUTATION_STORAGE;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "|i:precompute", const_cast<char**>(kwlist), &storage))
+        return NULL;
+
+    if (storage < 1 || storage > KEY_SIZE_BITS)
+        return PyErr_Format(ecdsa_error, "Precondition violation: storage is required to be between 1 and %d, but it was %d", KEY_SIZE_BITS, storage);
+
+    ENTER_PYCRYPTOPP(self);
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(self->lock != NULL)
+#ifdef PYCRYPTOPP_HAVE_P256
+    self->k->PrecomputeP256(storage);
+#else
+    DL_PublicKey_EC<ECP>& key = self->k->AccessKey();
+    const DL_GroupParameters_EC<ECP>& params = key.GetGroupParameters();
+    key.AccessPublicPrecomputation().Precompute(params.GetGroupPrecomputation(), params.GetSubgroupOrder().BitCount(), storage);
+#endif
+    PYCRYPTOPP_END_ALLOW_THREADS
+    LEAVE_PYCRYPTOPP(self);
+
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(VerifyingKey_precompute__doc__,
+"Build a table of multiples of the public point, so that verify() can treat it\n\
+as a fixed base just like the curve's generator. Worth doing for a key that\n\
+will check many signatures: building the table costs about a quarter of a\n\
+verification, and it keeps one point per entry.\n\
+\n\
+@param storage number of precomputed points\n\
+\n\
+@precondition 1 <= storage <= 256");
+
 static PyObject *
 VerifyingKey_serialize(VerifyingKey *self, PyObject *dummy) {
     ECDSA<ECP, SHA256>::Verifier *pubkey;
+    ENTER_PYCRYPTOPP(self);
     pubkey = new ECDSA<ECP, SHA256>::Verifier(*(self->k));
+    LEAVE_PYCRYPTOPP(self);
     const DL_GroupParameters_EC<ECP>& params = pubkey->GetKey().GetGroupParameters();
 
     Py_ssize_t len = params.GetEncodedElementSize(true);
@@ -172,6 +353,7 @@ the constructor of VerifyingKey to instantiate a new copy of this key.");
 
 static PyMethodDef VerifyingKey_methods[] = {
     {"verify", reinterpret_cast<PyCFunction>(VerifyingKey_verify), METH_KEYWORDS, VerifyingKey_verify__doc__},
+    {"precompute", reinterpret_cast<PyCFunction>(VerifyingKey_precompute), METH_KEYWORDS, VerifyingKey_precompute__doc__},
     {"serialize", reinterpret_cast<PyCFunction>(VerifyingKey_serialize), METH_NOARGS, VerifyingKey_serialize__doc__},
     {NULL},
 };
@@ -220,13 +402,15 @@ typedef struct {
     PyObject_HEAD
 
     /* internal */
-    ECDSA<ECP, SHA256>::Signer *k;
+    P256Signer *k;
+    PyThread_type_lock lock;
 } SigningKey;
 
 static void
 SigningKey_dealloc(SigningKey* self) {
     if (self->k)
         delete self->k;
+    PYCRYPTOPP_FREE_LOCK(self);
     self->ob_type->tp_free((PyObject*)self);
 }
 
@@ -284,9 +468,7 @@ SigningKey___init__(PyObject* self, PyObject* args, PyObject* kwdict) {
     Integer privexponentm1;
     privexponentm1.Decode(privexpbytes, sizeof(privexpbytes)); assert (privexponentm1 == 0); // just checking..
 
-    DL_GroupParameters_EC<ECP> params(ASN1::secp256r1());
-    params.SetPointCompression(true);
-    grouporderm1 = params.GetGroupOrder() - 1;
+    grouporderm1 = secp256r1_params->GetGroupOrder() - 1;
     SHA256 t;
 
     t.Update(reinterpret_cast<const byte*>(TAG_AND_SALT), TAG_AND_SALT_len);
@@ -304,8 +486,15 @@ SigningKey___init__(PyObject* self, PyObject* args, PyObject* kwdict) {
     }
 
     SigningKey* mself = reinterpret_cast<SigningKey*>(self);
+    if (!mself->lock) {
+        mself->lock = PyThread_allocate_lock();
+        if (!mself->lock) {
+            PyErr_NoMemory();
+            return -1;
+        }
+    }
 
-    mself->k = new ECDSA<ECP, SHA256>::Signer(params, privexponentm1+1);
+    mself->k = new P256Signer(*secp256r1_params, privexponentm1+1);
 
     if (!mself->k) {
         PyErr_NoMemory();
@@ -397,7 +586,8 @@ static PyObject *
 SigningKey_sign(SigningKey *self, PyObject *msgobj) {
     const char *msg;
     Py_ssize_t msgsize;
-    PyString_AsStringAndSize(msgobj, const_cast<char**>(&msg), reinterpret_cast<Py_ssize_t*>(&msgsize));
+    if (PyString_AsStringAndSize(msgobj, const_cast<char**>(&msg), reinterpret_cast<Py_ssize_t*>(&msgsize)))
+        return NULL;
     assert (msgsize >= 0);
 
     Py_ssize_t sigsize;
@@ -408,18 +598,44 @@ SigningKey_sign(SigningKey *self, PyObject *msgobj) {
         return NULL;
     assert (sigsize >= 0);
 
-    AutoSeededRandomPool randpool(false); //XXX
-
-    Py_ssize_t siglengthwritten;
+    Py_ssize_t siglengthwritten = 0;
+    std::string err, rngerr, signerr;
+    bool nomem = false;
+    ENTER_PYCRYPTOPP(self);
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(self->lock != NULL)
     try {
         siglengthwritten = self->k->SignMessage(
-            randpool,
+            pycryptopp_thread_rng(),
             reinterpret_cast<const byte*>(msg),
             msgsize,
             reinterpret_cast<byte*>(PyString_AS_STRING(result)));
-    } catch (InvalidDataFormat le) {
+    } catch (InvalidDataFormat& le) {
+        err = le.what();
+    } catch (OS_RNG_Err& le) {
+        rngerr = le.what();
+    } catch (CryptoPP::Exception& le) {
+        signerr = le.what();
+    } catch (std::bad_alloc&) {
+        nomem = true;
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    LEAVE_PYCRYPTOPP(self);
+
+    if (nomem) {
+        Py_DECREF(result);
+        return PyErr_NoMemory();
+    }
+    if (!rngerr.empty()) {
         Py_DECREF(result);
-        return PyErr_Format(ecdsa_error, "Signing key was corrupted.  Crypto++ gave this exception: %s", le.what());
+        return PyErr_Format(ecdsa_error, "Could not seed the random number generator.  Crypto++ gave this exception: %s", rngerr.c_str());
+    }
+    if (!err.empty()) {
+        Py_DECREF(result);
+        return PyErr_Format(ecdsa_error, "Signing key was corrupted.  Crypto++ gave this exception: %s", err.c_str());
+    }
+    if (!signerr.empty()) {
+        Py_DECREF(result);
+        return PyErr_Format(ecdsa_error, "Signing failed.  Crypto++ gave this exception: %s", signerr.c_str());
     }
 
     if (siglengthwritten < sigsize)
@@ -442,7 +658,16 @@ SigningKey_get_verifying_key(SigningKey *self, PyObject *dummy) {
     if (!verifier)
         return NULL;
 
-    verifier->k = new ECDSA<ECP, SHA256>::Verifier(*(self->k));
+    verifier->k = NULL;
+    verifier->lock = PyThread_allocate_lock();
+    if (!verifier->lock) {
+        Py_DECREF(verifier);
+        return PyErr_NoMemory();
+    }
+
+    ENTER_PYCRYPTOPP(self);
+    verifier->k = new P256Verifier(*(self->k));
+    LEAVE_PYCRYPTOPP(self);
     if (!verifier->k)
         return PyErr_NoMemory();
     verifier->k->AccessKey().AccessGroupParameters().SetPointCompression(true);
@@ -500,8 +725,96 @@ static PyTypeObject SigningKey_type = {
     SigningKey___init__,       /* tp_init */
 };
 
+PyObject *
+ecdsa_precompute_base(PyObject *dummy, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = {
+        "storage",
+        NULL
+    };
+    int storage;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "i:precompute_base", const_cast<char**>(kwlist), &storage))
+        return NULL;
+
+    if (storage < 1 || storage > KEY_SIZE_BITS)
+        return PyErr_Format(ecdsa_error, "Precondition violation: storage is required to be between 1 and %d, but it was %d", KEY_SIZE_BITS, storage);
+
+#ifndef PYCRYPTOPP_HAVE_P256
+    DL_GroupParameters_EC<ECP>* params = new_secp256r1_params(storage);
+    delete secp256r1_params;
+    secp256r1_params = params;
+#endif
+    Py_RETURN_NONE;
+}
+
+const char*const ecdsa_precompute_base__doc__ = "Rebuild the table of multiples of the curve's generator that speeds up\n\
+signing and half of verification in Crypto++'s generic curve arithmetic.\n\
+\n\
+Keys constructed afterwards use the new table; existing keys keep theirs.\n\
+A larger table makes signing faster but every key carries its own copy,\n\
+so key construction gets slower. The default is 32.\n\
+\n\
+When the compiler has a 128-bit integer type, signing and verification use\n\
+pycryptopp's own P-256 code instead, whose table of the generator is fixed\n\
+and shared by all keys. Then there is no per-key table and this only checks\n\
+its argument.\n\
+\n\
+@param storage number of precomputed points\n\
+\n\
+@precondition 1 <= storage <= 256";
+
+PyObject *
+ecdsa__test_raw_sign(PyObject *dummy, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "key", "k", "e", "generic", NULL };
+    SigningKey *key;
+    const char *kbytes, *ebytes;
+    Py_ssize_t ksize, esize;
+    int generic = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "O!t#t#|i:_test_raw_sign", const_cast<char**>(kwlist), &SigningKey_type, &key, &kbytes, &ksize, &ebytes, &esize, &generic))
+        return NULL;
+    if (ksize != 32 || esize != 32)
+        return PyErr_Format(ecdsa_error, "Precondition violation: k and e are required to be of length 32, but they were %zd and %zd", ksize, esize);
+
+    Integer k(reinterpret_cast<const byte*>(kbytes), ksize);
+    Integer e(reinterpret_cast<const byte*>(ebytes), esize);
+    if (k < 1 || k >= secp256r1_params->GetSubgroupOrder())
+        return PyErr_Format(ecdsa_error, "Precondition violation: k is required to be between 1 and the group order");
+
+    PyObject* result = PyString_FromStringAndSize(NULL, 64);
+    if (!result)
+        return NULL;
+    byte* sig = reinterpret_cast<byte*>(PyString_AS_STRING(result));
+    ENTER_PYCRYPTOPP(key);
+#ifdef PYCRYPTOPP_HAVE_P256
+    if (!generic)
+        key->k->SignWithNonce(k, reinterpret_cast<const byte*>(ebytes), sig);
+    else
+#endif
+    {
+        Integer r, s;
+        key->k->ECDSA<ECP, SHA256>::Signer::RawSign(k, e, r, s);
+        r.Encode(sig, 32);
+        s.Encode(sig+32, 32);
+    }
+    LEAVE_PYCRYPTOPP(key);
+
+    return result;
+}
+
+const char*const ecdsa__test_raw_sign__doc__ = "For testing only: return the signature r||s by the SigningKey key with\n\
+nonce k on the message representative e (both 32-byte strings), computed\n\
+by the P-256 code or, if generic is true, by Crypto++'s generic curve\n\
+arithmetic. Signing twice with the same k, or with a k that can be\n\
+guessed, gives away the private key.";
+
 void
 init_ecdsa(PyObject*const module) {
+    if (!secp256r1_params)
+        secp256r1_params = new_secp256r1_params(DEFAULT_BASE_PRECOMPUTATION_STORAGE);
+#ifdef PYCRYPTOPP_HAVE_P256
+    p256_init();
+#endif
+
     VerifyingKey_type.tp_new = PyType_GenericNew;
     if (PyType_Ready(&VerifyingKey_type) < 0)
         return;
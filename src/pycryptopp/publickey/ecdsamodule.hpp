@@ -4,4 +4,12 @@
 void
 init_ecdsa(PyObject* module);
 
+extern PyObject *
+ecdsa_precompute_base(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const ecdsa_precompute_base__doc__;
+
+extern PyObject *
+ecdsa__test_raw_sign(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const ecdsa__test_raw_sign__doc__;
+
 #endif /* #ifndef __INCL_ECDSAMODULE_HPP */
@@ -1,6 +1,7 @@
-from keys import (BadSignatureError, SigningKey, VerifyingKey, __doc__)
+from keys import (BadSignatureError, SigningKey, VerifyingKey, verify_batch,
+                  __doc__)
 
-(BadSignatureError, SigningKey, VerifyingKey, __doc__) # hush pyflakes
+(BadSignatureError, SigningKey, VerifyingKey, verify_batch, __doc__) # hush pyflakes
 
 from _version import get_versions
 __version__ = get_versions()['version']
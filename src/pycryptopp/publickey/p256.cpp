@@ -0,0 +1,815 @@
+/**
+ * p256.cpp -- secp256r1 arithmetic on four 64-bit limbs
+ *
+ * Field elements are kept fully reduced below p, least significant limb
+ * first, and multiplied with NIST's Solinas reduction for
+ * p = 2^256 - 2^224 + 2^192 + 2^96 - 1. Points are in Jacobian
+ * coordinates. Scalars modulo the group order n are multiplied in
+ * Montgomery form.
+ *
+ * d*G and k*G use a comb: 64 rows of the 15 nonzero multiples of 16^i G.
+ * They add one row entry per nibble of the scalar, chosen by scanning the
+ * whole row. Verification adds u1*G from the same comb, on top of a wNAF
+ * multiplication of u2 by the public point.
+ */
+
+#include "p256.hpp"
+
+#ifdef PYCRYPTOPP_HAVE_P256
+
+#include <string.h>
+
+typedef unsigned __int128 uint128;
+typedef uint64_t fe[4];
+
+typedef struct {
+    fe X, Y, Z; /* (X/Z^2, Y/Z^3), or the point at infinity if Z is 0 */
+} jacobian;
+
+static const fe P = { 0xFFFFFFFFFFFFFFFFULL, 0x00000000FFFFFFFFULL, 0x0000000000000000ULL, 0xFFFFFFFF00000001ULL };
+static const fe N = { 0xF3B9CAC2FC632551ULL, 0xBCE6FAADA7179E84ULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFF00000000ULL };
+static const fe GX = { 0xF4A13945D898C296ULL, 0x77037D812DEB33A0ULL, 0xF8BCE6E563A440F2ULL, 0x6B17D1F2E12C4247ULL };
+static const fe GY = { 0xCBB6406837BF51F5ULL, 0x2BCE33576B315ECEULL, 0x8EE7EB4A7C0F9E16ULL, 0x4FE342E2FE1A7F9BULL };
+static const fe ONE = { 1, 0, 0, 0 };
+
+static uint64_t n0;      /* -1/n mod 2^64 */
+static fe rr_n;          /* 2^512 mod n */
+static fe one_n;         /* 2^256 mod n, which is 1 in Montgomery form */
+static p256_affine comb[64][15];
+
+static void
+from_bytes(fe r, const unsigned char b[32]) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t w = 0;
+        for (int j = 0; j < 8; j++)
+            w = (w << 8) | b[8*(3-i) + j];
+        r[i] = w;
+    }
+}
+
+static void
+to_bytes(unsigned char b[32], const fe a) {
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 8; j++)
+            b[8*(3-i) + j] = (unsigned char)(a[i] >> (56 - 8*j));
+}
+
+static void
+copy(fe r, const fe a) {
+    memcpy(r, a, sizeof(fe));
+}
+
+/* r = a if mask is all ones, left alone if mask is zero */
+static void
+cmov(fe r, const fe a, uint64_t mask) {
+    for (int i = 0; i < 4; i++)
+        r[i] ^= mask & (r[i] ^ a[i]);
+}
+
+static bool
+iszero_vartime(const fe a) {
+    return (a[0] | a[1] | a[2] | a[3]) == 0;
+}
+
+static bool
+equal_vartime(const fe a, const fe b) {
+    return memcmp(a, b, sizeof(fe)) == 0;
+}
+
+/* a < b, for public values */
+static bool
+less_vartime(const fe a, const fe b) {
+    for (int i = 3; i >= 0; i--)
+        if (a[i] != b[i])
+            return a[i] < b[i];
+    return false;
+}
+
+/* r = a mod m, for a + hi*2^256 < 2m and hi 0 or 1 */
+static void
+reduce_once(fe r, const fe a, uint64_t hi, const fe m) {
+    fe t;
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; i++) {
+        uint128 d = (uint128)a[i] - m[i] - borrow;
+        t[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    /* keep a only if it was below m, i.e. the subtraction went negative */
+    uint64_t keep = 0 - ((~hi & borrow) & 1);
+    for (int i = 0; i < 4; i++)
+        r[i] = (a[i] & keep) | (t[i] & ~keep);
+}
+
+static void
+add_mod(fe r, const fe a, const fe b, const fe m) {
+    fe t;
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; i++) {
+        uint128 s = (uint128)a[i] + b[i] + carry;
+        t[i] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+    reduce_once(r, t, carry, m);
+}
+
+static void
+sub_mod(fe r, const fe a, const fe b, const fe m) {
+    fe t;
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; i++) {
+        uint128 d = (uint128)a[i] - b[i] - borrow;
+        t[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    uint64_t mask = 0 - borrow;
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; i++) {
+        uint128 s = (uint128)t[i] + (m[i] & mask) + carry;
+        r[i] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+}
+
+static void
+mul_wide(uint64_t c[8], const fe a, const fe b) {
+    for (int i = 0; i < 8; i++)
+        c[i] = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < 4; j++) {
+            uint128 t = (uint128)a[i]*b[j] + c[i+j] + carry;
+            c[i+j] = (uint64_t)t;
+            carry = (uint64_t)(t >> 64);
+        }
+        c[i+4] = carry;
+    }
+}
+
+typedef __int128 int128;
+
+/* propagate the carries through four signed limbs, returning the carry out
+   of the top */
+static int64_t
+carry_limbs(int128 l[4]) {
+    const int128 mask = (int128)~(uint64_t)0;
+    for (int j = 0; j < 3; j++) {
+        l[j+1] += l[j] >> 64;
+        l[j] &= mask;
+    }
+    int64_t top = (int64_t)(l[3] >> 64);
+    l[3] &= mask;
+    return top;
+}
+
+/* Solinas reduction of a 512-bit product, from FIPS 186-4 D.2.3 */
+static void
+fe_reduce(fe r, const uint64_t c[8]) {
+    int64_t w[16];
+    for (int i = 0; i < 8; i++) {
+        w[2*i] = (int64_t)(c[i] & 0xFFFFFFFF);
+        w[2*i+1] = (int64_t)(c[i] >> 32);
+    }
+
+    /* T + 2S1 + 2S2 + S3 + S4 - D1 - D2 - D3 - D4, column by column */
+    int64_t acc[8];
+    acc[0] = w[0] + w[8] + w[9] - w[11] - w[12] - w[13] - w[14];
+    acc[1] = w[1] + w[9] + w[10] - w[12] - w[13] - w[14] - w[15];
+    acc[2] = w[2] + w[10] + w[11] - w[13] - w[14] - w[15];
+    acc[3] = w[3] + 2*w[11] + 2*w[12] + w[13] - w[15] - w[8] - w[9];
+    acc[4] = w[4] + 2*w[12] + 2*w[13] + w[14] - w[9] - w[10];
+    acc[5] = w[5] + 2*w[13] + 2*w[14] + w[15] - w[10] - w[11];
+    acc[6] = w[6] + 3*w[14] + 2*w[15] + w[13] - w[8] - w[9];
+    acc[7] = w[7] + 3*w[15] + w[8] - w[10] - w[11] - w[12] - w[13];
+
+    int128 l[4];
+    for (int i = 0; i < 4; i++)
+        l[i] = (int128)acc[2*i] + (int128)acc[2*i+1]*((int64_t)1 << 32);
+
+    /* The sum lies in (-4*2^256, 7*2^256). Fold the carry out of the top
+       back in as 2^256 = 2^224 - 2^192 - 2^96 + 1 (mod p); the second fold
+       leaves no carry, and a value below 2^256 < 2p. */
+    for (int round = 0; round < 2; round++) {
+        int64_t t = carry_limbs(l);
+        l[0] += t;
+        l[1] -= (int128)t*((int64_t)1 << 32);
+        l[3] += (int128)t*(((int64_t)1 << 32) - 1);
+    }
+    carry_limbs(l);
+
+    fe v;
+    for (int i = 0; i < 4; i++)
+        v[i] = (uint64_t)l[i];
+    reduce_once(r, v, 0, P);
+}
+
+static void
+fe_add(fe r, const fe a, const fe b) {
+    add_mod(r, a, b, P);
+}
+
+static void
+fe_sub(fe r, const fe a, const fe b) {
+    sub_mod(r, a, b, P);
+}
+
+static void
+fe_mul(fe r, const fe a, const fe b) {
+    uint64_t c[8];
+    mul_wide(c, a, b);
+    fe_reduce(r, c);
+}
+
+/* the cross products once, doubled, then the squares */
+static void
+fe_sqr(fe r, const fe a) {
+    uint64_t c[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    uint128 t;
+    uint64_t carry;
+    for (int i = 0; i < 3; i++) {
+        carry = 0;
+        for (int j = i+1; j < 4; j++) {
+            t = (uint128)a[i]*a[j] + c[i+j] + carry;
+            c[i+j] = (uint64_t)t;
+            carry = (uint64_t)(t >> 64);
+        }
+        c[i+4] = carry;
+    }
+    c[7] = c[6] >> 63;
+    for (int i = 6; i > 0; i--)
+        c[i] = (c[i] << 1) | (c[i-1] >> 63);
+    c[0] <<= 1;
+    carry = 0;
+    for (int i = 0; i < 4; i++) {
+        t = (uint128)a[i]*a[i] + c[2*i] + carry;
+        c[2*i] = (uint64_t)t;
+        t = (uint128)c[2*i+1] + (uint64_t)(t >> 64);
+        c[2*i+1] = (uint64_t)t;
+        carry = (uint64_t)(t >> 64);
+    }
+    fe_reduce(r, c);
+}
+
+static void
+fe_sqr_n(fe r, const fe a, int n) {
+    copy(r, a);
+    while (n--)
+        fe_sqr(r, r);
+}
+
+/* a^(p-2), with p-2 = ffffffff 00000001 00000000 00000000 00000000
+   ffffffff ffffffff fffffffd built up from runs of ones */
+static void
+fe_inv(fe r, const fe a) {
+    fe x2, x3, x6, x12, x15, x30, x32, t;
+    fe_sqr(x2, a);
+    fe_mul(x2, x2, a);
+    fe_sqr(x3, x2);
+    fe_mul(x3, x3, a);
+    fe_sqr_n(x6, x3, 3);
+    fe_mul(x6, x6, x3);
+    fe_sqr_n(x12, x6, 6);
+    fe_mul(x12, x12, x6);
+    fe_sqr_n(x15, x12, 3);
+    fe_mul(x15, x15, x3);
+    fe_sqr_n(x30, x15, 15);
+    fe_mul(x30, x30, x15);
+    fe_sqr_n(x32, x30, 2);
+    fe_mul(x32, x32, x2);
+
+    fe_sqr_n(t, x32, 32);
+    fe_mul(t, t, a);
+    fe_sqr_n(t, t, 128);
+    fe_mul(t, t, x32);
+    fe_sqr_n(t, t, 32);
+    fe_mul(t, t, x32);
+    fe_sqr_n(t, t, 30);
+    fe_mul(t, t, x30);
+    fe_sqr_n(t, t, 2);
+    fe_mul(r, t, a);
+}
+
+/* Montgomery multiplication modulo n: r = a*b/2^256 mod n */
+static void
+mont_mul_n(fe r, const fe a, const fe b) {
+    uint64_t t[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < 4; i++) {
+        uint64_t c = 0;
+        uint128 x;
+        for (int j = 0; j < 4; j++) {
+            x = (uint128)a[i]*b[j] + t[j] + c;
+            t[j] = (uint64_t)x;
+            c = (uint64_t)(x >> 64);
+        }
+        x = (uint128)t[4] + c;
+        t[4] = (uint64_t)x;
+        t[5] = (uint64_t)(x >> 64);
+
+        uint64_t m = t[0]*n0;
+        x = (uint128)m*N[0] + t[0];
+        c = (uint64_t)(x >> 64);
+        for (int j = 1; j < 4; j++) {
+            x = (uint128)m*N[j] + t[j] + c;
+            t[j-1] = (uint64_t)x;
+            c = (uint64_t)(x >> 64);
+        }
+        x = (uint128)t[4] + c;
+        t[3] = (uint64_t)x;
+        t[4] = t[5] + (uint64_t)(x >> 64);
+    }
+    reduce_once(r, t, t[4], N);
+}
+
+/* r = a^(n-2) mod n, in Montgomery form, with 4-bit windows over the
+   public exponent */
+static void
+inv_mod_n(fe r, const fe a) {
+    fe powers[16], e, acc;
+    copy(powers[0], one_n);
+    for (int i = 1; i < 16; i++)
+        mont_mul_n(powers[i], powers[i-1], a);
+    copy(e, N);
+    e[0] -= 2;
+    copy(acc, one_n);
+    for (int i = 63; i >= 0; i--) {
+        for (int j = 0; j < 4; j++)
+            mont_mul_n(acc, acc, acc);
+        unsigned int d = (unsigned int)(e[i/16] >> (4*(i%16))) & 15;
+        if (d)
+            mont_mul_n(acc, acc, powers[d]);
+    }
+    copy(r, acc);
+}
+
+static void
+point_set_affine(jacobian *r, const p256_affine *a) {
+    copy(r->X, a->x);
+    copy(r->Y, a->y);
+    copy(r->Z, ONE);
+}
+
+/* r = 2p, "dbl-2001-b" for a = -3; maps infinity to infinity */
+static void
+point_double(jacobian *r, const jacobian *p) {
+    fe delta, gamma, beta, alpha, t1, t2;
+    fe_sqr(delta, p->Z);
+    fe_sqr(gamma, p->Y);
+    fe_mul(beta, p->X, gamma);
+    fe_sub(t1, p->X, delta);
+    fe_add(t2, p->X, delta);
+    fe_mul(alpha, t1, t2);
+    fe_add(t1, alpha, alpha);
+    fe_add(alpha, alpha, t1);
+
+    fe_add(t1, p->Y, p->Z);
+    fe_sqr(t1, t1);
+    fe_sub(t1, t1, gamma);
+    fe_sub(r->Z, t1, delta);
+
+    fe_add(beta, beta, beta);
+    fe_add(beta, beta, beta);          /* 4*beta */
+    fe_sqr(t1, alpha);
+    fe_add(t2, beta, beta);
+    fe_sub(r->X, t1, t2);
+
+    fe_sub(t1, beta, r->X);
+    fe_mul(t1, alpha, t1);
+    fe_sqr(gamma, gamma);
+    fe_add(gamma, gamma, gamma);
+    fe_add(gamma, gamma, gamma);
+    fe_add(gamma, gamma, gamma);       /* 8*gamma^2 */
+    fe_sub(r->Y, t1, gamma);
+}
+
+/* r = p + q, "madd-2007-bl". p must not be infinity, and p must not be
+   q or -q; the result is garbage otherwise. */
+static void
+point_add_affine(jacobian *r, const jacobian *p, const p256_affine *q) {
+    fe z1z1, u2, s2, h, hh, i, j, rr, v, t;
+    fe_sqr(z1z1, p->Z);
+    fe_mul(u2, q->x, z1z1);
+    fe_mul(s2, q->y, p->Z);
+    fe_mul(s2, s2, z1z1);
+    fe_sub(h, u2, p->X);
+    fe_sqr(hh, h);
+    fe_add(i, hh, hh);
+    fe_add(i, i, i);
+    fe_mul(j, h, i);
+    fe_sub(rr, s2, p->Y);
+    fe_add(rr, rr, rr);
+    fe_mul(v, p->X, i);
+
+    fe_add(t, p->Z, h);
+    fe_sqr(t, t);
+    fe_sub(t, t, z1z1);
+    fe_sub(r->Z, t, hh);
+
+    fe_mul(t, p->Y, j);
+    fe_add(t, t, t);                   /* 2*Y1*J, before r->Y is written */
+    fe_sqr(u2, rr);
+    fe_sub(u2, u2, j);
+    fe_sub(u2, u2, v);
+    fe_sub(u2, u2, v);                 /* X3 */
+    fe_sub(v, v, u2);
+    fe_mul(v, rr, v);
+    fe_sub(r->Y, v, t);
+    copy(r->X, u2);
+}
+
+/* r = p + q for any p and q, not in constant time */
+static void
+point_add_affine_vartime(jacobian *r, const jacobian *p, const p256_affine *q) {
+    if (iszero_vartime(p->Z)) {
+        point_set_affine(r, q);
+        return;
+    }
+    fe z1z1, u2, s2;
+    fe_sqr(z1z1, p->Z);
+    fe_mul(u2, q->x, z1z1);
+    if (equal_vartime(u2, p->X)) {
+        fe_mul(s2, q->y, p->Z);
+        fe_mul(s2, s2, z1z1);
+        if (equal_vartime(s2, p->Y))
+            point_double(r, p);
+        else
+            memset(r, 0, sizeof(*r));
+        return;
+    }
+    point_add_affine(r, p, q);
+}
+
+/* r = p + q for any p and q, "add-2007-bl", not in constant time */
+static void
+point_add_vartime(jacobian *r, const jacobian *p, const jacobian *q) {
+    if (iszero_vartime(p->Z)) {
+        *r = *q;
+        return;
+    }
+    if (iszero_vartime(q->Z)) {
+        *r = *p;
+        return;
+    }
+    fe z1z1, z2z2, u1, u2, s1, s2, h, i, j, rr, v, t;
+    fe_sqr(z1z1, p->Z);
+    fe_sqr(z2z2, q->Z);
+    fe_mul(u1, p->X, z2z2);
+    fe_mul(u2, q->X, z1z1);
+    fe_mul(s1, p->Y, q->Z);
+    fe_mul(s1, s1, z2z2);
+    fe_mul(s2, q->Y, p->Z);
+    fe_mul(s2, s2, z1z1);
+    if (equal_vartime(u1, u2)) {
+        if (equal_vartime(s1, s2))
+            point_double(r, p);
+        else
+            memset(r, 0, sizeof(*r));
+        return;
+    }
+    fe_sub(h, u2, u1);
+    fe_add(i, h, h);
+    fe_sqr(i, i);
+    fe_mul(j, h, i);
+    fe_sub(rr, s2, s1);
+    fe_add(rr, rr, rr);
+    fe_mul(v, u1, i);
+
+    fe_add(t, p->Z, q->Z);
+    fe_sqr(t, t);
+    fe_sub(t, t, z1z1);
+    fe_sub(t, t, z2z2);
+    fe_mul(r->Z, t, h);
+
+    fe_mul(s1, s1, j);
+    fe_add(s1, s1, s1);
+    fe_sqr(t, rr);
+    fe_sub(t, t, j);
+    fe_sub(t, t, v);
+    fe_sub(t, t, v);
+    fe_sub(v, v, t);
+    fe_mul(v, rr, v);
+    fe_sub(r->Y, v, s1);
+    copy(r->X, t);
+}
+
+/* Converts points, none of them infinity, to affine coordinates with a
+   single inversion. out[k].x holds the product of the first k+1 Zs until
+   the second pass gets to it. */
+static void
+batch_to_affine(p256_affine *out, const jacobian *in, size_t count) {
+    fe acc, inv, zinv, zinv2, t;
+    copy(acc, ONE);
+    for (size_t k = 0; k < count; k++) {
+        fe_mul(acc, acc, in[k].Z);
+        copy(out[k].x, acc);
+    }
+    fe_inv(inv, acc);
+    for (size_t k = count; k-- > 0; ) {
+        if (k > 0)
+            fe_mul(zinv, inv, out[k-1].x);
+        else
+            copy(zinv, inv);
+        fe_mul(inv, inv, in[k].Z);
+        fe_sqr(zinv2, zinv);
+        fe_mul(out[k].x, in[k].X, zinv2);
+        fe_mul(t, zinv2, zinv);
+        fe_mul(out[k].y, in[k].Y, t);
+    }
+}
+
+/* out = q, 3q, 5q, ..., (2*count-1)q, using count points of scratch */
+static void
+odd_multiples(p256_affine *out, jacobian *scratch, const jacobian *q, size_t count) {
+    jacobian twice;
+    point_double(&twice, q);
+    scratch[0] = *q;
+    for (size_t k = 1; k < count; k++)
+        point_add_vartime(&scratch[k], &scratch[k-1], &twice);
+    batch_to_affine(out, scratch, count);
+}
+
+static unsigned int
+nibble(const fe k, unsigned int i) {
+    return (unsigned int)(k[i/16] >> (4*(i%16))) & 15;
+}
+
+/* r = k*G for k < n, in time independent of k */
+static void
+scalar_base_mult(jacobian *r, const fe k) {
+    jacobian acc, sum;
+    uint64_t acc_inf = ~(uint64_t)0;
+    p256_affine t;
+
+    memset(&acc, 0, sizeof(acc));
+    for (unsigned int i = 0; i < 64; i++) {
+        uint64_t d = nibble(k, i);
+
+        /* t = comb[i][d-1], or zero if d is zero; every entry is read */
+        memset(&t, 0, sizeof(t));
+        for (uint64_t j = 1; j < 16; j++) {
+            uint64_t mask = 0 - (((d ^ j) - 1) >> 63);
+            cmov(t.x, comb[i][j-1].x, mask);
+            cmov(t.y, comb[i][j-1].y, mask);
+        }
+
+        /* The partial sum is a multiple of G below 16^i, and the new entry
+           one of at least 16^i (or zero), so they never collide and the
+           formulas that can't double are enough. */
+        point_add_affine(&sum, &acc, &t);
+
+        /* acc = t if acc was infinity, sum otherwise, unless d is zero */
+        uint64_t nonzero = 0 - ((d + 15) >> 4);
+        uint64_t take_sum = nonzero & ~acc_inf;
+        uint64_t take_entry = nonzero & acc_inf;
+        cmov(acc.X, sum.X, take_sum);
+        cmov(acc.Y, sum.Y, take_sum);
+        cmov(acc.Z, sum.Z, take_sum);
+        cmov(acc.X, t.x, take_entry);
+        cmov(acc.Y, t.y, take_entry);
+        cmov(acc.Z, ONE, take_entry);
+        acc_inf &= ~nonzero;
+    }
+    *r = acc;
+}
+
+static void
+to_affine(fe x, fe y, const jacobian *p) {
+    fe zinv, zinv2, t;
+    fe_inv(zinv, p->Z);
+    fe_sqr(zinv2, zinv);
+    fe_mul(x, p->X, zinv2);
+    fe_mul(t, zinv2, zinv);
+    fe_mul(y, p->Y, t);
+}
+
+/* Width-w non-adjacent form of k, least significant digit first, into
+   naf[0..len). len must be at least one more than the bit length of k. */
+static void
+wnaf(int *naf, size_t len, const fe k, unsigned int w) {
+    uint64_t t[5] = { k[0], k[1], k[2], k[3], 0 };
+    const int64_t window = (int64_t)1 << w;
+    for (size_t i = 0; i < len; i++) {
+        int64_t d = 0;
+        if (t[0] & 1) {
+            d = (int64_t)(t[0] & (window - 1));
+            if (d >= window/2)
+                d -= window;
+            /* t -= d, which leaves t divisible by 2^w */
+            if (d > 0) {
+                uint64_t borrow = (uint64_t)d;
+                for (int j = 0; j < 5 && borrow; j++) {
+                    uint64_t old = t[j];
+                    t[j] = old - borrow;
+                    borrow = old < borrow;
+                }
+            } else {
+                uint64_t carry = (uint64_t)-d;
+                for (int j = 0; j < 5 && carry; j++) {
+                    t[j] += carry;
+                    carry = t[j] < carry;
+                }
+            }
+        }
+        naf[i] = (int)d;
+        for (int j = 0; j < 4; j++)
+            t[j] = (t[j] >> 1) | (t[j+1] << 63);
+        t[4] >>= 1;
+    }
+}
+
+/* acc = acc + d*table, where table holds the odd multiples */
+static void
+add_digit_vartime(jacobian *acc, int d, const p256_affine *table) {
+    if (d > 0) {
+        point_add_affine_vartime(acc, acc, &table[(d-1)/2]);
+    } else if (d < 0) {
+        p256_affine neg = table[(-d-1)/2];
+        fe_sub(neg.y, P, neg.y);
+        point_add_affine_vartime(acc, acc, &neg);
+    }
+}
+
+void
+p256_init() {
+    /* n0 by Newton's iteration, each round doubling the number of correct
+       low bits (an odd number is its own inverse mod 8) */
+    uint64_t inv = N[0];
+    for (int i = 0; i < 5; i++)
+        inv *= 2 - N[0]*inv;
+    n0 = 0 - inv;
+
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; i++) { /* 2^256 - n */
+        uint128 d = (uint128)0 - N[i] - borrow;
+        one_n[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    copy(rr_n, one_n);
+    for (int i = 0; i < 256; i++)
+        add_mod(rr_n, rr_n, rr_n, N);
+
+    std::vector<jacobian> rows(64*15);
+    jacobian base;
+    copy(base.X, GX);
+    copy(base.Y, GY);
+    copy(base.Z, ONE);
+    for (int i = 0; i < 64; i++) {
+        jacobian *row = &rows[15*i];
+        row[0] = base;
+        point_double(&row[1], &base);
+        for (int j = 2; j < 15; j++)
+            point_add_vartime(&row[j], &row[j-1], &base);
+        point_double(&base, &row[7]); /* 16 * base */
+    }
+    batch_to_affine(&comb[0][0], &rows[0], 64*15);
+}
+
+void
+p256_public_point(unsigned char x[32], unsigned char y[32], const unsigned char d[32]) {
+    fe k, ax, ay;
+    jacobian q;
+    from_bytes(k, d);
+    scalar_base_mult(&q, k);
+    to_affine(ax, ay, &q);
+    to_bytes(x, ax);
+    to_bytes(y, ay);
+}
+
+int
+p256_sign(unsigned char sig[64], const unsigned char d[32], const unsigned char k[32], const unsigned char e[32]) {
+    fe kk, dd, ee, x, y, r, s, km, kinv, t;
+    jacobian kg;
+
+    from_bytes(kk, k);
+    from_bytes(dd, d);
+    from_bytes(ee, e);
+    reduce_once(ee, ee, 0, N);
+
+    scalar_base_mult(&kg, kk);
+    to_affine(x, y, &kg);
+    reduce_once(r, x, 0, N); /* x < p < 2n */
+
+    /* s = (e + d*r)/k mod n */
+    mont_mul_n(km, kk, rr_n);
+    inv_mod_n(kinv, km);
+    mont_mul_n(t, dd, rr_n);
+    mont_mul_n(t, t, r);     /* d*r, out of Montgomery form */
+    add_mod(t, t, ee, N);
+    mont_mul_n(s, kinv, t);  /* kinv carries the factor that cancels */
+
+    to_bytes(sig, r);
+    to_bytes(sig + 32, s);
+    return (iszero_vartime(r) || iszero_vartime(s)) ? -1 : 0;
+}
+
+void
+p256_precompute(p256_precomputed *pre, const unsigned char x[32], const unsigned char y[32], unsigned int storage) {
+    jacobian q;
+    from_bytes(q.X, x);
+    from_bytes(q.Y, y);
+    copy(q.Z, ONE);
+
+    /* With room for two tables, the second one, for 2^128 Q, halves the
+       doublings that verification needs. */
+    size_t per_table = storage >= 2 ? storage/2 : 1;
+    size_t count = 1;
+    unsigned int width = 2;
+    while (2*count <= per_table) {
+        count *= 2;
+        width++;
+    }
+
+    std::vector<jacobian> scratch(count);
+    pre->low.resize(count);
+    odd_multiples(&pre->low[0], &scratch[0], &q, count);
+    if (storage >= 2) {
+        jacobian q128 = q;
+        for (int i = 0; i < 128; i++)
+            point_double(&q128, &q128);
+        pre->high.resize(count);
+        odd_multiples(&pre->high[0], &scratch[0], &q128, count);
+    } else {
+        pre->high.clear();
+    }
+    pre->width = width;
+}
+
+bool
+p256_verify(const unsigned char sig[64], const unsigned char e[32], const unsigned char x[32], const unsigned char y[32], const p256_precomputed *pre) {
+    fe r, s, ee, sm, w, u1, u2;
+    from_bytes(r, sig);
+    from_bytes(s, sig + 32);
+    if (iszero_vartime(r) || !less_vartime(r, N) || iszero_vartime(s) || !less_vartime(s, N))
+        return false;
+    from_bytes(ee, e);
+    reduce_once(ee, ee, 0, N);
+
+    /* w = 1/s in Montgomery form, so multiplying by it leaves u1 and u2
+       in ordinary form */
+    mont_mul_n(sm, s, rr_n);
+    inv_mod_n(w, sm);
+    mont_mul_n(u1, w, ee);
+    mont_mul_n(u2, w, r);
+
+    jacobian acc;
+    memset(&acc, 0, sizeof(acc));
+
+    int low[257], high[129];
+    if (pre && pre->width) {
+        size_t len = pre->high.empty() ? 257 : 129;
+        fe lo = { u2[0], u2[1], 0, 0 };
+        fe hi = { u2[2], u2[3], 0, 0 };
+        wnaf(low, len, pre->high.empty() ? u2 : lo, pre->width);
+        if (!pre->high.empty())
+            wnaf(high, len, hi, pre->width);
+        for (size_t i = len; i-- > 0; ) {
+            if (!iszero_vartime(acc.Z))
+                point_double(&acc, &acc);
+            add_digit_vartime(&acc, low[i], &pre->low[0]);
+            if (!pre->high.empty())
+                add_digit_vartime(&acc, high[i], &pre->high[0]);
+        }
+    } else {
+        jacobian q;
+        from_bytes(q.X, x);
+        from_bytes(q.Y, y);
+        copy(q.Z, ONE);
+        p256_affine table[8];
+        jacobian scratch[8];
+        odd_multiples(table, scratch, &q, 8);
+        wnaf(low, 257, u2, 5);
+        for (size_t i = 257; i-- > 0; ) {
+            if (!iszero_vartime(acc.Z))
+                point_double(&acc, &acc);
+            add_digit_vartime(&acc, low[i], table);
+        }
+    }
+
+    for (unsigned int i = 0; i < 64; i++) {
+        unsigned int d = nibble(u1, i);
+        if (d)
+            point_add_affine_vartime(&acc, &acc, &comb[i][d-1]);
+    }
+
+    if (iszero_vartime(acc.Z))
+        return false;
+
+    /* x(acc) mod n == r, without an inversion: x = X/Z^2 is r or r + n */
+    fe zz, t;
+    fe_sqr(zz, acc.Z);
+    fe_mul(t, r, zz);
+    if (equal_vartime(t, acc.X))
+        return true;
+    fe rn;
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; i++) {
+        uint128 sum = (uint128)r[i] + N[i] + carry;
+        rn[i] = (uint64_t)sum;
+        carry = (uint64_t)(sum >> 64);
+    }
+    if (carry || !less_vartime(rn, P))
+        return false;
+    fe_mul(t, rn, zz);
+    return equal_vartime(t, acc.X);
+}
+
+#endif /* #ifdef PYCRYPTOPP_HAVE_P256 */
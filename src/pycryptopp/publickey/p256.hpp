@@ -0,0 +1,63 @@
+#ifndef __INCL_P256_HPP
+#define __INCL_P256_HPP
+
+/**
+ * p256.hpp -- ECDSA arithmetic for the curve secp256r1 (P-256), with field
+ * elements in four 64-bit limbs and no heap allocation on the signing path.
+ *
+ * Signing (p256_sign, p256_public_point) runs in time independent of the
+ * secret scalars. Verification is variable-time, since everything it
+ * handles is public.
+ *
+ * All scalars and coordinates cross this interface as 32-byte big-endian
+ * strings, the same encoding Crypto++'s Integer::Encode produces.
+ *
+ * Needs a compiler with a 128-bit integer type; PYCRYPTOPP_HAVE_P256 is
+ * defined when one is available.
+ */
+
+#if defined(__SIZEOF_INT128__)
+#define PYCRYPTOPP_HAVE_P256 1
+#endif
+
+#ifdef PYCRYPTOPP_HAVE_P256
+
+#include <stdint.h>
+#include <vector>
+
+typedef struct {
+    uint64_t x[4], y[4];
+} p256_affine;
+
+/* Multiples of a public point, built by p256_precompute() for a key that
+   will check many signatures. */
+typedef struct {
+    unsigned int width; /* 0 until something has been precomputed */
+    std::vector<p256_affine> low;  /* Q, 3Q, 5Q, ... */
+    std::vector<p256_affine> high; /* the same for 2^128 Q, or empty */
+} p256_precomputed;
+
+/* Builds the table of multiples of the generator. Must be called once
+   before anything else here. */
+extern void p256_init();
+
+/* (x, y) = d*G, for 0 < d < n */
+extern void p256_public_point(unsigned char x[32], unsigned char y[32], const unsigned char d[32]);
+
+/* Writes the signature r||s on the message representative e with private
+   key d and nonce k, where 0 < d, k < n. Returns -1 in the (never expected)
+   case that r or s comes out as zero, in which case the caller must pick
+   another k. */
+extern int p256_sign(unsigned char sig[64], const unsigned char d[32], const unsigned char k[32], const unsigned char e[32]);
+
+/* Builds tables holding at most storage (at least 1) multiples of the
+   public point (x, y). */
+extern void p256_precompute(p256_precomputed *pre, const unsigned char x[32], const unsigned char y[32], unsigned int storage);
+
+/* Checks the signature r||s on the message representative e against the
+   public point (x, y), which must be on the curve. pre may be NULL. */
+extern bool p256_verify(const unsigned char sig[64], const unsigned char e[32], const unsigned char x[32], const unsigned char y[32], const p256_precomputed *pre);
+
+#endif /* #ifdef PYCRYPTOPP_HAVE_P256 */
+
+#endif /* #ifndef __INCL_P256_HPP */
@@ -11,16 +11,31 @@
 typedef int Py_ssize_t;
 #endif
 
+#include <string>
+#include <vector>
+
 #include "rsamodule.hpp"
+#include "../buffers.hpp"
+#include "../gil.hpp"
+#include "../threadrng.hpp"
+#include "../workerpool.hpp"
 
 /* from Crypto++ */
 #ifdef DISABLE_EMBEDDED_CRYPTOPP
+#include <cryptopp/aes.h>
 #include <cryptopp/filters.h>
+#include <cryptopp/modarith.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/nbtheory.h>
 #include <cryptopp/osrng.h>
 #include <cryptopp/pssr.h>
 #include <cryptopp/rsa.h>
 #else
+#include <src-cryptopp/aes.h>
 #include <src-cryptopp/filters.h>
+#include <src-cryptopp/modarith.h>
+#include <src-cryptopp/modes.h>
+#include <src-cryptopp/nbtheory.h>
 #include <src-cryptopp/osrng.h>
 #include <src-cryptopp/pssr.h>
 #include <src-cryptopp/rsa.h>
@@ -34,15 +49,244 @@ To create a new RSA signing key from the operating system's random number genera
 To deserialize an RSA signing key from a string, call create_signing_key_from_string().\n\
 \n\
 To get an RSA verifying key from an RSA signing key, call get_verifying_key() on the signing key.\n\
-To deserialize an RSA verifying key from a string, call create_verifying_key_from_string().";
+To deserialize an RSA verifying key from a string, call create_verifying_key_from_string().\n\
+\n\
+To sign or verify many messages in one call, spread across several threads, use sign_many() or verify_many().";
 
 static PyObject *rsa_error;
 
+/* A blinding pair is squared after each use, and replaced with a freshly
+   drawn one after this many uses, as OpenSSL's BN_BLINDING does. */
+static const unsigned int RSA_BLINDING_USES = 32;
+
+/* Montgomery arithmetic mod n, p and q for one key, plus a blinding pair
+   (r^e, r^-1) mod n; both halves of the pair are kept in n's Montgomery
+   representation, so that multiplying an ordinary residue by one of them
+   gives an ordinary residue. Crypto++'s MontgomeryRepresentation keeps
+   scratch space in the object, so a context serves one thread at a time. */
+struct RSA_PrivateContext {
+    RSA_PrivateContext(const InvertibleRSAFunction& key)
+        : n(key.GetModulus()), p(key.GetPrime1()), q(key.GetPrime2()),
+          p_rr(p.ConvertIn(p.MultiplicativeIdentity())),
+          q_rr(q.ConvertIn(q.MultiplicativeIdentity())),
+          uses(RSA_BLINDING_USES) {}
+
+    MontgomeryRepresentation n, p, q;
+    Integer p_rr, q_rr; /* R^2 mod p and mod q, so that ConvertIn is one multiplication */
+    Integer blind, unblind;
+    unsigned int uses;
+};
+
+/* The RSA private-key operation of InvertibleRSAFunction::CalculateInverse,
+   computing the same result, but without rebuilding the Montgomery
+   representations for n, p and q or computing a new blinding pair, with a
+   modular inversion, on every call. Contexts are kept on a free list; a
+   caller that finds it empty (the first one, or one signing concurrently
+   with another thread) makes a new context. */
+class RSA_CachedInverse : public TrapdoorFunctionInverse
+{
+public:
+    RSA_CachedInverse(const InvertibleRSAFunction& key)
+        : m_key(key), m_lock(PyThread_allocate_lock()) {}
+
+    ~RSA_CachedInverse() {
+        for (size_t i = 0; i < m_free.size(); i++)
+            delete m_free[i];
+        if (m_lock)
+            PyThread_free_lock(m_lock);
+    }
+
+    Integer CalculateInverse(RandomNumberGenerator &rng, const Integer &x) const {
+        m_key.DoQuickSanityCheck();
+        RSA_PrivateContext* c = Acquire();
+        Integer y;
+        try {
+            y = CalculateInverse(*c, rng, x);
+        } catch (...) {
+            delete c;
+            throw;
+        }
+        Release(c);
+        return y;
+    }
+
+private:
+    RSA_CachedInverse(const RSA_CachedInverse&);
+    RSA_CachedInverse& operator=(const RSA_CachedInverse&);
+
+    Integer CalculateInverse(RSA_PrivateContext& c, RandomNumberGenerator &rng, const Integer &x) const {
+        const Integer& n = m_key.GetModulus();
+        const Integer& e = m_key.GetPublicExponent();
+        if (c.uses >= RSA_BLINDING_USES) {
+            ModularArithmetic modn(n);
+            Integer r, rInv;
+            do {	// as in InvertibleRSAFunction::CalculateInverse
+                r.Randomize(rng, Integer::One(), n - Integer::One());
+                rInv = modn.MultiplicativeInverse(r);
+            } while (rInv.IsZero());
+            c.blind = c.n.ConvertIn(modn.Exponentiate(r, e));
+            c.unblind = c.n.ConvertIn(rInv);
+            c.uses = 0;
+        } else {
+            c.blind = c.n.Square(c.blind);
+            c.unblind = c.n.Square(c.unblind);
+        }
+        c.uses++;
+
+        Integer re = c.n.Multiply(x, c.blind);
+        // CRT with p and q swapped, like CalculateInverse's call to ModularRoot
+        Integer yq = c.q.ConvertOut(c.q.Exponentiate(c.q.Multiply(re % m_key.GetPrime2(), c.q_rr), m_key.GetModPrime2PrivateExponent()));
+        Integer yp = c.p.ConvertOut(c.p.Exponentiate(c.p.Multiply(re % m_key.GetPrime1(), c.p_rr), m_key.GetModPrime1PrivateExponent()));
+        Integer y = CRT(yq, m_key.GetPrime2(), yp, m_key.GetPrime1(), m_key.GetMultiplicativeInverseOfPrime2ModPrime1());
+        y = c.n.Multiply(y, c.unblind);
+        if (c.n.ConvertOut(c.n.Exponentiate(c.n.ConvertIn(y), e)) != x)
+            throw Exception(Exception::OTHER_ERROR, "InvertibleRSAFunction: computational error during private key operation");
+        return y;
+    }
+
+    RSA_PrivateContext* Acquire() const {
+        RSA_PrivateContext* c = NULL;
+        if (m_lock) {
+            PyThread_acquire_lock(m_lock, 1);
+            if (!m_free.empty()) {
+                c = m_free.back();
+                m_free.pop_back();
+            }
+            PyThread_release_lock(m_lock);
+        }
+        return c ? c : new RSA_PrivateContext(m_key);
+    }
+
+    void Release(RSA_PrivateContext* c) const {
+        if (!m_lock) {
+            delete c;
+            return;
+        }
+        PyThread_acquire_lock(m_lock, 1);
+        m_free.push_back(c);
+        PyThread_release_lock(m_lock);
+    }
+
+    const InvertibleRSAFunction& m_key;
+    PyThread_type_lock m_lock;
+    mutable std::vector<RSA_PrivateContext*> m_free;
+};
+
+/* RSASS<PSS, SHA256>::Signer, with its private-key operation done by an
+   RSA_CachedInverse. */
+class RSA_CachedSigner : public RSASS<PSS, SHA256>::Signer
+{
+public:
+    RSA_CachedSigner(RandomNumberGenerator& rng, unsigned int sizeinbits)
+        : RSASS<PSS, SHA256>::Signer(rng, sizeinbits), m_inverse(this->GetKey()) {}
+    RSA_CachedSigner(BufferedTransformation& bt)
+        : RSASS<PSS, SHA256>::Signer(bt), m_inverse(this->GetKey()) {}
+    RSA_CachedSigner(const InvertibleRSAFunction& key)
+        : RSASS<PSS, SHA256>::Signer(key), m_inverse(this->GetKey()) {}
+
+protected:
+    const RandomizedTrapdoorFunctionInverse & GetTrapdoorFunctionInterface() const {
+        return m_inverse;
+    }
+
+private:
+    RSA_CachedInverse m_inverse;
+};
+
+/* A batch for sign_many() or verify_many(). Task t of ntasks handles items
+   t, t+ntasks, t+2*ntasks, ... and records any exception in errs[t]. */
+typedef struct {
+    const RSA_CachedSigner* signer;
+    const RSASS<PSS, SHA256>::Verifier* verifier;
+    std::vector<Py_buffer> msgs;
+    std::vector<Py_buffer> sigs;   /* verify_many() only */
+    std::vector<byte*> out;        /* sign_many() only */
+    std::vector<char> verified;    /* verify_many() only; not vector<bool>, which tasks could not write concurrently */
+    size_t ntasks;
+    std::vector<std::string> errs;
+} RSA_BatchJob;
+
+/** This function is only for internal use by rsamodule.cpp. Get a view of
+    obj onto the end of views, clearing *allpinned if the view is not
+    pinned. Returns -1 with an exception set on failure. */
+static int
+RSA_append_view(std::vector<Py_buffer>& views, PyObject* obj, bool* allpinned) {
+    Py_buffer view;
+    bool pinned;
+    if (pycryptopp_get_read_buffer(obj, &view, &pinned, rsa_error))
+        return -1;
+    views.push_back(view);
+    if (!pinned)
+        *allpinned = false;
+    return 0;
+}
+
+/** This function is only for internal use by rsamodule.cpp. */
+static void
+RSA_release_views(std::vector<Py_buffer>& views) {
+    for (size_t i = 0; i < views.size(); i++)
+        PyBuffer_Release(&views[i]);
+    views.clear();
+}
+
+/** This function is only for internal use by rsamodule.cpp. Split count
+    items over at most threads tasks (0 meaning one per processor), and at
+    least one, since pycryptopp_parallel_run() always runs task 0. */
+static size_t
+RSA_batch_tasks(int threads, size_t count) {
+    size_t ntasks = threads > 0 ? static_cast<size_t>(threads) : pycryptopp_cpu_count();
+    if (ntasks > count)
+        ntasks = count;
+    return ntasks ? ntasks : 1;
+}
+
+/** A pycryptopp_task_fn: sign task t's share of the RSA_BatchJob ctx. */
+static void
+RSA_sign_task(void* ctx, size_t t) {
+    RSA_BatchJob* job = reinterpret_cast<RSA_BatchJob*>(ctx);
+    try {
+        RandomNumberGenerator& rng = pycryptopp_thread_rng();
+        for (size_t i = t; i < job->msgs.size(); i += job->ntasks)
+            job->signer->SignMessage(rng, reinterpret_cast<const byte*>(job->msgs[i].buf), job->msgs[i].len, job->out[i]);
+    } catch (std::exception& le) {
+        job->errs[t] = le.what();
+    } catch (...) {
+        job->errs[t] = "unknown exception";
+    }
+}
+
+/** A pycryptopp_task_fn: verify task t's share of the RSA_BatchJob ctx. */
+static void
+RSA_verify_task(void* ctx, size_t t) {
+    RSA_BatchJob* job = reinterpret_cast<RSA_BatchJob*>(ctx);
+    try {
+        for (size_t i = t; i < job->msgs.size(); i += job->ntasks)
+            job->verified[i] = job->verifier->VerifyMessage(
+                reinterpret_cast<const byte*>(job->msgs[i].buf), job->msgs[i].len,
+                reinterpret_cast<const byte*>(job->sigs[i].buf), job->sigs[i].len);
+    } catch (std::exception& le) {
+        job->errs[t] = le.what();
+    } catch (...) {
+        job->errs[t] = "unknown exception";
+    }
+}
+
+/** This function is only for internal use by rsamodule.cpp. The first
+    error recorded by any task of job, or NULL. */
+static const char*
+RSA_batch_error(const RSA_BatchJob& job) {
+    for (size_t t = 0; t < job.errs.size(); t++)
+        if (!job.errs[t].empty())
+            return job.errs[t].c_str();
+    return NULL;
+}
+
 typedef struct {
     PyObject_HEAD
 
     /* internal */
     RSASS<PSS, SHA256>::Verifier *k;
+    PyThread_type_lock lock;
 } VerifyingKey;
 
 PyDoc_STRVAR(VerifyingKey__doc__,
@@ -52,29 +296,41 @@ static void
 VerifyingKey_dealloc(VerifyingKey* self) {
     if (self->k)
         delete self->k;
+    PYCRYPTOPP_FREE_LOCK(self);
     self->ob_type->tp_free((PyObject*)self);
 }
 
 static PyObject *
 VerifyingKey_verify(VerifyingKey *self, PyObject *args, PyObject *kwdict) {
     static const char *kwlist[] = { "msg", "signature", NULL };
-    const char *msg;
-    Py_ssize_t msgsize;
-    const char *signature;
-    Py_ssize_t signaturesize = 0;
-    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "t#t#:verify", const_cast<char**>(kwlist), &msg, &msgsize, &signature, &signaturesize))
+    Py_buffer msg;
+    Py_buffer signature;
+    /* s* rather than t#, so that the buffers stay put while the GIL is
+       released */
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "s*s*:verify", const_cast<char**>(kwlist), &msg, &signature))
         return NULL;
-    assert (msgsize >= 0);
-    assert (signaturesize >= 0);
+    assert (msg.len >= 0);
+    assert (signature.len >= 0);
 
     Py_ssize_t sigsize = self->k->SignatureLength();
-    if (sigsize != signaturesize)
-        return PyErr_Format(rsa_error, "Precondition violation: signatures are required to be of size %zu, but it was %zu", sigsize, signaturesize);
+    if (sigsize != signature.len) {
+        PyErr_Format(rsa_error, "Precondition violation: signatures are required to be of size %zu, but it was %zu", sigsize, signature.len);
+        PyBuffer_Release(&msg);
+        PyBuffer_Release(&signature);
+        return NULL;
+    }
     assert (sigsize >= 0);
 
-    assert (signaturesize == sigsize);
+    bool verified;
+    ENTER_PYCRYPTOPP(self);
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(self->lock != NULL)
+    verified = self->k->VerifyMessage(reinterpret_cast<const byte*>(msg.buf), msg.len, reinterpret_cast<const byte*>(signature.buf), signature.len);
+    PYCRYPTOPP_END_ALLOW_THREADS
+    LEAVE_PYCRYPTOPP(self);
 
-    if (self->k->VerifyMessage(reinterpret_cast<const byte*>(msg), msgsize, reinterpret_cast<const byte*>(signature), signaturesize))
+    PyBuffer_Release(&msg);
+    PyBuffer_Release(&signature);
+    if (verified)
         Py_RETURN_TRUE;
     else
         Py_RETURN_FALSE;
@@ -83,11 +339,92 @@ VerifyingKey_verify(VerifyingKey *self, PyObject *args, PyObject *kwdict) {
 PyDoc_STRVAR(VerifyingKey_verify__doc__,
 "Return whether the signature is a valid signature on the msg.");
 
+static PyObject *
+VerifyingKey_verify_many(VerifyingKey *self, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "items", "threads", NULL };
+    PyObject *itemsobj;
+    int threads = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "O|i:verify_many", const_cast<char**>(kwlist), &itemsobj, &threads))
+        return NULL;
+    if (threads < 0)
+        return PyErr_Format(rsa_error, "Precondition violation: threads is required to be >= 0, but it was %d", threads);
+
+    PyObject *seq = PySequence_Fast(itemsobj, "verify_many() requires a sequence of (msg, signature) pairs");
+    if (!seq)
+        return NULL;
+    const Py_ssize_t count = PySequence_Fast_GET_SIZE(seq);
+    const Py_ssize_t sigsize = self->k->SignatureLength();
+
+    RSA_BatchJob job;
+    job.signer = NULL;
+    job.verifier = self->k;
+    bool pinned = true;
+    bool ok = true;
+    for (Py_ssize_t i = 0; ok && i < count; i++) {
+        PyObject *pair = PySequence_Fast(PySequence_Fast_GET_ITEM(seq, i), "verify_many() requires a sequence of (msg, signature) pairs");
+        if (!pair) {
+            ok = false;
+            break;
+        }
+        if (PySequence_Fast_GET_SIZE(pair) != 2) {
+            PyErr_SetString(PyExc_TypeError, "verify_many() requires a sequence of (msg, signature) pairs");
+            ok = false;
+        } else if (RSA_append_view(job.msgs, PySequence_Fast_GET_ITEM(pair, 0), &pinned)) {
+            ok = false;
+        } else if (RSA_append_view(job.sigs, PySequence_Fast_GET_ITEM(pair, 1), &pinned)) {
+            ok = false;
+        } else if (job.sigs.back().len != sigsize) {
+            PyErr_Format(rsa_error, "Precondition violation: signatures are required to be of size %zu, but the one at index %zd was %zu", sigsize, i, job.sigs.back().len);
+            ok = false;
+        }
+        Py_DECREF(pair);
+    }
+    Py_DECREF(seq);
+
+    PyObject *result = NULL;
+    if (ok) {
+        job.verified.resize(count);
+        job.ntasks = RSA_batch_tasks(threads, count);
+        job.errs.resize(job.ntasks);
+        ENTER_PYCRYPTOPP(self);
+        PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && self->lock != NULL)
+        pycryptopp_parallel_run(RSA_verify_task, &job, job.ntasks);
+        PYCRYPTOPP_END_ALLOW_THREADS
+        LEAVE_PYCRYPTOPP(self);
+
+        const char *err = RSA_batch_error(job);
+        if (err)
+            PyErr_Format(rsa_error, "Verifying failed.  Crypto++ gave this exception: %s", err);
+        else if ((result = PyList_New(count))) {
+            for (Py_ssize_t i = 0; i < count; i++) {
+                PyObject *b = job.verified[i] ? Py_True : Py_False;
+                Py_INCREF(b);
+                PyList_SET_ITEM(result, i, b);
+            }
+        }
+    }
+    RSA_release_views(job.msgs);
+    RSA_release_views(job.sigs);
+    return result;
+}
+
+PyDoc_STRVAR(VerifyingKey_verify_many__doc__,
+"Check every (msg, signature) pair in items, and return a list saying, in\n\
+the same order, whether each signature is a valid signature on its msg.\n\
+The pairs are checked on several threads, with the GIL released.\n\
+\n\
+@param items: a sequence of (msg, signature) pairs of strings (or objects\n\
+    supporting the buffer protocol)\n\
+@param threads: the most threads to use, including the calling thread\n\
+    (default: 0, meaning one per processor)");
+
 static PyObject *
 VerifyingKey_serialize(VerifyingKey *self, PyObject *dummy) {
     std::string outstr;
     StringSink ss(outstr);
+    ENTER_PYCRYPTOPP(self);
     self->k->DEREncode(ss);
+    LEAVE_PYCRYPTOPP(self);
     PyStringObject* result = reinterpret_cast<PyStringObject*>(PyString_FromStringAndSize(outstr.c_str(), outstr.size()));
     if (!result)
         return NULL;
@@ -101,6 +438,7 @@ create_verifying_key_from_string() to instantiate a new copy of this key.");
 
 static PyMethodDef VerifyingKey_methods[] = {
     {"verify", reinterpret_cast<PyCFunction>(VerifyingKey_verify), METH_KEYWORDS, VerifyingKey_verify__doc__},
+    {"verify_many", reinterpret_cast<PyCFunction>(VerifyingKey_verify_many), METH_KEYWORDS, VerifyingKey_verify_many__doc__},
     {"serialize", reinterpret_cast<PyCFunction>(VerifyingKey_serialize), METH_NOARGS, VerifyingKey_serialize__doc__},
     {NULL},
 };
@@ -144,6 +482,12 @@ VerifyingKey_construct() {
     if (!self)
         return NULL;
     self->k = NULL;
+    self->lock = PyThread_allocate_lock();
+    if (!self->lock) {
+        Py_DECREF(self);
+        PyErr_NoMemory();
+        return NULL;
+    }
     return self;
 }
 
@@ -154,13 +498,15 @@ typedef struct {
     PyObject_HEAD
 
     /* internal */
-    RSASS<PSS, SHA256>::Signer *k;
+    RSA_CachedSigner *k;
+    PyThread_type_lock lock;
 } SigningKey;
 
 static void
 SigningKey_dealloc(SigningKey* self) {
     if (self->k)
         delete self->k;
+    PYCRYPTOPP_FREE_LOCK(self);
     self->ob_type->tp_free((PyObject*)self);
 }
 
@@ -168,7 +514,8 @@ static PyObject *
 SigningKey_sign(SigningKey *self, PyObject *msgobj) {
     const char *msg;
     Py_ssize_t msgsize;
-    PyString_AsStringAndSize(msgobj, const_cast<char**>(&msg), reinterpret_cast<Py_ssize_t*>(&msgsize));
+    if (PyString_AsStringAndSize(msgobj, const_cast<char**>(&msg), reinterpret_cast<Py_ssize_t*>(&msgsize)))
+        return NULL;
     assert (msgsize >= 0);
 
     Py_ssize_t sigsize = self->k->SignatureLength();
@@ -177,12 +524,26 @@ SigningKey_sign(SigningKey *self, PyObject *msgobj) {
         return NULL;
     assert (sigsize >= 0);
 
-    AutoSeededRandomPool randpool(false);
-    Py_ssize_t siglengthwritten = self->k->SignMessage(
-        randpool,
-        reinterpret_cast<const byte*>(msg),
-        msgsize,
-        reinterpret_cast<byte*>(PyString_AS_STRING(result)));
+    Py_ssize_t siglengthwritten = 0;
+    std::string err;
+    ENTER_PYCRYPTOPP(self);
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(self->lock != NULL)
+    try {
+        siglengthwritten = self->k->SignMessage(
+            pycryptopp_thread_rng(),
+            reinterpret_cast<const byte*>(msg),
+            msgsize,
+            reinterpret_cast<byte*>(PyString_AS_STRING(result)));
+    } catch (CryptoPP::Exception le) {
+        err = le.what();
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+    LEAVE_PYCRYPTOPP(self);
+
+    if (!err.empty()) {
+        Py_DECREF(result);
+        return PyErr_Format(rsa_error, "Signing failed.  Crypto++ gave this exception: %s", err.c_str());
+    }
     if (siglengthwritten < sigsize)
         fprintf(stderr, "%s: %d: %s: %s", __FILE__, __LINE__, "SigningKey_sign", "INTERNAL ERROR: signature was shorter than expected.");
     else if (siglengthwritten > sigsize) {
@@ -197,13 +558,77 @@ SigningKey_sign(SigningKey *self, PyObject *msgobj) {
 PyDoc_STRVAR(SigningKey_sign__doc__,
 "Return a signature on the argument.");
 
+static PyObject *
+SigningKey_sign_many(SigningKey *self, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = { "msgs", "threads", NULL };
+    PyObject *msgsobj;
+    int threads = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "O|i:sign_many", const_cast<char**>(kwlist), &msgsobj, &threads))
+        return NULL;
+    if (threads < 0)
+        return PyErr_Format(rsa_error, "Precondition violation: threads is required to be >= 0, but it was %d", threads);
+
+    PyObject *seq = PySequence_Fast(msgsobj, "sign_many() requires a sequence of messages");
+    if (!seq)
+        return NULL;
+    const Py_ssize_t count = PySequence_Fast_GET_SIZE(seq);
+    const Py_ssize_t sigsize = self->k->SignatureLength();
+
+    RSA_BatchJob job;
+    job.signer = self->k;
+    job.verifier = NULL;
+    bool pinned = true;
+    PyObject *result = PyList_New(count);
+    for (Py_ssize_t i = 0; result && i < count; i++) {
+        PyObject *sig = NULL;
+        if (RSA_append_view(job.msgs, PySequence_Fast_GET_ITEM(seq, i), &pinned) == 0)
+            sig = PyString_FromStringAndSize(NULL, sigsize);
+        if (!sig) {
+            Py_CLEAR(result);
+            break;
+        }
+        PyList_SET_ITEM(result, i, sig);
+        job.out.push_back(reinterpret_cast<byte*>(PyString_AS_STRING(sig)));
+    }
+    Py_DECREF(seq);
+
+    if (result) {
+        job.ntasks = RSA_batch_tasks(threads, count);
+        job.errs.resize(job.ntasks);
+        ENTER_PYCRYPTOPP(self);
+        PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(pinned && self->lock != NULL)
+        pycryptopp_parallel_run(RSA_sign_task, &job, job.ntasks);
+        PYCRYPTOPP_END_ALLOW_THREADS
+        LEAVE_PYCRYPTOPP(self);
+
+        const char *err = RSA_batch_error(job);
+        if (err) {
+            PyErr_Format(rsa_error, "Signing failed.  Crypto++ gave this exception: %s", err);
+            Py_CLEAR(result);
+        }
+    }
+    RSA_release_views(job.msgs);
+    return result;
+}
+
+PyDoc_STRVAR(SigningKey_sign_many__doc__,
+"Return a list of signatures, one on each of msgs, in the same order. The\n\
+messages are signed on several threads, with the GIL released.\n\
+\n\
+@param msgs: a sequence of strings (or objects supporting the buffer\n\
+    protocol)\n\
+@param threads: the most threads to use, including the calling thread\n\
+    (default: 0, meaning one per processor)");
+
 static PyObject *
 SigningKey_get_verifying_key(SigningKey *self, PyObject *dummy) {
     VerifyingKey *verifier = reinterpret_cast<VerifyingKey*>(VerifyingKey_construct());
     if (!verifier)
         return NULL;
 
-    verifier->k = new RSASS<PSS, SHA256>::Verifier(*(self->k));
+    ENTER_PYCRYPTOPP(self);
+    verifier->k = new RSASS<PSS, SHA256>::Verifier(*static_cast<RSASS<PSS, SHA256>::Signer*>(self->k));
+    LEAVE_PYCRYPTOPP(self);
     if (!verifier->k)
         return PyErr_NoMemory();
     return reinterpret_cast<PyObject*>(verifier);
@@ -216,7 +641,9 @@ static PyObject *
 SigningKey_serialize(SigningKey *self, PyObject *dummy) {
     std::string outstr;
     StringSink ss(outstr);
+    ENTER_PYCRYPTOPP(self);
     self->k->DEREncode(ss);
+    LEAVE_PYCRYPTOPP(self);
     PyStringObject* result = reinterpret_cast<PyStringObject*>(PyString_FromStringAndSize(outstr.c_str(), outstr.size()));
     if (!result)
         return NULL;
@@ -230,6 +657,7 @@ create_signing_key_from_string() to instantiate a new copy of this key.");
 
 static PyMethodDef SigningKey_methods[] = {
     {"sign", reinterpret_cast<PyCFunction>(SigningKey_sign), METH_O, SigningKey_sign__doc__},
+    {"sign_many", reinterpret_cast<PyCFunction>(SigningKey_sign_many), METH_KEYWORDS, SigningKey_sign_many__doc__},
     {"get_verifying_key", reinterpret_cast<PyCFunction>(SigningKey_get_verifying_key), METH_NOARGS, SigningKey_get_verifying_key__doc__},
     {"serialize", reinterpret_cast<PyCFunction>(SigningKey_serialize), METH_NOARGS, SigningKey_serialize__doc__},
     {NULL},
@@ -274,9 +702,135 @@ SigningKey_construct() {
     if (!self)
         return NULL;
     self->k = NULL;
+    self->lock = PyThread_allocate_lock();
+    if (!self->lock) {
+        Py_DECREF(self);
+        PyErr_NoMemory();
+        return NULL;
+    }
     return self;
 }
 
+/* The odd primes below 2^16, for sieving prime candidates. Crypto++'s own
+   sieve stops at 32719; the primes between there and 2^16 cost a division
+   each per search interval, but remove about 6% of the candidates that
+   would otherwise each need a Miller-Rabin test. */
+static std::vector<word16> rsa_sieve_primes;
+
+/** This function is only for internal use by rsamodule.cpp. Does what
+    Crypto++'s FirstPrime(p, last, 0, 1, selector) does for RSA with public
+    exponent e, when p is larger than every sieving prime: set p to the
+    first prime in [p, last] with gcd(e, p-1) = 1 and return true, or return
+    false if there is none. Candidates are tested in the same order and with
+    the same tests, so the answer is the same. */
+static bool
+RSA_first_prime(Integer& p, const Integer& last, const Integer& e) {
+    if (p.IsEven())
+        ++p;
+    if (p > last)
+        return false;
+    const size_t len = ((last - p) >> 1).ConvertToLong() + 1;
+
+    /* sieve[j] is set if p + 2j has a small factor */
+    std::vector<char> sieve(len, 0);
+    for (size_t i = 0; i < rsa_sieve_primes.size(); i++) {
+        const word32 sp = rsa_sieve_primes[i];
+        const word32 r = p % static_cast<word>(sp);
+        for (size_t j = (sp - r) % sp * ((sp + 1) / 2) % sp; j < len; j += sp)
+            sieve[j] = 1;
+    }
+
+    for (size_t j = 0; j < len; j++) {
+        if (sieve[j])
+            continue;
+        Integer c = p + Integer(static_cast<word>(2*j));
+        if (RelativelyPrime(e, c - Integer::One()) && IsStrongProbablePrime(c, 2) && IsPrime(c)) {
+            p = c;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Search intervals for generating a key, each starting at a random point;
+   task j searches interval j. */
+typedef struct {
+    const Integer* e;
+    const Integer* max;
+    std::vector<Integer> starts;
+    std::vector<char> found;
+    bool failed;
+} RSA_PrimeSearchJob;
+
+/** A pycryptopp_task_fn: search interval j of the RSA_PrimeSearchJob ctx,
+    leaving the prime found, if any, in starts[j]. */
+static void
+RSA_prime_search_task(void* ctx, size_t j) {
+    RSA_PrimeSearchJob* job = reinterpret_cast<RSA_PrimeSearchJob*>(ctx);
+    try {
+        Integer& p = job->starts[j];
+        const Integer last = STDMIN(p + Integer(static_cast<long>(PrimeSearchInterval(*job->max))), *job->max);
+        job->found[j] = RSA_first_prime(p, last, *job->e);
+    } catch (...) {
+        job->failed = true;
+    }
+}
+
+/** This function is only for internal use by rsamodule.cpp. Generate
+    into key the RSA key with a sizeinbits-bit modulus and public exponent
+    17 that InvertibleRSAFunction::Initialize(rng, sizeinbits) would make
+    from the same random numbers, searching up to ntasks intervals at once.
+
+    Initialize picks a random point, takes the first suitable prime after
+    it as p, and if there is none tries another point; then does the same
+    for q. Here the random points are drawn from rng in the same order, a
+    round of ntasks at a time, and the intervals after them searched
+    concurrently; p and q are the first two primes found, in the order
+    the points were drawn. So the key is the same, though rng may have been
+    asked for a few more points than were needed. (Initialize also checks,
+    at its sixteenth point, that [min, max] holds a suitable prime at all;
+    that can only fail for moduli far smaller than MIN_KEY_SIZE_BITS.)
+
+    Call without the GIL. Throws CryptoPP::Exception on failure. */
+static void
+RSA_generate_key(InvertibleRSAFunction& key, RandomNumberGenerator& rng, unsigned int sizeinbits, size_t ntasks) {
+    const Integer e(17);
+    Integer min, max;
+    Integer::RandomNumberType type;
+    AlgorithmParameters params = MakeParametersForTwoPrimesOfEqualSize(sizeinbits);
+    params.GetValue("Min", min);
+    params.GetValue("Max", max);
+    params.GetValue("RandomNumberType", type); /* PRIME; read so that params doesn't complain */
+    if (min <= Integer(65536L) || rsa_sieve_primes.empty()) {
+        key.Initialize(rng, sizeinbits, e);
+        return;
+    }
+
+    RSA_PrimeSearchJob job;
+    job.e = &e;
+    job.max = &max;
+    job.starts.resize(ntasks);
+    job.found.resize(ntasks);
+    job.failed = false;
+    std::vector<Integer> primes;
+    while (primes.size() < 2) {
+        for (size_t j = 0; j < ntasks; j++)
+            job.starts[j].Randomize(rng, min, max);
+        pycryptopp_parallel_run(RSA_prime_search_task, &job, ntasks);
+        if (job.failed)
+            throw Exception(Exception::OTHER_ERROR, "RSA key generation: prime search failed");
+        for (size_t j = 0; j < ntasks && primes.size() < 2; j++)
+            if (job.found[j])
+                primes.push_back(job.starts[j]);
+    }
+
+    /* as in InvertibleRSAFunction::GenerateRandom */
+    const Integer& p = primes[0];
+    const Integer& q = primes[1];
+    const Integer d = e.InverseMod(LCM(p-1, q-1));
+    key.Initialize(p * q, e, d, p, q, d % (p-1), d % (q-1), q.InverseMod(p));
+}
+
 // static const int MIN_KEY_SIZE_BITS=3675; /* according to Lenstra 2001 "Unbelievable security: Matching AES security using public key systems", you should use RSA keys of length 3675 bits if you want it to be as hard to factor your RSA key as to brute-force your AES-128 key in the year 2030. */
 static const int MIN_KEY_SIZE_BITS=522; /* minimum that can do PSS-SHA256 -- totally insecure and allowed only for faster unit tests */
 
@@ -294,22 +848,91 @@ rsa_generate(PyObject *dummy, PyObject *args, PyObject *kwdict) {
     if (sizeinbits < MIN_KEY_SIZE_BITS)
         return PyErr_Format(rsa_error, "Precondition violation: size in bits is required to be >= %d, but it was %d", MIN_KEY_SIZE_BITS, sizeinbits);
 
-    AutoSeededRandomPool osrng(false);
     SigningKey *signer = SigningKey_construct();
     if (!signer)
         return NULL;
-    signer->k = new RSASS<PSS, SHA256>::Signer(osrng, sizeinbits);
-    if (!signer->k)
-        return PyErr_NoMemory();
+
+    std::string err;
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(true)
+    try {
+        InvertibleRSAFunction key;
+        RSA_generate_key(key, pycryptopp_thread_rng(), sizeinbits, pycryptopp_cpu_count());
+        signer->k = new RSA_CachedSigner(key);
+    } catch (std::exception& le) {
+        err = le.what();
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+
+    if (!err.empty()) {
+        Py_DECREF(signer);
+        return PyErr_Format(rsa_error, "Key generation failed.  Crypto++ gave this exception: %s", err.c_str());
+    }
     return reinterpret_cast<PyObject*>(signer);
 }
 
 const char*const rsa_generate__doc__ = "Create a signing key using the operating system's random number generator.\n\
+The search for the two primes is spread across several threads, with the\n\
+GIL released.\n\
 \n\
 @param sizeinbits size of the key in bits\n\
 \n\
 @precondition sizeinbits >= 522";
 
+PyObject *
+rsa__generate_deterministic(PyObject *dummy, PyObject *args, PyObject *kwdict) {
+    static const char *kwlist[] = {
+        "sizeinbits",
+        "seed",
+        "threads",
+        "generic",
+        NULL
+    };
+    int sizeinbits;
+    const char *seed;
+    Py_ssize_t seedsize;
+    int threads = 1;
+    int generic = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwdict, "it#|ii:_generate_deterministic", const_cast<char**>(kwlist), &sizeinbits, &seed, &seedsize, &threads, &generic))
+        return NULL;
+    if (sizeinbits < MIN_KEY_SIZE_BITS)
+        return PyErr_Format(rsa_error, "Precondition violation: size in bits is required to be >= %d, but it was %d", MIN_KEY_SIZE_BITS, sizeinbits);
+    if (seedsize != 32)
+        return PyErr_Format(rsa_error, "Precondition violation: seed is required to be of length 32, but it was %zd", seedsize);
+    if (threads < 1)
+        return PyErr_Format(rsa_error, "Precondition violation: threads is required to be >= 1, but it was %d", threads);
+
+    SigningKey *signer = SigningKey_construct();
+    if (!signer)
+        return NULL;
+
+    std::string err;
+    PYCRYPTOPP_BEGIN_ALLOW_THREADS_IF(true)
+    try {
+        const byte iv[AES::BLOCKSIZE] = { 0 };
+        CTR_Mode<AES>::Encryption rng(reinterpret_cast<const byte*>(seed), seedsize, iv);
+        InvertibleRSAFunction key;
+        if (generic)
+            key.Initialize(rng, sizeinbits);
+        else
+            RSA_generate_key(key, rng, sizeinbits, threads);
+        signer->k = new RSA_CachedSigner(key);
+    } catch (std::exception& le) {
+        err = le.what();
+    }
+    PYCRYPTOPP_END_ALLOW_THREADS
+
+    if (!err.empty()) {
+        Py_DECREF(signer);
+        return PyErr_Format(rsa_error, "Key generation failed.  Crypto++ gave this exception: %s", err.c_str());
+    }
+    return reinterpret_cast<PyObject*>(signer);
+}
+
+const char*const rsa__generate_deterministic__doc__ = "For testing: create a signing key as generate() does, but with random\n\
+numbers from AES-256-CTR keyed with the 32-byte seed, so that the result\n\
+can be compared with Crypto++'s own key generation (if generic is true).";
+
 PyObject *
 rsa_create_verifying_key_from_string(PyObject *dummy, PyObject *args, PyObject *kwdict) {
     static const char *kwlist[] = {
@@ -360,7 +983,7 @@ rsa_create_signing_key_from_string(PyObject *dummy, PyObject *args, PyObject *kw
     StringSource ss(reinterpret_cast<const byte*>(serializedsigningkey), serializedsigningkeysize, true);
 
     try {
-        signer->k = new RSASS<PSS, SHA256>::Signer(ss);
+        signer->k = new RSA_CachedSigner(ss);
     } catch (CryptoPP::BERDecodeErr le) {
         return PyErr_Format(rsa_error, "Serialized signing key was corrupted.  Crypto++ gave this exception: %s", le.what());
     }
@@ -374,6 +997,21 @@ const char*const rsa_create_signing_key_from_string__doc__ = "Create a signing k
 
 void
 init_rsa(PyObject*const module) {
+    if (rsa_sieve_primes.empty()) {
+        std::vector<char> composite(65536, 0);
+        for (word32 i = 3; i < composite.size(); i += 2) {
+            if (composite[i])
+                continue;
+            rsa_sieve_primes.push_back(static_cast<word16>(i));
+            for (word32 j = i*i; j < composite.size(); j += 2*i)
+                composite[j] = 1;
+        }
+    }
+    /* Crypto++ builds its table on first use, which must not happen on two
+       key generation threads at once */
+    unsigned int primeTableSize;
+    GetPrimeTable(primeTableSize);
+
     VerifyingKey_type.tp_new = PyType_GenericNew;
     if (PyType_Ready(&VerifyingKey_type) < 0)
         return;
@@ -10,6 +10,10 @@ extern PyObject *
 rsa_generate(PyObject *dummy, PyObject *args, PyObject *kwdict);
 extern const char*const rsa_generate__doc__;
 
+extern PyObject *
+rsa__generate_deterministic(PyObject *dummy, PyObject *args, PyObject *kwdict);
+extern const char*const rsa__generate_deterministic__doc__;
+
 extern PyObject *
 rsa_create_verifying_key_from_string(PyObject *dummy, PyObject *args, PyObject *kwdict);
 extern const char*const rsa_create_verifying_key_from_string__doc__;
@@ -101,6 +101,181 @@ class AES_from_Niels_Ferguson(unittest.TestCase):
     def test_from_Niels_AES256(self):
         return self._test_from_Niels_AES(32, 'c84b0f3a2c76dd9871900b07f09bdd3e')
 
+class Buffers(unittest.TestCase):
+    def setUp(self):
+        self.key = randstr(16)
+        self.pt = randstr(1000)
+        self.ct = aes.AES(key=self.key).process(self.pt)
+
+    def test_process_buffers(self):
+        import array, mmap
+        m = mmap.mmap(-1, len(self.pt))
+        m[:] = self.pt
+        for buf in [bytearray(self.pt), memoryview(self.pt), buffer(self.pt), array.array('c', self.pt), m]:
+            self.failUnlessEqual(aes.AES(key=self.key).process(buf), self.ct, type(buf))
+
+    def test_process_rejects_unicode(self):
+        self.failUnlessRaises(aes.Error, aes.AES(key=self.key).process, u"\x00"*16)
+        self.failUnlessRaises(aes.Error, aes.AES(key=self.key).process, None)
+
+    def test_process_into(self):
+        dst = bytearray(len(self.pt)+5)
+        cryptor = aes.AES(key=self.key)
+        self.failUnlessEqual(cryptor.process_into(self.pt[:300], dst), 300)
+        self.failUnlessEqual(cryptor.process_into(buffer(self.pt, 300), memoryview(dst)[300:]), 700)
+        self.failUnlessEqual(str(dst), self.ct+"\x00"*5)
+
+    def test_process_into_in_place(self):
+        buf = bytearray(self.pt)
+        aes.AES(key=self.key).process_into(buf, buf)
+        self.failUnlessEqual(str(buf), self.ct)
+
+    def test_process_into_preconditions(self):
+        cryptor = aes.AES(key=self.key)
+        self.failUnlessRaises(aes.Error, cryptor.process_into, self.pt, bytearray(len(self.pt)-1))
+        self.failUnlessRaises(aes.Error, cryptor.process_into, self.pt, "x"*len(self.pt))
+        self.failUnlessRaises(aes.Error, cryptor.process_into, u"x", bytearray(16))
+
+class Seek(unittest.TestCase):
+    def setUp(self):
+        self.key = randstr(16)
+        # an IV near the top of the counter space, so seeking has to carry
+        self.iv = "\xff"*15 + "\xf0"
+        self.stream = aes.AES(key=self.key, iv=self.iv).process("\x00"*5000)
+
+    def test_process_at(self):
+        cryptor = aes.AES(key=self.key, iv=self.iv)
+        for i in range(100):
+            start = random.randrange(0, len(self.stream))
+            end = random.randrange(start, len(self.stream)+1)
+            self.failUnlessEqual(cryptor.process_at(start, "\x00"*(end-start)), self.stream[start:end])
+            self.failUnlessEqual(cryptor.tell(), 0)
+        self.failUnlessEqual(cryptor.process_at(17, bytearray(100)), self.stream[17:117])
+        # process_at() leaves the current position alone, even mid-block
+        self.failUnlessEqual(cryptor.process("\x00"*7), self.stream[:7])
+        self.failUnlessEqual(cryptor.process_at(4000, "\x00"*9), self.stream[4000:4009])
+        self.failUnlessEqual(cryptor.process("\x00"*30), self.stream[7:37])
+
+    def test_seek_and_tell(self):
+        cryptor = aes.AES(key=self.key, iv=self.iv)
+        self.failUnlessEqual(cryptor.tell(), 0)
+        cryptor.process("\x00"*21)
+        cryptor.process_into("\x00"*10, bytearray(10))
+        self.failUnlessEqual(cryptor.tell(), 31)
+        for i in range(100):
+            start = random.randrange(0, len(self.stream))
+            end = random.randrange(start, len(self.stream)+1)
+            cryptor.seek(start)
+            self.failUnlessEqual(cryptor.tell(), start)
+            self.failUnlessEqual(cryptor.process("\x00"*(end-start)), self.stream[start:end])
+            self.failUnlessEqual(cryptor.tell(), end)
+
+    def test_large_offsets(self):
+        cryptor = aes.AES(key=self.key)
+        cryptor.seek(2**40+3)
+        self.failUnlessEqual(cryptor.tell(), 2**40+3)
+        ct = cryptor.process("\x00"*100)
+        self.failUnlessEqual(cryptor.process_at(2**40+3, "\x00"*100), ct)
+        cryptor.seek(2**64-1)
+        self.failUnlessEqual(cryptor.tell(), 2**64-1)
+
+    def test_empty_after_unaligned_seek(self):
+        cryptor = aes.AES(key=self.key, iv=self.iv)
+        cryptor.seek(5)
+        self.failUnlessEqual(cryptor.process(""), "")
+        self.failUnlessEqual(cryptor.process_into("", bytearray(3)), 0)
+        self.failUnlessEqual(cryptor.tell(), 5)
+        self.failUnlessEqual(cryptor.process_at(21, ""), "")
+        self.failUnlessEqual(cryptor.process("\x00"*20), self.stream[5:25])
+        self.failUnlessEqual(aes.AES(key=self.key, iv=self.iv).process_at(5, ""), "")
+
+    def test_bad_offsets(self):
+        cryptor = aes.AES(key=self.key)
+        self.failUnlessRaises(aes.Error, cryptor.seek, -1)
+        self.failUnlessRaises(aes.Error, cryptor.seek, -2**70)
+        self.failUnlessRaises(aes.Error, cryptor.seek, 2**64)
+        self.failUnlessRaises(aes.Error, cryptor.process_at, -1, "x")
+        self.failUnlessRaises(TypeError, cryptor.seek, "0")
+        self.failUnlessRaises(TypeError, cryptor.seek, 1.0)
+        self.failUnlessEqual(cryptor.tell(), 0)
+
+class Parallel(unittest.TestCase):
+    def setUp(self):
+        self.key = randstr(32)
+        self.iv = "\xff"*14 + randstr(2)
+        self.pt = randstr(1<<20) + randstr(random.randrange(1000))
+        self.ct = aes.AES(key=self.key, iv=self.iv).process(self.pt)
+
+    def test_matches_serial(self):
+        for threads in [2, 3, 4, 7, 100]:
+            cryptor = aes.AES(key=self.key, iv=self.iv, parallel_threshold=0, threads=threads)
+            # start at an unaligned position so that the slices have to be
+            # aligned to the counter, not to the buffer
+            cut = random.randrange(1, 16)
+            self.failUnlessEqual(cryptor.process(self.pt[:cut]), self.ct[:cut])
+            self.failUnlessEqual(cryptor.process(self.pt[cut:]), self.ct[cut:], threads)
+            self.failUnlessEqual(cryptor.tell(), len(self.pt))
+
+    def test_position_after_parallel_call(self):
+        cryptor = aes.AES(key=self.key, iv=self.iv, parallel_threshold=0, threads=4)
+        n = len(self.pt) - 100
+        self.failUnlessEqual(cryptor.process(self.pt[:n]), self.ct[:n])
+        self.failUnlessEqual(cryptor.process(self.pt[n:n+3]), self.ct[n:n+3])
+        self.failUnlessEqual(cryptor.process(self.pt[n+3:]), self.ct[n+3:])
+
+    def test_process_into_and_process_at(self):
+        cryptor = aes.AES(key=self.key, iv=self.iv, parallel_threshold=300000, threads=4)
+        buf = bytearray(self.pt)
+        self.failUnlessEqual(cryptor.process_into(buf, buf), len(self.pt))
+        self.failUnlessEqual(str(buf), self.ct)
+        self.failUnlessEqual(cryptor.process_at(5, buffer(self.pt, 5)), self.ct[5:])
+        self.failUnlessEqual(cryptor.tell(), len(self.pt))
+
+    def test_threads_share_pool(self):
+        import threading
+        results = []
+        def worker():
+            for i in range(3):
+                cryptor = aes.AES(key=self.key, iv=self.iv, parallel_threshold=0, threads=3)
+                results.append(cryptor.process(self.pt) == self.ct)
+        threads = [ threading.Thread(target=worker) for i in range(4) ]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.failUnlessEqual(results, [True]*12)
+
+    def test_preconditions(self):
+        self.failUnlessRaises(aes.Error, aes.AES, self.key, parallel_threshold=-1)
+        self.failUnlessRaises(aes.Error, aes.AES, self.key, parallel_threshold=0, threads=-1)
+        self.failUnlessRaises(TypeError, aes.AES, self.key, parallel_threshold="big")
+        # one thread, or a threshold above the input size, is just serial mode
+        self.failUnlessEqual(aes.AES(self.key, self.iv, 0, 1).process(self.pt), self.ct)
+        self.failUnlessEqual(aes.AES(self.key, self.iv, 2**30, 4).process(self.pt), self.ct)
+        self.failUnlessEqual(aes.AES(self.key, self.iv, None, 4).process(self.pt), self.ct)
+
+class Threads(unittest.TestCase):
+    def test_threads_share_object(self):
+        # Each process() call consumes the next len(chunk) bytes of keystream
+        # as a unit, so whatever order the threads run in, the outputs are
+        # exactly the chunks of the serial keystream.
+        import threading
+        key = randstr(16)
+        chunk = "\x00"*8192
+        results = []
+        cryptor = aes.AES(key=key)
+        def worker():
+            for i in range(10):
+                results.append(cryptor.process(chunk))
+        threads = [ threading.Thread(target=worker) for i in range(4) ]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        stream = aes.AES(key=key).process(chunk*40)
+        expected = [ stream[i:i+len(chunk)] for i in range(0, len(stream), len(chunk)) ]
+        self.failUnlessEqual(sorted(results), sorted(expected))
+
 class PartialIV(unittest.TestCase):
     def test_partial(self):
         k = "k"*16
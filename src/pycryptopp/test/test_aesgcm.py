@@ -0,0 +1,253 @@
+import random
+
+import unittest
+
+from binascii import a2b_hex
+
+from pycryptopp.cipher import aesgcm
+
+def randstr(n):
+    return ''.join(map(chr, map(random.randrange, [0]*n, [256]*n)))
+
+# (key, nonce, aad, plaintext, ciphertext, tag), from test cases 1-6, 13 and
+# 14 of "The Galois/Counter Mode of Operation (GCM)" by McGrew and Viega.
+H = "feffe9928665731c6d6a8f9467308308"
+P = "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39"
+A = "feedfacedeadbeeffeedfacedeadbeefabaddad2"
+VECTORS = [
+    ("00"*16, "00"*12, "", "", "", "58e2fccefa7e3061367f1d57a4e7455a"),
+    ("00"*16, "00"*12, "", "00"*16, "0388dace60b6a392f328c2b971b2fe78", "ab6e47d42cec13bdf53a67b21257bddf"),
+    (H, "cafebabefacedbaddecaf888", "", P+"1aafd255",
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+     "4d5c2af327cd64a62cf35abd2ba6fab4"),
+    (H, "cafebabefacedbaddecaf888", A, P,
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+     "5bc94fbc3221a5db94fae95ae7121a47"),
+    (H, "cafebabefacedbad", A, P,
+     "61353b4c2806934a777ff51fa22a4755699b2a714fcdc6f83766e5f97b6c742373806900e49f24b22b097544d4896b424989b5e1ebac0f07c23f4598",
+     "3612d2e79e3b0785561be14aaca2fccb"),
+    (H, "9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b", A, P,
+     "8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca701e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5",
+     "619cc5aefffe0bfa462af43c1699d050"),
+    ("00"*32, "00"*12, "", "", "", "530f8afbc74536b9a963b4f1c4cb738b"),
+    ("00"*32, "00"*12, "", "00"*16, "cea7403d4d606b6e074ec5d3baf39d18", "d0d1c8a799996bf0265b98b5d48ab919"),
+    ]
+
+def split(s):
+    """Cut s into a random number of random-length pieces."""
+    pieces = []
+    while s:
+        n = random.randrange(1, len(s)+1)
+        pieces.append(s[:n])
+        s = s[n:]
+    return pieces
+
+class AESGCMVectors(unittest.TestCase):
+    def _vectors(self):
+        for v in VECTORS:
+            yield tuple(map(a2b_hex, v))
+
+    def test_encrypt(self):
+        for (key, nonce, aad, pt, ct, tag) in self._vectors():
+            self.failUnlessEqual(aesgcm.AESGCM(key).encrypt(nonce, aad, pt), (ct, tag))
+
+    def test_decrypt(self):
+        for (key, nonce, aad, pt, ct, tag) in self._vectors():
+            self.failUnlessEqual(aesgcm.AESGCM(key).decrypt(nonce, aad, ct, tag), pt)
+
+    def test_one_object_many_nonces(self):
+        # the key schedule and tables are reused between messages, and no
+        # state may leak from one message into the next
+        cryptor = aesgcm.AESGCM(a2b_hex(H))
+        for i in range(3):
+            for (key, nonce, aad, pt, ct, tag) in self._vectors():
+                if key == a2b_hex(H):
+                    self.failUnlessEqual(cryptor.encrypt(nonce, aad, pt), (ct, tag))
+                    self.failUnlessEqual(cryptor.decrypt(nonce, aad, ct, tag), pt)
+
+    def test_streaming(self):
+        for (key, nonce, aad, pt, ct, tag) in self._vectors():
+            cryptor = aesgcm.AESGCM(key)
+            for i in range(5):
+                aadpieces = split(aad)
+                e = cryptor.encryptor(nonce, *aadpieces[:1])
+                for piece in aadpieces[1:]:
+                    e.update_aad(piece)
+                self.failUnlessEqual("".join([e.process(piece) for piece in split(pt)]), ct)
+                self.failUnlessEqual(e.finish(), tag)
+
+                d = cryptor.decryptor(nonce)
+                for piece in aadpieces:
+                    d.update_aad(piece)
+                self.failUnlessEqual("".join([d.process(piece) for piece in split(ct)]), pt)
+                self.failUnlessEqual(d.verify(tag), None)
+
+    def test_truncated_tags(self):
+        (key, nonce, aad, pt, ct, tag) = map(a2b_hex, VECTORS[3])
+        cryptor = aesgcm.AESGCM(key, tagsize=12)
+        self.failUnlessEqual(cryptor.encrypt(nonce, aad, pt), (ct, tag[:12]))
+        self.failUnlessEqual(cryptor.decrypt(nonce, aad, ct, tag[:12]), pt)
+        self.failUnlessRaises(aesgcm.Error, cryptor.decrypt, nonce, aad, ct, tag)
+        e = cryptor.encryptor(nonce, aad)
+        e.process(pt)
+        self.failUnlessEqual(e.finish(), tag[:12])
+
+class AESGCMImplementations(unittest.TestCase):
+    def test_all_agree(self):
+        from pycryptopp import _pycryptopp
+        modes = [None, "2k", "64k"]
+        if _pycryptopp.cpu_features()["clmul"]:
+            modes.append("clmul")
+        else:
+            self.failUnlessRaises(aesgcm.Error, aesgcm.AESGCM, "k"*16, ghash="clmul")
+        for (key, nonce, aad, pt, ct, tag) in map(lambda v: map(a2b_hex, v), VECTORS):
+            for ghash in modes:
+                cryptor = aesgcm.AESGCM(key, ghash=ghash)
+                # non-12-byte nonces go through GHASH too
+                self.failUnlessEqual(cryptor.encrypt(nonce, aad, pt), (ct, tag), ghash)
+                self.failUnlessEqual(cryptor.decrypt(nonce, aad, ct, tag), pt, ghash)
+                e = cryptor.encryptor(nonce, aad)
+                self.failUnlessEqual("".join([e.process(piece) for piece in split(pt)]), ct, ghash)
+                self.failUnlessEqual(e.finish(), tag)
+
+    def test_ghash_attribute(self):
+        from pycryptopp import _pycryptopp
+        features = _pycryptopp.cpu_features()
+        default = aesgcm.AESGCM("k"*16).ghash
+        if features["clmul"]:
+            self.failUnlessEqual(default, "clmul")
+            self.failUnlessEqual(aesgcm.AESGCM("k"*16, ghash="clmul").ghash, "clmul")
+        else:
+            self.failUnless(default.startswith("2k"), default)
+        self.failUnless(aesgcm.AESGCM("k"*16, ghash="2k").ghash in ("2k", "2k-sse2", "clmul"))
+        self.failUnless(aesgcm.AESGCM("k"*16, ghash="64k").ghash in ("64k", "64k-sse2", "clmul"))
+        self.failUnlessRaises(aesgcm.Error, aesgcm.AESGCM, "k"*16, ghash="4k")
+        self.failUnlessRaises(AttributeError, setattr, aesgcm.AESGCM("k"*16), "ghash", "2k")
+
+class AESGCMTamper(unittest.TestCase):
+    def setUp(self):
+        self.key = randstr(32)
+        self.nonce = randstr(12)
+        self.aad = randstr(40)
+        self.pt = randstr(1000)
+        self.cryptor = aesgcm.AESGCM(self.key)
+        (self.ct, self.tag) = self.cryptor.encrypt(self.nonce, self.aad, self.pt)
+
+    def flip(self, s):
+        i = random.randrange(len(s))
+        return s[:i] + chr(ord(s[i]) ^ (1 << random.randrange(8))) + s[i+1:]
+
+    def test_tampering_is_detected(self):
+        c = self.cryptor
+        self.failUnlessEqual(c.decrypt(self.nonce, self.aad, self.ct, self.tag), self.pt)
+        for i in range(20):
+            self.failUnlessRaises(aesgcm.Error, c.decrypt, self.flip(self.nonce), self.aad, self.ct, self.tag)
+            self.failUnlessRaises(aesgcm.Error, c.decrypt, self.nonce, self.flip(self.aad), self.ct, self.tag)
+            self.failUnlessRaises(aesgcm.Error, c.decrypt, self.nonce, self.aad, self.flip(self.ct), self.tag)
+            self.failUnlessRaises(aesgcm.Error, c.decrypt, self.nonce, self.aad, self.ct, self.flip(self.tag))
+        self.failUnlessRaises(aesgcm.Error, c.decrypt, self.nonce, "", self.ct, self.tag)
+        self.failUnlessRaises(aesgcm.Error, aesgcm.AESGCM(randstr(32)).decrypt, self.nonce, self.aad, self.ct, self.tag)
+        # and a failed decryption does not disturb the next one
+        self.failUnlessEqual(c.decrypt(self.nonce, self.aad, self.ct, self.tag), self.pt)
+
+    def test_streaming_tampering_is_detected(self):
+        d = self.cryptor.decryptor(self.nonce, self.aad)
+        d.process(self.flip(self.ct))
+        self.failUnlessRaises(aesgcm.Error, d.verify, self.tag)
+
+    def test_legacy_decrypt_and_verify(self):
+        c = aesgcm.AESGCM(self.key, iv=self.nonce)
+        self.failUnlessEqual(c.decrypt_and_verify(self.ct, self.tag, self.aad), self.pt)
+        self.failUnlessRaises(aesgcm.Error, c.decrypt_and_verify, self.flip(self.ct), self.tag, self.aad)
+        (ct, tag) = c.encrypt(self.nonce, "", self.pt)
+        self.failUnlessEqual(c.decrypt_and_verify(ct, tag), self.pt)
+        self.failUnlessRaises(aesgcm.Error, self.cryptor.decrypt_and_verify, ct, tag)
+
+class AESGCMPreconditions(unittest.TestCase):
+    def test_constructor(self):
+        self.failUnlessRaises(TypeError, aesgcm.AESGCM, None)
+        for keysize in [0, 1, 15, 17, 31, 33, 64]:
+            self.failUnlessRaises(aesgcm.Error, aesgcm.AESGCM, "k"*keysize)
+        for keysize in [16, 24, 32]:
+            aesgcm.AESGCM("k"*keysize)
+        for tagsize in [-1, 0, 4, 8, 11, 17]:
+            self.failUnlessRaises(aesgcm.Error, aesgcm.AESGCM, "k"*16, tagsize=tagsize)
+        self.failUnlessRaises(aesgcm.Error, aesgcm.AESGCM, "k"*16, iv="")
+
+    def test_arguments(self):
+        c = aesgcm.AESGCM("k"*16)
+        self.failUnlessRaises(aesgcm.Error, c.encrypt, "", "", "x")
+        self.failUnlessRaises(aesgcm.Error, c.encrypt, "n"*12, u"aad", "x")
+        self.failUnlessRaises(aesgcm.Error, c.decrypt, "n"*12, "", "x", "t"*15)
+        self.failUnlessRaises(aesgcm.Error, c.encryptor, "")
+        (ct, tag) = c.encrypt(bytearray("n"*12), buffer("aad"), memoryview("x"*100))
+        self.failUnlessEqual(c.decrypt("n"*12, bytearray("aad"), bytearray(ct), memoryview(tag)), "x"*100)
+
+    def test_stream_states(self):
+        c = aesgcm.AESGCM("k"*16)
+        e = c.encryptor("n"*12)
+        e.update_aad("a")
+        e.process("x")
+        self.failUnlessRaises(aesgcm.Error, e.update_aad, "a")
+        self.failUnlessRaises(aesgcm.Error, e.verify, "t"*16)
+        e.finish()
+        self.failUnlessRaises(aesgcm.Error, e.finish)
+        self.failUnlessRaises(aesgcm.Error, e.process, "x")
+
+        d = c.decryptor("n"*12, "a")
+        self.failUnlessRaises(aesgcm.Error, d.finish)
+        self.failUnlessRaises(aesgcm.Error, d.verify, "t"*12)
+        self.failUnlessRaises(aesgcm.Error, d.verify, "t"*16)
+        self.failUnlessRaises(aesgcm.Error, d.verify, "t"*16)
+
+        self.failUnlessRaises(TypeError, aesgcm.AESGCMStream)
+
+    def test_stream_empty_pieces(self):
+        # zero-length pieces, including part way into a CTR block
+        c = aesgcm.AESGCM("k"*16)
+        (ct, tag) = c.encrypt("n"*12, "ab", "hello")
+        e = c.encryptor("n"*12)
+        e.update_aad("")
+        e.update_aad("ab")
+        self.failUnlessEqual(e.process(""), "")
+        self.failUnlessEqual(e.process("hel"), ct[:3])
+        self.failUnlessEqual(e.process(""), "")
+        self.failUnlessEqual(e.process_into("", bytearray(2)), 0)
+        self.failUnlessEqual(e.process("lo"), ct[3:])
+        self.failUnlessEqual(e.finish(), tag)
+
+    def test_stream_process_into(self):
+        c = aesgcm.AESGCM("k"*16)
+        pt = randstr(5000)
+        (ct, tag) = c.encrypt("n"*12, "", pt)
+        buf = bytearray(pt)
+        e = c.encryptor("n"*12)
+        self.failUnlessEqual(e.process_into(buf, buf), len(pt))
+        self.failUnlessEqual(str(buf), ct)
+        self.failUnlessEqual(e.finish(), tag)
+        d = c.decryptor("n"*12)
+        self.failUnlessRaises(aesgcm.Error, d.process_into, ct, bytearray(10))
+        d.process_into(buf, buf)
+        d.verify(tag)
+        self.failUnlessEqual(str(buf), pt)
+
+class AESGCMThreads(unittest.TestCase):
+    def test_threads_share_object(self):
+        import threading
+        c = aesgcm.AESGCM(randstr(16))
+        msgs = [ (randstr(12), randstr(10), randstr(100000)) for i in range(4) ]
+        expected = [ c.encrypt(*m) for m in msgs ]
+        results = []
+        def worker(i):
+            for j in range(5):
+                results.append(c.encrypt(*msgs[i]) == expected[i])
+                results.append(c.decrypt(msgs[i][0], msgs[i][1], *expected[i]) == msgs[i][2])
+        threads = [ threading.Thread(target=worker, args=(i,)) for i in range(4) ]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.failUnlessEqual(results, [True]*40)
+
+if __name__ == "__main__":
+    unittest.main()
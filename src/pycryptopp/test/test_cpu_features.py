@@ -0,0 +1,41 @@
+import unittest
+
+from pycryptopp import _pycryptopp
+
+class CPUFeatures(unittest.TestCase):
+    def test_report(self):
+        f = _pycryptopp.cpu_features()
+        for flag in ['asm', 'sse2', 'ssse3', 'aesni', 'clmul', 'sha', 'avx2']:
+            self.failUnless(isinstance(f[flag], bool), (flag, f[flag]))
+        self.failUnless(f['aes'] in ('aesni', 'sse2', 'table'), f['aes'])
+        self.failUnless(f['ghash'] in ('clmul', 'sse2', 'table'), f['ghash'])
+        self.failUnless(f['sha256'] in ('shani', 'asm', 'portable'), f['sha256'])
+        self.failUnless(f['integer'] in ('x64', 'sse2', 'portable'), f['integer'])
+        self.failUnless(f['sha256_many'] in ('avx2', 'sse2', 'serial'), f['sha256_many'])
+        self.failUnless(f['xsalsa20'] in ('avx2', 'sse2', 'serial'), f['xsalsa20'])
+        self.failUnless(f['ida_gf2_8'] in ('avx2', 'ssse3', 'scalar'), f['ida_gf2_8'])
+        self.failUnless(f['sha512'] in ('cryptopp', 'supercop'), f['sha512'])
+
+    def test_consistent(self):
+        f = _pycryptopp.cpu_features()
+        if f['aes'] == 'aesni':
+            self.failUnless(f['aesni'])
+        if f['ghash'] == 'clmul':
+            self.failUnless(f['clmul'])
+        if f['sha256'] == 'shani':
+            self.failUnless(f['sha'] and f['ssse3'])
+        if f['sha256'] == 'asm':
+            self.failUnless(f['asm'])
+        if f['aes'] == 'sse2' or f['ghash'] == 'sse2':
+            self.failUnless(f['asm'])
+        if f['sha256_many'] in ('avx2', 'sse2'):
+            self.failUnless(f['sse2'])
+        if f['xsalsa20'] == 'avx2' or f['ida_gf2_8'] == 'avx2':
+            self.failUnless(f['avx2'])
+        if f['ida_gf2_8'] == 'ssse3':
+            self.failUnless(f['ssse3'])
+        if f['avx2']:
+            self.failUnless(f['sse2'])
+
+if __name__ == "__main__":
+    unittest.main()
@@ -28,6 +28,7 @@ random.seed = seed_which_refuses
 from random import randrange
 
 import unittest
+import hashlib
 
 from pycryptopp.publickey import ecdsa
 
@@ -238,6 +239,203 @@ class SignAndVerify(unittest.TestCase):
         badsigner = ecdsa.SigningKey(badseed)
         self._help_test_sign_and_check_bad_keys(badsigner, verifier)
 
+class RandomNumbers(unittest.TestCase):
+    def test_repeated_signatures_differ(self):
+        signer = ecdsa.SigningKey(randstr(SEEDBYTES))
+        v = signer.get_verifying_key()
+        sigs = set()
+        for i in range(16):
+            sig = signer.sign("message")
+            self.failUnless(v.verify("message", sig))
+            sigs.add(sig)
+        self.failUnlessEqual(len(sigs), 16)
+
+    def test_fork(self):
+        # A child process must not draw the same nonces as its parent, even
+        # when the parent's thread already had a generator before the fork.
+        if not hasattr(os, 'fork'):
+            return
+        signer = ecdsa.SigningKey(randstr(SEEDBYTES))
+        signer.sign("warm up")
+        r, w = os.pipe()
+        pid = os.fork()
+        if pid == 0:
+            try:
+                os.close(r)
+                os.write(w, signer.sign("message"))
+            finally:
+                os._exit(0)
+        os.close(w)
+        parentsig = signer.sign("message")
+        childsig = ''
+        while True:
+            data = os.read(r, SIGBYTES)
+            if not data:
+                break
+            childsig += data
+        os.close(r)
+        os.waitpid(pid, 0)
+        self.failUnlessEqual(len(childsig), SIGBYTES)
+        self.failIfEqual(childsig, parentsig)
+        v = signer.get_verifying_key()
+        self.failUnless(v.verify("message", childsig))
+        self.failUnless(v.verify("message", parentsig))
+
+    def test_threads(self):
+        import threading
+        signer = ecdsa.SigningKey(randstr(SEEDBYTES))
+        sigs = []
+        def work():
+            for i in range(8):
+                sigs.append(signer.sign("message"))
+        threads = [threading.Thread(target=work) for i in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        v = signer.get_verifying_key()
+        self.failUnlessEqual(len(sigs), 32)
+        self.failUnlessEqual(len(set(sigs)), 32)
+        for sig in sigs:
+            self.failUnless(v.verify("message", sig))
+
+class BasePrecomputation(unittest.TestCase):
+    def tearDown(self):
+        ecdsa.precompute_base(32)
+
+    def test_bad_storage(self):
+        self.failUnlessRaises(ecdsa.Error, ecdsa.precompute_base, 0)
+        self.failUnlessRaises(ecdsa.Error, ecdsa.precompute_base, 257)
+
+    def test_tables_agree(self):
+        # Keys and signatures don't depend on the size of the table they
+        # were made with.
+        seed = randstr(SEEDBYTES)
+        msg = randstr(100)
+        signers = []
+        for storage in (1, 7, 32, 256):
+            ecdsa.precompute_base(storage)
+            signers.append(ecdsa.SigningKey(seed))
+        serialized = signers[0].get_verifying_key().serialize()
+        for signer in signers:
+            self.failUnlessEqual(signer.get_verifying_key().serialize(), serialized)
+            sig = signer.sign(msg)
+            for storage in (1, 32):
+                ecdsa.precompute_base(storage)
+                self.failUnless(ecdsa.VerifyingKey(serialized).verify(msg, sig))
+            for other in signers:
+                self.failUnless(other.get_verifying_key().verify(msg, sig))
+
+class PublicPrecomputation(unittest.TestCase):
+    def test_precompute(self):
+        signer = ecdsa.SigningKey(randstr(SEEDBYTES))
+        serialized = signer.get_verifying_key().serialize()
+        msg = randstr(100)
+        sig = signer.sign(msg)
+        for storage in (1, 2, 32, 256):
+            v = ecdsa.VerifyingKey(serialized)
+            v.precompute(storage)
+            self.failUnless(v.verify(msg, sig))
+            self.failIf(v.verify(msg + "x", sig))
+            self.failUnlessEqual(v.serialize(), serialized)
+        v = ecdsa.VerifyingKey(serialized)
+        v.precompute()
+        v.precompute(5)
+        self.failUnless(v.verify(msg, sig))
+
+    def test_bad_storage(self):
+        v = ecdsa.SigningKey(randstr(SEEDBYTES)).get_verifying_key()
+        self.failUnlessRaises(ecdsa.Error, v.precompute, 0)
+        self.failUnlessRaises(ecdsa.Error, v.precompute, 257)
+
+    def test_cache(self):
+        signers = [ecdsa.SigningKey(randstr(SEEDBYTES)) for i in range(4)]
+        keys = [s.get_verifying_key().serialize() for s in signers]
+        cache = ecdsa.VerifyingKeyCache(maxsize=3, storage=8)
+        self.failUnlessRaises(ValueError, ecdsa.VerifyingKeyCache, maxsize=0)
+
+        v0 = cache.get(keys[0])
+        self.failUnless(cache.get(keys[0]) is v0)
+        v1 = cache.get(keys[1])
+        v2 = cache.get(keys[2])
+        self.failUnlessEqual(len(cache), 3)
+        cache.get(keys[0])
+        # keys[1] is now the least recently used, so it makes way
+        cache.get(keys[3])
+        self.failUnlessEqual(len(cache), 3)
+        self.failUnless(cache.get(keys[0]) is v0)
+        self.failUnless(cache.get(keys[2]) is v2)
+        self.failIf(cache.get(keys[1]) is v1)
+
+        for signer, key in zip(signers, keys):
+            self.failUnless(cache.get(key).verify("message", signer.sign("message")))
+
+        self.failUnlessRaises(ecdsa.Error, cache.get, "\x02" + "\xff" * 32)
+        cache.clear()
+        self.failUnlessEqual(len(cache), 0)
+
+N256 = 0xffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551
+
+def int_to_str32(i):
+    return ("%064x" % i).decode('hex')
+
+class P256(unittest.TestCase):
+    def test_raw_sign_agrees(self):
+        # the dedicated P-256 code and Crypto++'s generic code must produce
+        # the same bytes for the same nonce
+        nonces = [1, 2, N256 - 1, N256 - 2, 2**128, 2**255]
+        nonces.extend(randrange(1, N256) for i in range(20))
+        for k in nonces:
+            signer = ecdsa.SigningKey(randstr(SEEDBYTES))
+            e = randstr(32)
+            sig = ecdsa._test_raw_sign(signer, int_to_str32(k), e)
+            self.failUnlessEqual(sig, ecdsa._test_raw_sign(signer, int_to_str32(k), e, 1))
+        e = "\xff" * 32
+        self.failUnlessEqual(ecdsa._test_raw_sign(signer, int_to_str32(3), e), ecdsa._test_raw_sign(signer, int_to_str32(3), e, 1))
+
+    def test_raw_sign_preconditions(self):
+        signer = ecdsa.SigningKey(randstr(SEEDBYTES))
+        e = randstr(32)
+        self.failUnlessRaises(ecdsa.Error, ecdsa._test_raw_sign, signer, "\x00" * 32, e)
+        self.failUnlessRaises(ecdsa.Error, ecdsa._test_raw_sign, signer, int_to_str32(N256), e)
+        self.failUnlessRaises(ecdsa.Error, ecdsa._test_raw_sign, signer, "\x01" * 31, e)
+        self.failUnlessRaises(ecdsa.Error, ecdsa._test_raw_sign, signer, "\x01" * 32, e[:-1])
+        self.failUnlessRaises(TypeError, ecdsa._test_raw_sign, signer.get_verifying_key(), int_to_str32(3), e)
+        # a caller-chosen nonce gives the key away, so keys don't offer it
+        self.failIf(hasattr(signer, '_raw_sign'))
+
+    def test_cross_verify(self):
+        # signatures made by either implementation verify under both the
+        # plain and the precomputed verifier
+        for i in range(10):
+            signer = ecdsa.SigningKey(randstr(SEEDBYTES))
+            v1 = ecdsa.VerifyingKey(signer.get_verifying_key().serialize())
+            v2 = ecdsa.VerifyingKey(signer.get_verifying_key().serialize())
+            v2.precompute(randrange(1, 257))
+            msg = randstr(randrange(0, 100))
+            e = hashlib.sha256(msg).digest()
+            k = int_to_str32(randrange(1, N256))
+            for generic in (0, 1):
+                sig = ecdsa._test_raw_sign(signer, k, e, generic)
+                self.failUnless(v1.verify(msg, sig))
+                self.failUnless(v2.verify(msg, sig))
+                self.failIf(v1.verify(msg + "x", sig))
+                self.failIf(v2.verify(msg + "x", sig))
+
+    def test_verify_rejects_out_of_range(self):
+        signer = ecdsa.SigningKey(randstr(SEEDBYTES))
+        msg = randstr(50)
+        sig = signer.sign(msg)
+        v1 = signer.get_verifying_key()
+        v2 = ecdsa.VerifyingKey(v1.serialize())
+        v2.precompute(4)
+        for v in (v1, v2):
+            self.failUnless(v.verify(msg, sig))
+            for bad in ("\x00" * 32 + sig[32:], sig[:32] + "\x00" * 32,
+                        int_to_str32(N256) + sig[32:], sig[:32] + int_to_str32(N256),
+                        "\xff" * 32 + sig[32:], sig[:32] + "\xff" * 32):
+                self.failIf(v.verify(msg, bad))
+
 class Compatibility(unittest.TestCase):
     def test_compatibility(self):
         # Confirm that the KDF used by the SigningKey constructor doesn't
@@ -143,6 +143,160 @@ class Basic(unittest.TestCase):
         self.failIfEqual(sk2, "not a SigningKey")
         self.failIfEqual(vk2, "not a VerifyingKey")
 
+class Prepared(unittest.TestCase):
+    def test_agrees_with_open(self):
+        for i in range(5):
+            vk_s, skvk_s = raw.publickey(chr(i)*32)
+            keys = [raw.VerifyingKey(vk_s), raw.VerifyingKey(vk_s, table=False)]
+            for j in range(10):
+                msg = "message %d" % j
+                sig = raw.sign(msg, skvk_s)[:64]
+                for (s, m) in [(sig, msg), (sig, msg+"!"),
+                               (flip_bit(sig, bit=j%8, in_byte=j), msg),
+                               (flip_bit(sig, bit=j%8, in_byte=32+3*j), msg)]:
+                    try:
+                        raw.open(s+m, vk_s)
+                        good = True
+                    except raw.BadSignatureError:
+                        good = False
+                    for key in keys:
+                        if good:
+                            self.failUnlessEqual(key.verify(s, m), None)
+                        else:
+                            self.failUnlessRaises(raw.BadSignatureError, key.verify, s, m)
+
+    def test_not_a_point(self):
+        # y = 2 gives an x^2 that has no square root
+        vk_s = "\x02" + "\x00"*31
+        sig = "\x00"*64
+        self.failUnlessRaises(raw.BadSignatureError, raw.open, sig+"hi", vk_s)
+        self.failUnlessRaises(raw.BadSignatureError, raw.VerifyingKey(vk_s).verify, sig, "hi")
+        vk = ed25519.VerifyingKey(vk_s)
+        self.failUnlessRaises(ed25519.BadSignatureError, vk.verify, sig, "hi")
+
+    def test_preconditions(self):
+        vk_s, skvk_s = raw.publickey("\x00"*32)
+        self.failUnlessRaises(TypeError, raw.VerifyingKey, vk_s[:31])
+        self.failUnlessRaises(TypeError, raw.VerifyingKey(vk_s).verify, "x"*63, "msg")
+        self.failUnlessRaises(TypeError, raw.VerifyingKey(vk_s).verify, "x"*65, "msg")
+        # open_batch() relies on the decoded key never changing
+        self.failUnlessRaises(TypeError, raw.VerifyingKey(vk_s).__init__, vk_s)
+
+    def test_pickle(self):
+        import pickle
+        sk = ed25519.SigningKey("\x01"*32)
+        vk = ed25519.VerifyingKey(sk.get_verifying_key_bytes())
+        for protocol in range(pickle.HIGHEST_PROTOCOL+1):
+            vk2 = pickle.loads(pickle.dumps(vk, protocol))
+            self.failUnlessEqual(vk2, vk)
+            vk2.verify(sk.sign("hello"), "hello")
+
+class Batch(unittest.TestCase):
+    def setUp(self):
+        self.sks = [ed25519.SigningKey(chr(i)*32) for i in range(3)]
+        self.vks = [ed25519.VerifyingKey(sk.get_verifying_key_bytes())
+                    for sk in self.sks]
+
+    def make(self, n):
+        items = []
+        for i in range(n):
+            msg = "message %d" % i + "x"*(i%7)
+            items.append((self.vks[i%3], self.sks[i%3].sign(msg), msg))
+        return items
+
+    def failUnlessBad(self, items, bad):
+        try:
+            ed25519.verify_batch(items)
+        except ed25519.BadSignatureError, e:
+            self.failUnlessEqual(e.bad, bad)
+        else:
+            self.fail("verify_batch accepted bad signatures %s" % (bad,))
+
+    def test_good(self):
+        self.failUnlessEqual(ed25519.verify_batch([]), None)
+        # one item, a partial chunk, and more than one chunk
+        for n in [1, 2, 5, 64, 150, 600]:
+            items = self.make(n)
+            self.failUnlessEqual(ed25519.verify_batch(items), None)
+            raw_items = [(vk.vk_bytes, sig, msg) for (vk, sig, msg) in items]
+            self.failUnlessEqual(ed25519.verify_batch(raw_items), None)
+
+    def test_open_batch_keys(self):
+        # open_batch() takes decoded keys, key strings, or a mixture, and
+        # groups the signatures by key however they are given
+        items = self.make(30)
+        prepared = [raw.VerifyingKey(vk.vk_bytes) for vk in self.vks]
+        untabled = [raw.VerifyingKey(vk.vk_bytes, table=False) for vk in self.vks]
+        for keys in [prepared, untabled, [vk.vk_bytes for vk in self.vks]]:
+            pairs = [(sig+msg, keys[i%3]) for (i, (vk, sig, msg)) in enumerate(items)]
+            self.failUnlessEqual(raw.open_batch(pairs, "s"*32), [True]*30)
+            pairs[4] = (flip_bit(pairs[4][0], in_byte=70), pairs[4][1])
+            pairs[7] = (pairs[7][0], keys[2])
+            pairs[12] = (pairs[12][0], self.vks[0].vk_bytes)
+            expected = [True]*30
+            expected[4] = expected[7] = False
+            self.failUnlessEqual(raw.open_batch(pairs, "s"*32), expected)
+        # a key that is not a curve point fails only its own signatures
+        not_a_point = "\x02" + "\x00"*31
+        pairs = [(sig+msg, prepared[i%3]) for (i, (vk, sig, msg)) in enumerate(items[:5])]
+        for key in [raw.VerifyingKey(not_a_point), not_a_point]:
+            self.failUnlessEqual(raw.open_batch(pairs + [("\x00"*64, key)], "s"*32), [True]*5 + [False])
+
+    def test_bad(self):
+        items = self.make(150)
+        (vk, sig, msg) = items[3]
+        items[3] = (vk, sig, msg+"!")
+        (vk, sig, msg) = items[70]
+        items[70] = (vk, flip_bit(sig, in_byte=40), msg)
+        (vk, sig, msg) = items[71]
+        items[71] = (self.vks[(72)%3], sig, msg)
+        (vk, sig, msg) = items[149]
+        items[149] = (vk, flip_bit(sig, in_byte=0), msg)
+        self.failUnlessBad(items, [3, 70, 71, 149])
+        self.failUnlessBad(items[3:4], [0])
+
+    def test_agrees_with_verify(self):
+        items = self.make(20)
+        for byte in [0, 5, 31, 32, 50, 63]:
+            mangled = [(vk, flip_bit(sig, bit=byte%8, in_byte=byte), msg)
+                       for (vk, sig, msg) in items]
+            # the top bit of R is the sign of x, and the top bit of S is
+            # reduced away
+            bad = []
+            for (i, (vk, sig, msg)) in enumerate(mangled):
+                try:
+                    vk.verify(sig, msg)
+                except ed25519.BadSignatureError:
+                    bad.append(i)
+            if bad:
+                self.failUnlessBad(mangled, bad)
+            else:
+                self.failUnlessEqual(ed25519.verify_batch(mangled), None)
+
+    def test_noncanonical_R(self):
+        # R = the neutral point (0, 1), whose x = 0 allows a second,
+        # non-canonical encoding with the sign bit set. Make a signature
+        # that holds for R = (0, 1): with S = 0 and A = the neutral point,
+        # S*B - h*A = R for any h.
+        neutral = "\x01" + "\x00"*31
+        msg = "hello"
+        good = neutral + "\x00"*32
+        bad = neutral[:31] + "\x80" + "\x00"*32
+        ed25519.VerifyingKey(neutral).verify(good, msg)
+        self.failUnlessRaises(ed25519.BadSignatureError,
+                              ed25519.VerifyingKey(neutral).verify, bad, msg)
+        items = self.make(4)
+        self.failUnlessEqual(ed25519.verify_batch(items + [(neutral, good, msg)]), None)
+        self.failUnlessBad(items + [(neutral, bad, msg)], [4])
+
+    def test_preconditions(self):
+        self.failUnlessRaises(TypeError, raw.open_batch, [("x"*64, "y"*32)], "short seed")
+        self.failUnlessRaises(TypeError, raw.open_batch, [("x"*63, "y"*32)], "s"*32)
+        self.failUnlessRaises(TypeError, raw.open_batch, [("x"*64, "y"*31)], "s"*32)
+        self.failUnlessRaises(TypeError, raw.open_batch, [["x"*64, "y"*32]], "s"*32)
+        self.failUnlessRaises(TypeError, raw.open_batch, None, "s"*32)
+        self.failUnlessRaises(TypeError, raw.open_batch, [("x"*64, None)], "s"*32)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,226 @@
+import random, struct, threading
+
+import unittest
+
+from pycryptopp import ida
+
+def randstr(n):
+    return ''.join(map(chr, map(random.randrange, [0]*n, [256]*n)))
+
+# GF(2^32) modulo x^32+x^7+x^3+x^2+1, as in Crypto++'s gf2_32.h
+def gf_mul(a, b):
+    r = 0
+    while b:
+        if b & 1:
+            r ^= a
+        b >>= 1
+        a <<= 1
+        if a >> 32:
+            a ^= 0x10000008D
+    return r
+
+def gf_inv(a):
+    r, e = 1, 2**32-2
+    while e:
+        if e & 1:
+            r = gf_mul(r, a)
+        a = gf_mul(a, a)
+        e >>= 1
+    return r
+
+def ref_share(datashares, x):
+    """ Share x, by Lagrange interpolation through data shares 0..k-1. """
+    k = len(datashares)
+    coeffs = []
+    for j in range(k):
+        num, den = 1, 1
+        for m in range(k):
+            if m != j:
+                num = gf_mul(num, x ^ m)
+                den = gf_mul(den, j ^ m)
+        coeffs.append(gf_mul(num, gf_inv(den)))
+    words = len(datashares[0]) // 4
+    columns = [struct.unpack(">%dI" % words, s) for s in datashares]
+    out = []
+    for w in range(words):
+        y = 0
+        for j in range(k):
+            y ^= gf_mul(coeffs[j], columns[j][w])
+        out.append(y)
+    return struct.pack(">%dI" % words, *out)
+
+# GF(2^8) modulo x^8+x^4+x^3+x^2+1
+def gf8_mul(a, b):
+    r = 0
+    while b:
+        if b & 1:
+            r ^= a
+        b >>= 1
+        a <<= 1
+        if a >> 8:
+            a ^= 0x11D
+    return r
+
+def gf8_inv(a):
+    return [x for x in range(1, 256) if gf8_mul(a, x) == 1][0]
+
+def ref_share_gf8(datashares, x):
+    k = len(datashares)
+    coeffs = []
+    for j in range(k):
+        num, den = 1, 1
+        for m in range(k):
+            if m != j:
+                num = gf8_mul(num, x ^ m)
+                den = gf8_mul(den, j ^ m)
+        coeffs.append(gf8_mul(num, gf8_inv(den)))
+    out = []
+    for column in zip(*datashares):
+        y = 0
+        for j in range(k):
+            y ^= gf8_mul(coeffs[j], ord(column[j]))
+        out.append(chr(y))
+    return "".join(out)
+
+def padded(data, k, symbolsize=4):
+    data += "\x01"
+    return data + "\x00"*(-len(data) % (symbolsize*k))
+
+class IDA(unittest.TestCase):
+    def test_roundtrip(self):
+        for (k, n) in [(1, 1), (1, 3), (2, 2), (3, 10), (5, 7), (16, 32), (100, 256)]:
+            for length in (0, 1, 4*k-1, 4*k, 4*k+1, 1000):
+                data = randstr(length)
+                shares = ida.encode(data, k, n)
+                self.failUnlessEqual(len(shares), n)
+                for share in shares:
+                    self.failUnlessEqual(len(share), len(padded(data, k)) // k)
+                for trial in range(3):
+                    nums = random.sample(range(n), k)
+                    self.failUnlessEqual(ida.decode([(i, shares[i]) for i in nums], k), data, (k, n, length, nums))
+                # all check shares, where there are enough of them
+                if n - k >= k:
+                    self.failUnlessEqual(ida.decode(dict((i, shares[i]) for i in range(n-k, n)), k), data)
+
+    def test_data_shares(self):
+        # The first k shares are the padded data dealt out a byte at a time.
+        for k in (1, 2, 3, 7):
+            data = randstr(random.randrange(200))
+            shares = ida.encode(data, k, k+2)
+            p = padded(data, k)
+            for j in range(k):
+                self.failUnlessEqual(shares[j], p[j::k])
+
+    def test_check_shares(self):
+        # The other shares are the values of the polynomials through the data
+        # shares' words, as RawIDA computes them.
+        for (k, n) in [(1, 3), (2, 4), (3, 10), (4, 6)]:
+            data = randstr(random.randrange(100))
+            shares = ida.encode(data, k, n)
+            for x in range(k, n):
+                self.failUnlessEqual(shares[x], ref_share(shares[:k], x), (k, n, x))
+
+    def test_decode_arguments(self):
+        data = randstr(777)
+        shares = ida.encode(data, 3, 6)
+        self.failUnlessEqual(ida.decode({5: shares[5], 0: shares[0], 3: shares[3]}, 3), data)
+        self.failUnlessEqual(ida.decode(list(enumerate(shares)), 3), data)
+        self.failUnlessEqual(ida.decode([(4, bytearray(shares[4])), (1, memoryview(shares[1])), (2, buffer(shares[2]))], k=3), data)
+        self.failUnlessEqual(ida.decode(shares=[[2, shares[2]], [1, shares[1]], [0, shares[0]]], k=3), data)
+        self.failUnlessEqual(ida.encode(bytearray(data), 3, 6), shares)
+
+    def test_large(self):
+        # Big enough that the GIL is released; run two at once.
+        data = randstr(1<<16)*16
+        results = {}
+        def roundtrip(i):
+            shares = ida.encode(data, 3, 10)
+            results[i] = ida.decode(zip(range(7, 10), shares[7:]), 3)
+        threads = [threading.Thread(target=roundtrip, args=(i,)) for i in range(2)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.failUnlessEqual(results, {0: data, 1: data})
+
+    def _gf8_kernels(self):
+        kernels = []
+        for kernel in ('scalar', 'ssse3', 'avx2'):
+            try:
+                ida.encode("", 1, 1, field='gf2_8', kernel=kernel)
+            except ida.Error:
+                continue
+            kernels.append(kernel)
+        return kernels
+
+    def test_gf2_8(self):
+        kernels = self._gf8_kernels()
+        self.failUnless('scalar' in kernels, kernels)
+        for (k, n) in [(1, 1), (1, 3), (3, 10), (5, 7), (16, 32), (100, 256)]:
+            # lengths around the 16- and 32-byte blocks and the 4096-byte
+            # stripes, so that every kernel leaves a tail to the next one
+            for length in (0, 1, k, 17*k-1, 32*k+5, 4096*k+49*k+3):
+                data = randstr(length)
+                shares = ida.encode(data, k, n, field='gf2_8', kernel='scalar')
+                for share in shares:
+                    self.failUnlessEqual(len(share), len(padded(data, k, 1)) // k)
+                for kernel in kernels + [None]:
+                    self.failUnlessEqual(ida.encode(data, k, n, field='gf2_8', kernel=kernel), shares, (k, n, length, kernel))
+                    nums = random.sample(range(n), k)
+                    self.failUnlessEqual(ida.decode([(i, shares[i]) for i in nums], k, field='gf2_8', kernel=kernel), data, (k, n, length, kernel, nums))
+                    if n - k >= k:
+                        self.failUnlessEqual(ida.decode(dict((i, shares[i]) for i in range(n-k, n)), k, field='gf2_8', kernel=kernel), data)
+
+    def test_gf2_8_shares(self):
+        for (k, n) in [(1, 3), (2, 4), (3, 10), (4, 6)]:
+            data = randstr(random.randrange(100))
+            shares = ida.encode(data, k, n, field='gf2_8')
+            p = padded(data, k, 1)
+            for j in range(k):
+                self.failUnlessEqual(shares[j], p[j::k])
+            for x in range(k, n):
+                self.failUnlessEqual(shares[x], ref_share_gf8(shares[:k], x), (k, n, x))
+        # not the same as the GF(2^32) shares
+        self.failIfEqual(ida.encode("x"*100, 2, 3, field='gf2_8')[2], ida.encode("x"*100, 2, 3)[2][:50])
+
+    def test_options(self):
+        self.failUnlessRaises(ida.Error, ida.encode, "data", 2, 3, field='gf2_16')
+        self.failUnlessRaises(ida.Error, ida.encode, "data", 2, 3, field='gf2_8', kernel='mmx')
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, "abcd")], 1, field='gf2_64')
+        self.failUnlessRaises(TypeError, ida.encode, "data", 2, 3, field=None)
+        # the GF(2^32) shares have only the one kernel
+        self.failUnlessEqual(ida.encode("data", 2, 3, kernel='scalar'), ida.encode("data", 2, 3))
+        self.failUnlessRaises(ida.Error, ida.encode, "data", 2, 3, kernel='ssse3')
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, "abcd")], 1, kernel='avx2')
+        kernels = self._gf8_kernels()
+        from pycryptopp import _pycryptopp
+        self.failUnlessEqual(kernels[-1], _pycryptopp.cpu_features()['ida_gf2_8'])
+        for kernel in ('ssse3', 'avx2'):
+            if kernel not in kernels:
+                self.failUnlessRaises(ida.Error, ida.encode, "data", 2, 3, field='gf2_8', kernel=kernel)
+
+    def test_preconditions(self):
+        self.failUnlessRaises(ida.Error, ida.encode, "data", 0, 3)
+        self.failUnlessRaises(ida.Error, ida.encode, "data", 4, 3)
+        self.failUnlessRaises(ida.Error, ida.encode, "data", 3, 257)
+        self.failUnlessRaises(ida.Error, ida.encode, u"data", 3, 5)
+        self.failUnlessRaises(TypeError, ida.encode, "data", None, 5)
+
+        shares = ida.encode("some data", 3, 5)
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, shares[0]), (1, shares[1])], 3)
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, shares[0]), (0, shares[0]), (1, shares[1])], 3)
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, shares[0]), (1, shares[1]), (256, shares[2])], 3)
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, shares[0]), (1, shares[1]), (-1, shares[2])], 3)
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, shares[0]), (1, shares[1]), (2, shares[2][:-4])], 3)
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, shares[0][:-1]), (1, shares[1][:-1]), (2, shares[2][:-1])], 3)
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, ""), (1, ""), (2, "")], 3)
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, shares[0]), (1, shares[1]), (2, None)], 3)
+        self.failUnlessRaises(ida.Error, ida.decode, shares, 0)
+        self.failUnlessRaises(TypeError, ida.decode, shares, 3)
+        self.failUnlessRaises(TypeError, ida.decode, 7, 3)
+        # shares that do not decode to anything encode() could have made
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, "\0"*4), (1, "\0"*4), (2, "\0"*4)], 3)
+        self.failUnlessRaises(ida.Error, ida.decode, [(0, "\1" + "\0"*7)], 1)
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,110 @@
+import random, hashlib, hmac, threading
+
+import unittest
+
+from binascii import a2b_hex
+
+from pycryptopp.hash import kdf
+
+def randstr(n):
+    return ''.join(map(chr, map(random.randrange, [0]*n, [256]*n)))
+
+def ref_extract(ikm, salt):
+    return hmac.new(salt, ikm, hashlib.sha256).digest()
+
+def ref_expand(prk, length, info):
+    okm, t, block = "", "", 0
+    while len(okm) < length:
+        block += 1
+        t = hmac.new(prk, t + info + chr(block), hashlib.sha256).digest()
+        okm += t
+    return okm[:length]
+
+class HKDF(unittest.TestCase):
+    def test_rfc5869(self):
+        # test cases 1 and 3 of RFC 5869, appendix A
+        for (ikm, salt, info, length, prk, okm) in [
+            ("0b"*22, "000102030405060708090a0b0c", "f0f1f2f3f4f5f6f7f8f9", 42,
+             "077709362c2e32df0ddc3f0dc47bba6390b6c73bb50f9c3122ec844ad7c2b3e5",
+             "3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf34007208d5b887185865"),
+            ("0b"*22, "", "", 42,
+             "19ef24a32c717b167f33a91d6f648bdf96596776afdb6377ac434c1c293ccb04",
+             "8da4e775a563c18f715f802a063c5a31b8a11f5c5ee1879ec3454e5f3c738d2d9d201395faa4b61a96c8"),
+            ]:
+            ikm, salt, info, prk, okm = map(a2b_hex, (ikm, salt, info, prk, okm))
+            self.failUnlessEqual(kdf.hkdf_extract(ikm, salt), prk)
+            self.failUnlessEqual(kdf.hkdf_expand(prk, length, info), okm)
+            self.failUnlessEqual(kdf.hkdf(ikm, length, salt=salt, info=info), okm)
+            self.failUnlessEqual(kdf.hkdf_expand_many(prk, [info], length), [okm])
+
+    def test_against_hmac(self):
+        for length in (0, 1, 31, 32, 33, 100, 8160):
+            ikm, salt, info = randstr(random.randrange(1, 100)), randstr(random.randrange(100)), randstr(random.randrange(100))
+            prk = ref_extract(ikm, salt)
+            okm = ref_expand(prk, length, info)
+            self.failUnlessEqual(kdf.hkdf(ikm, length, salt, info), okm)
+            self.failUnlessEqual(kdf.hkdf_expand(prk, length, info), okm)
+        self.failUnlessEqual(kdf.hkdf_extract("ikm"), ref_extract("ikm", ""))
+
+    def test_expand_many(self):
+        prk = kdf.hkdf_extract(randstr(32), "salt")
+        infos = ["file %d" % i for i in range(100)] + ["", bytearray("share 7"), buffer("lease")]
+        for length in (0, 16, 32, 100):
+            keys = kdf.hkdf_expand_many(prk, infos, length)
+            self.failUnlessEqual(keys, [ref_expand(prk, length, str(info)) for info in infos])
+        self.failUnlessEqual(kdf.hkdf_expand_many(prk, [], 32), [])
+        self.failUnlessEqual(kdf.hkdf_expand_many(prk, iter(["a", "b"]), 32), [kdf.hkdf_expand(prk, 32, "a"), kdf.hkdf_expand(prk, 32, "b")])
+
+    def test_preconditions(self):
+        prk = "p"*32
+        self.failUnlessRaises(kdf.Error, kdf.hkdf, "", 32)
+        self.failUnlessRaises(kdf.Error, kdf.hkdf, "ikm", 8161)
+        self.failUnlessRaises(kdf.Error, kdf.hkdf, "ikm", -1)
+        self.failUnlessRaises(kdf.Error, kdf.hkdf_expand, prk[:-1], 32)
+        self.failUnlessRaises(kdf.Error, kdf.hkdf_expand, prk, 8161)
+        self.failUnlessRaises(kdf.Error, kdf.hkdf_expand_many, prk[:-1], ["a"], 32)
+        self.failUnlessRaises(kdf.Error, kdf.hkdf_expand_many, prk, ["a"], 8161)
+        self.failUnlessRaises(kdf.Error, kdf.hkdf_expand_many, prk, ["a", None], 32)
+        self.failUnlessRaises(TypeError, kdf.hkdf_expand_many, prk, 7, 32)
+
+class PBKDF2(unittest.TestCase):
+    def test_known_answers(self):
+        # PBKDF2-HMAC-SHA256 on the inputs of RFC 6070
+        for (password, salt, iterations, length, dk) in [
+            ("password", "salt", 1, 32, "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b"),
+            ("password", "salt", 2, 32, "ae4d0c95af6b46d32d0adff928f06dd02a303f8ef3c251dfd6e2d85a95474c43"),
+            ("password", "salt", 4096, 32, "c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a"),
+            ]:
+            self.failUnlessEqual(kdf.pbkdf2(password, salt, iterations, length), a2b_hex(dk))
+
+    def test_against_hashlib(self):
+        if not hasattr(hashlib, "pbkdf2_hmac"):
+            return
+        for length in (1, 32, 33, 64, 100):
+            password, salt = randstr(random.randrange(100)), randstr(random.randrange(100))
+            iterations = random.randrange(1, 50)
+            self.failUnlessEqual(kdf.pbkdf2(password, salt, iterations, length), hashlib.pbkdf2_hmac('sha256', password, salt, iterations, length))
+        self.failUnlessEqual(kdf.pbkdf2(buffer("pw"), buffer("salt"), 3), hashlib.pbkdf2_hmac('sha256', "pw", "salt", 3))
+        self.failUnlessEqual(kdf.pbkdf2("pw", "salt", 3, 0), "")
+
+    def test_threads(self):
+        # Several derivations at once, each with the GIL released.
+        results = {}
+        def derive(i):
+            results[i] = kdf.pbkdf2("password %d" % i, "salt", 2000)
+        threads = [threading.Thread(target=derive, args=(i,)) for i in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        for i in range(4):
+            self.failUnlessEqual(results[i], kdf.pbkdf2("password %d" % i, "salt", 2000))
+
+    def test_preconditions(self):
+        self.failUnlessRaises(kdf.Error, kdf.pbkdf2, "pw", "salt", 0)
+        self.failUnlessRaises(kdf.Error, kdf.pbkdf2, "pw", "salt", -1)
+        self.failUnlessRaises(kdf.Error, kdf.pbkdf2, "pw", "salt", 2**32)
+        self.failUnlessRaises(kdf.Error, kdf.pbkdf2, "pw", "salt", 1, -1)
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,103 @@
+import random, hashlib
+
+import unittest
+
+from pycryptopp.hash import merkle
+
+def randstr(n):
+    return ''.join(map(chr, map(random.randrange, [0]*n, [256]*n)))
+
+def ref_leaf(leaf):
+    return hashlib.sha256('\x00' + leaf).digest()
+
+def ref_pair(left, right):
+    return hashlib.sha256('\x01' + left + right).digest()
+
+def ref_nodes(data, leafsize):
+    """ The whole tree, in heap order, built the slow and obvious way. """
+    leaves = [data[i:i+leafsize] for i in range(0, len(data), leafsize)] or ['']
+    width = 1
+    while width < len(leaves):
+        width *= 2
+    level = [ref_leaf(l) for l in leaves] + [ref_leaf('')] * (width - len(leaves))
+    levels = [level]
+    while len(level) > 1:
+        level = [ref_pair(level[i], level[i+1]) for i in range(0, len(level), 2)]
+        levels.insert(0, level)
+    return [h for l in levels for h in l]
+
+class Merkle(unittest.TestCase):
+    def test_tree_hash(self):
+        for leafsize in (1, 3, 32, 1000):
+            for length in (0, 1, leafsize-1, leafsize, leafsize+1, 5*leafsize, 8*leafsize, 9*leafsize+2):
+                data = randstr(length)
+                nodes = ref_nodes(data, leafsize)
+                self.failUnlessEqual(merkle.tree_hash(data, leafsize), nodes[0])
+                self.failUnlessEqual(merkle.tree_hash(data, leafsize, nodes=True), (nodes[0], nodes))
+
+    def test_known_answer(self):
+        # tree_hash('', n) is the hash of one empty leaf.
+        self.failUnlessEqual(merkle.tree_hash('', 7).encode('hex'), '6e340b9cffb37a989ca544e6bb780a2c78901d3fb33738768511a30617afa01d')
+        self.failUnlessEqual(merkle.leaf_hash(''), merkle.tree_hash('', 7))
+
+    def test_threads(self):
+        # Large enough that the leaves are split into several slices.
+        data = randstr(1024*1024 + 100)
+        root = ref_nodes(data, 4096)[0]
+        for threads in (0, 1, 2, 3, 16):
+            self.failUnlessEqual(merkle.tree_hash(data, 4096, threads=threads), root)
+            self.failUnlessEqual(merkle.tree_hash(buffer(data), 4096, threads=threads), root)
+
+    def test_append(self):
+        for leafsize in (1, 5, 64):
+            data = randstr(random.randrange(700))
+            t = merkle.MerkleTree(leafsize)
+            i = 0
+            while i < len(data):
+                j = i + random.randrange(3*leafsize)
+                t.append(data[i:j])
+                i = j
+                self.failUnlessEqual(t.root(), merkle.tree_hash(data[:i], leafsize))
+            self.failUnlessEqual(t.nodes(), ref_nodes(data, leafsize))
+            self.failUnlessEqual(t.length(), len(data))
+            self.failUnlessEqual(t.num_leaves(), max(1, (len(data) + leafsize - 1) // leafsize))
+
+    def test_proof(self):
+        for length in (0, 1, 2, 3, 7, 8, 9, 33):
+            data = randstr(length)
+            t = merkle.MerkleTree(1, threads=2)
+            t.append(data)
+            nodes = t.nodes()
+            for leafnum in range(t.num_leaves()):
+                leaf = merkle.leaf_hash(data[leafnum:leafnum+1])
+                proof = t.proof(leafnum)
+                for (num, h) in proof:
+                    self.failUnlessEqual(nodes[num], h)
+                self.failUnless(merkle.check_proof(t.root(), leafnum, leaf, proof))
+                self.failIf(merkle.check_proof(t.root(), leafnum, merkle.leaf_hash('x' + data), proof))
+                if proof:
+                    self.failIf(merkle.check_proof(t.root(), leafnum ^ 1, leaf, proof))
+                    self.failIf(merkle.check_proof(t.root(), leafnum, leaf, proof[:-1]))
+
+    def test_pair_hash(self):
+        a, b = randstr(32), randstr(32)
+        self.failUnlessEqual(merkle.pair_hash(a, b), ref_pair(a, b))
+        self.failUnlessRaises(merkle.Error, merkle.pair_hash, a, b[:-1])
+
+    def test_preconditions(self):
+        self.failUnlessRaises(merkle.Error, merkle.tree_hash, 'abc', 0)
+        self.failUnlessRaises(merkle.Error, merkle.tree_hash, 'abc', 1, threads=-1)
+        self.failUnlessRaises(merkle.Error, merkle.MerkleTree, 0)
+        self.failUnlessRaises(merkle.Error, merkle.MerkleTree, 1, threads=-1)
+        t = merkle.MerkleTree(1)
+        t.append('abc')
+        self.failUnlessRaises(merkle.Error, t.proof, 3)
+        self.failUnlessRaises(merkle.Error, t.proof, -1)
+        self.failUnlessRaises(merkle.Error, merkle.check_proof, t.root()[:-1], 0, merkle.leaf_hash('a'), t.proof(0))
+        self.failUnlessRaises(merkle.Error, merkle.check_proof, t.root(), -1, merkle.leaf_hash('a'), t.proof(0))
+        root = t.root()
+        self.failUnlessRaises(merkle.Error, t.__init__, 2)
+        self.failUnlessEqual(t.root(), root)
+
+if __name__ == "__main__":
+    unittest.main()
@@ -44,6 +44,15 @@ class Signer(unittest.TestCase):
         rsa.generate(sizeinbits=KEYSIZE)
         # Hooray!  It didn't raise an exception!  We win!
 
+    def test_generate_matches_cryptopp(self):
+        # the parallel prime search must find the same key as Crypto++'s
+        # serial one, given the same random numbers
+        for sizeinbits in (KEYSIZE, KEYSIZE+1, 1024):
+            seed = randstr(32)
+            expected = rsa._generate_deterministic(sizeinbits, seed, generic=True).serialize()
+            for threads in (1, 2, 5):
+                self.failUnlessEqual(rsa._generate_deterministic(sizeinbits, seed, threads=threads).serialize(), expected)
+
     def test_sign(self):
         signer = rsa.generate(KEYSIZE)
         result = signer.sign("abc")
@@ -108,6 +117,18 @@ class SignAndVerify(unittest.TestCase):
         verifier = signer.get_verifying_key()
         return self._help_test_sign_and_failcheck_random(signer, verifier)
 
+    def test_sign_past_blinding_refresh(self):
+        # every 32nd signature from a signing context uses a new blinding
+        # pair, and the ones in between a squared one
+        signer = rsa.generate(KEYSIZE)
+        verifier = rsa.create_signing_key_from_string(signer.serialize()).get_verifying_key()
+        for s in (signer, rsa.create_signing_key_from_string(signer.serialize())):
+            msgs = [randstr(random.randrange(0, 100)) for i in range(70)]
+            for msg in msgs:
+                self.failUnless(verifier.verify(msg, s.sign(msg)))
+            for (msg, sig) in zip(msgs, s.sign_many(msgs, threads=4)):
+                self.failUnless(verifier.verify(msg, sig))
+
     def test_serialize_and_deserialize_verifying_key_and_test(self):
         signer = rsa.generate(KEYSIZE)
         verifier = signer.get_verifying_key()
@@ -130,6 +151,48 @@ class SignAndVerify(unittest.TestCase):
         self._help_test_sign_and_failcheck(newsigner, verifier, "a")
         self._help_test_sign_and_failcheck_random(newsigner, verifier)
 
+class Batch(unittest.TestCase):
+    def test_sign_many(self):
+        signer = rsa.generate(KEYSIZE)
+        verifier = signer.get_verifying_key()
+        msgs = [randstr(random.randrange(0, 200)) for i in range(17)]
+        msgs.append(bytearray("a bytearray"))
+        for threads in (0, 1, 3):
+            sigs = signer.sign_many(msgs, threads=threads)
+            self.failUnlessEqual(len(sigs), len(msgs))
+            for (msg, sig) in zip(msgs, sigs):
+                self.failUnlessEqual(len(sig), ((KEYSIZE+7)/8))
+                self.failUnless(verifier.verify(str(msg), sig))
+        self.failUnlessEqual(signer.sign_many([]), [])
+        self.failUnlessEqual(len(signer.sign_many(iter(["a", "b"]))), 2)
+
+    def test_verify_many(self):
+        signer = rsa.generate(KEYSIZE)
+        verifier = signer.get_verifying_key()
+        msgs = [randstr(random.randrange(0, 200)) for i in range(20)]
+        sigs = signer.sign_many(msgs)
+        items = zip(msgs, sigs)
+        bad = set(random.sample(range(len(items)), 7))
+        for i in bad:
+            (msg, sig) = items[i]
+            items[i] = (msg, sig[:-1] + chr(ord(sig[-1])^0x01))
+        expected = [i not in bad for i in range(len(items))]
+        for threads in (0, 1, 4):
+            self.failUnlessEqual(verifier.verify_many(items, threads=threads), expected)
+        self.failUnlessEqual(verifier.verify_many([]), [])
+
+    def test_preconditions(self):
+        signer = rsa.generate(KEYSIZE)
+        verifier = signer.get_verifying_key()
+        sig = signer.sign("a")
+        self.failUnlessRaises(TypeError, signer.sign_many, None)
+        self.failUnlessRaises(rsa.Error, signer.sign_many, ["a", u"b"])
+        self.failUnlessRaises(rsa.Error, signer.sign_many, ["a"], threads=-1)
+        self.failUnlessRaises(TypeError, verifier.verify_many, [("a",)])
+        self.failUnlessRaises(TypeError, verifier.verify_many, [None])
+        self.failUnlessRaises(rsa.Error, verifier.verify_many, [("a", sig), ("a", sig[:-1])])
+        self.failUnlessRaises(rsa.Error, verifier.verify_many, [("a", sig)], threads=-1)
+
 
 if __name__ == "__main__":
     unittest.main()
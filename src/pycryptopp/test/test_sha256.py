@@ -117,6 +117,22 @@ class SHA256(unittest.TestCase):
             hx.update(s[:64])
         self.failUnlessEqual(hx.hexdigest().lower(), '5191c7841dd4e16aa454d40af924585dffc67157ffdbfd0236acddd07901629d')
 
+    def test_threads_share_object(self):
+        # large updates run with the GIL released, but one object is only
+        # ever used by one thread at a time, so no update is lost or torn
+        import threading
+        chunk = "a"*8192
+        h = sha256.SHA256()
+        def worker():
+            for i in range(20):
+                h.update(chunk)
+        threads = [ threading.Thread(target=worker) for i in range(4) ]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.failUnlessEqual(h.digest(), sha256.SHA256(chunk*80).digest())
+
 
 VECTS_RE=re.compile("\nLen = ([0-9]+)\nMsg = ([0-9a-f]+)\nMD = ([0-9a-f]+)")
 
@@ -131,6 +147,53 @@ def split_on_newlines(s):
            res.extend(y.split('\n'))
     return res
 
+class HashMany(unittest.TestCase):
+    KERNELS = ('serial', 'sse2', 'avx2')
+
+    def _check(self, msgs):
+        expected = [sha256.SHA256(m).digest() for m in msgs]
+        self.failUnlessEqual(sha256.hash_many(msgs), expected)
+        ran = 0
+        for kernel in self.KERNELS:
+            try:
+                got = sha256._hash_many_with(msgs, kernel)
+            except sha256.Error:
+                continue
+            self.failUnlessEqual(got, expected, kernel)
+            ran += 1
+        self.failUnless(ran >= 1)
+
+    def test_lengths(self):
+        # Every padding case: the length field fits in the last data block,
+        # or spills into one more.
+        self._check([randstr(n) for n in range(0, 300)])
+
+    def test_mixed(self):
+        # Lanes get refilled at different times, and some messages are long
+        # enough to be hashed on their own.
+        msgs = [randstr(random.randrange(2000)) for i in range(37)]
+        msgs.append(randstr(100000))
+        msgs.insert(5, '')
+        self._check(msgs)
+        self._check(msgs[:3])
+        self._check([])
+
+    def test_buffers(self):
+        msgs = [randstr(n) for n in (1, 64, 65)]
+        self.failUnlessEqual(sha256.hash_many(map(buffer, msgs)), sha256.hash_many(msgs))
+        self.failUnlessEqual(sha256.hash_many(tuple(msgs)), sha256.hash_many(msgs))
+
+    def test_type_check(self):
+        self.failUnlessRaises(TypeError, sha256.hash_many, 3)
+        self.failUnlessRaises(sha256.Error, sha256.hash_many, [None])
+        self.failUnlessRaises(sha256.Error, sha256._hash_many_with, ['a'], 'mmx')
+
+    def test_best_kernel(self):
+        from pycryptopp import _pycryptopp
+        kernel = _pycryptopp.cpu_features()['sha256_many']
+        self.failUnlessEqual(sha256._hash_many_with(['abc'], kernel), sha256.hash_many(['abc']))
+        self.failUnlessEqual(sha256._hash_many_with(['abc'], 'serial'), sha256.hash_many(['abc']))
+
 class SHSVectors(unittest.TestCase):
     """
     All of the SHA-256 test vectors from the NIST SHS, in the files distributed
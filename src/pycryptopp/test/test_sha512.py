@@ -0,0 +1,102 @@
+import hashlib, random, threading
+
+import unittest
+
+from binascii import a2b_hex
+
+from pycryptopp import _pycryptopp
+from pycryptopp.hash import sha512
+
+def randstr(n):
+    return ''.join(map(chr, map(random.randrange, [0]*n, [256]*n)))
+
+KERNELS = ['cryptopp', 'supercop']
+
+# FIPS 180-2 appendix C
+h0 = a2b_hex("cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e")
+h_abc = a2b_hex("ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f")
+h_2blocks = a2b_hex("8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909")
+msg_2blocks = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu"
+
+class SHA512(unittest.TestCase):
+    def test_vectors(self):
+        for kernel in KERNELS + [None]:
+            self.failUnlessEqual(sha512.SHA512(kernel=kernel).digest(), h0)
+            self.failUnlessEqual(sha512.SHA512("abc", kernel=kernel).digest(), h_abc)
+            h = sha512.SHA512(kernel=kernel)
+            h.update(msg_2blocks)
+            self.failUnlessEqual(h.digest(), h_2blocks)
+            self.failUnlessEqual(a2b_hex(h.hexdigest()), h_2blocks)
+
+    def test_chunksizes(self):
+        # every length around the one- and two-block padding boundaries, fed
+        # in pieces that leave the 128-byte buffer partly full
+        for length in range(0, 300) + [1000, 4096, 100000]:
+            msg = randstr(length)
+            expected = hashlib.sha512(msg).digest()
+            for kernel in KERNELS:
+                self.failUnlessEqual(sha512.SHA512(msg, kernel=kernel).digest(), expected, (length, kernel))
+                h = sha512.SHA512(kernel=kernel)
+                i = 0
+                while i < length:
+                    n = random.choice([1, 7, 64, 127, 128, 129, 300])
+                    h.update(msg[i:i+n])
+                    i += n
+                self.failUnlessEqual(h.digest(), expected, (length, kernel))
+
+    def test_kernel(self):
+        for kernel in KERNELS:
+            self.failUnlessEqual(sha512.SHA512(kernel=kernel).kernel, kernel)
+        self.failUnlessEqual(sha512.SHA512().kernel, _pycryptopp.cpu_features()['sha512'])
+        self.failUnlessRaises(sha512.Error, sha512.SHA512, "", kernel='ref10')
+        self.failUnlessRaises(TypeError, sha512.SHA512, "", kernel=5)
+
+    def test_reinit(self):
+        # __init__ again feeds more data in, but can't swap the kernel out
+        # from under the object.
+        for kernel in KERNELS:
+            other = [k for k in KERNELS if k != kernel][0]
+            h = sha512.SHA512("a", kernel=kernel)
+            h.__init__("bc")
+            h.__init__(kernel=kernel)
+            self.failUnlessRaises(sha512.Error, h.__init__, kernel=other)
+            self.failUnlessRaises(sha512.Error, h.__init__, "x", kernel='ref10')
+            self.failUnlessEqual(h.kernel, kernel)
+            self.failUnlessEqual(h.digest(), h_abc)
+
+    def test_hexdigest(self):
+        for kernel in KERNELS:
+            h = sha512.SHA512("abc", kernel=kernel)
+            self.failUnlessEqual(h.hexdigest().lower(), h_abc.encode('hex'))
+            self.failUnlessEqual(h.digest(), h_abc)
+
+    def test_type_checks(self):
+        self.failUnlessRaises(TypeError, sha512.SHA512, None)
+        self.failUnlessRaises(TypeError, sha512.SHA512().update, None)
+
+    def test_digest_then_update_fail(self):
+        for kernel in KERNELS:
+            h = sha512.SHA512(kernel=kernel)
+            d = h.digest()
+            self.failUnlessEqual(h.digest(), d)
+            self.failUnlessRaises(sha512.Error, h.update, "x")
+
+    def test_threads(self):
+        # Big enough that the GIL is released; hash from two threads at once.
+        msg = randstr(1<<16)
+        expected = hashlib.sha512(msg*16).digest()
+        results = {}
+        def run(kernel):
+            h = sha512.SHA512(kernel=kernel)
+            for i in range(16):
+                h.update(msg)
+            results[kernel] = h.digest()
+        threads = [threading.Thread(target=run, args=(kernel,)) for kernel in KERNELS]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.failUnlessEqual(results, dict((kernel, expected) for kernel in KERNELS))
+
+if __name__ == "__main__":
+    unittest.main()
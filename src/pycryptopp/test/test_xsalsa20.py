@@ -96,6 +96,109 @@ class XSalsa20Test(unittest.TestCase):
             else:
                 self.failUnless(xsalsa20.XSalsa20(key, iv))
 
+    def test_buffers(self):
+        import mmap
+        key = "k"*32
+        pt = "".join([chr(i%256) for i in range(1000)])
+        ct = xsalsa20.XSalsa20(key).process(pt)
+        m = mmap.mmap(-1, len(pt))
+        m[:] = pt
+        for buf in [bytearray(pt), memoryview(pt), buffer(pt), m]:
+            self.failUnlessEqual(xsalsa20.XSalsa20(key).process(buf), ct)
+        self.failUnlessRaises(xsalsa20.Error, xsalsa20.XSalsa20(key).process, u"x")
+
+        dst = bytearray(len(pt))
+        cryptor = xsalsa20.XSalsa20(key)
+        self.failUnlessEqual(cryptor.process_into(pt[:333], dst), 333)
+        self.failUnlessEqual(cryptor.process_into(buffer(pt, 333), memoryview(dst)[333:]), 667)
+        self.failUnlessEqual(str(dst), ct)
+
+        buf = bytearray(pt)
+        xsalsa20.XSalsa20(key).process_into(buf, buf)
+        self.failUnlessEqual(str(buf), ct)
+
+        self.failUnlessRaises(xsalsa20.Error, cryptor.process_into, pt, bytearray(10))
+        self.failUnlessRaises(xsalsa20.Error, cryptor.process_into, pt, pt)
+
+    def test_seek(self):
+        key = "k"*32
+        iv = "i"*24
+        stream = xsalsa20.XSalsa20(key, iv).process("\x00"*5000)
+        cryptor = xsalsa20.XSalsa20(key, iv)
+        self.failUnlessEqual(cryptor.process("\x00"*7), stream[:7])
+        self.failUnlessEqual(cryptor.tell(), 7)
+        for (start, end) in [(0, 5000), (1, 2), (63, 65), (64, 128), (1000, 4321), (4999, 5000)]:
+            self.failUnlessEqual(cryptor.process_at(start, "\x00"*(end-start)), stream[start:end])
+            self.failUnlessEqual(cryptor.tell(), 7)
+        self.failUnlessEqual(cryptor.process("\x00"*10), stream[7:17])
+        cryptor.seek(2345)
+        self.failUnlessEqual(cryptor.tell(), 2345)
+        self.failUnlessEqual(cryptor.process(bytearray(100)), stream[2345:2445])
+        self.failUnlessEqual(cryptor.tell(), 2445)
+        cryptor.seek(2**64-1)
+        self.failUnlessEqual(cryptor.tell(), 2**64-1)
+
+        # nothing to process, part way into a block
+        cryptor.seek(5)
+        self.failUnlessEqual(cryptor.process(""), "")
+        self.failUnlessEqual(cryptor.process_at(70, ""), "")
+        self.failUnlessEqual(cryptor.tell(), 5)
+        self.failUnlessEqual(cryptor.process("\x00"*20), stream[5:25])
+
+        self.failUnlessRaises(xsalsa20.Error, cryptor.seek, -1)
+        self.failUnlessRaises(xsalsa20.Error, cryptor.seek, 2**64)
+        self.failUnlessRaises(xsalsa20.Error, cryptor.process_at, -5, "x")
+        self.failUnlessRaises(TypeError, cryptor.seek, None)
+
+    def _available_kernels(self):
+        kernels = []
+        for kernel in ('serial', 'sse2', 'avx2'):
+            try:
+                kernels.append(xsalsa20.XSalsa20("k"*32, kernel=kernel).kernel)
+            except xsalsa20.Error:
+                pass
+        return kernels
+
+    def test_kernels(self):
+        default = xsalsa20.XSalsa20("k"*32)
+        self.failUnless(default.kernel in ('avx2', 'sse2', 'serial'), default.kernel)
+        kernels = self._available_kernels()
+        self.failUnless(default.kernel in kernels, (default.kernel, kernels))
+        self.failUnlessRaises(xsalsa20.Error, xsalsa20.XSalsa20, "k"*32, kernel="mmx")
+
+        key = "".join(map(chr, range(32)))
+        iv = "".join(map(chr, range(100, 124)))
+        pt = "".join(chr(random.randrange(256)) for i in xrange(8*64*3 + 100))
+        ref = xsalsa20.XSalsa20(key, iv, kernel='serial').process(pt)
+        for kernel in kernels:
+            # whole lengths and ragged ones, so that every kernel hands a tail
+            # to the narrower ones
+            for length in (0, 1, 63, 64, 65, 4*64, 4*64+1, 7*64+63, 8*64, 8*64+4*64+3, len(pt)):
+                cryptor = xsalsa20.XSalsa20(key, iv, kernel=kernel)
+                self.failUnlessEqual(cryptor.process(pt[:length]), ref[:length], (kernel, length))
+            # reading and writing at offsets not aligned to anything
+            cryptor = xsalsa20.XSalsa20(key, iv, kernel=kernel)
+            out = bytearray(len(pt) + 3)
+            cryptor.seek(1)
+            cryptor.process_into(buffer(pt, 1), memoryview(out)[3:])
+            self.failUnlessEqual(str(out[3:-1]), ref[1:])
+            # keystream only, in pieces
+            cryptor = xsalsa20.XSalsa20(key, iv, kernel=kernel)
+            stream = "".join(cryptor.process("\x00"*n) for n in (5, 600, 1, 2000))
+            self.failUnlessEqual(stream, xsalsa20.XSalsa20(key, iv, kernel='serial').process("\x00"*2606))
+
+    def test_kernels_counter_carry(self):
+        # The 64-bit block counter is kept in two 32-bit words; cross the carry
+        # from one to the other in the middle of a pass.
+        key, iv = "k"*32, "i"*24
+        start = (2**32 - 5)*64 + 3
+        ref = xsalsa20.XSalsa20(key, iv, kernel='serial').process_at(start, "\x00"*(20*64))
+        for kernel in self._available_kernels():
+            cryptor = xsalsa20.XSalsa20(key, iv, kernel=kernel)
+            self.failUnlessEqual(cryptor.process_at(start, "\x00"*(20*64)), ref, kernel)
+            cryptor.seek(2**64 - 64*8)
+            self.failUnlessEqual(cryptor.process("\x00"*(64*8)), xsalsa20.XSalsa20(key, iv, kernel='serial').process_at(2**64 - 64*8, "\x00"*(64*8)), kernel)
+
     def test_recursive(self):
         # Try to use the same technique as:
         # http://blogs.msdn.com/si_team/archive/2006/05/19/aes-test-vectors.aspx
@@ -0,0 +1,99 @@
+/**
+ * threadrng.cpp -- a RandomPool per thread, reseeded from the operating
+ * system's RNG by byte count, by age, and after fork()
+ */
+
+#include <time.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "threadrng.hpp"
+
+/* from Crypto++ */
+#ifdef DISABLE_EMBEDDED_CRYPTOPP
+#include <cryptopp/osrng.h>
+#include <cryptopp/randpool.h>
+#include <cryptopp/trdlocal.h>
+#else
+#include <src-cryptopp/osrng.h>
+#include <src-cryptopp/randpool.h>
+#include <src-cryptopp/trdlocal.h>
+#endif
+
+USING_NAMESPACE(CryptoPP)
+
+static ThreadLocalStorage* thread_rngs = NULL;
+
+/* Bumped in the child by every fork(). A generator seeded in an earlier
+   generation is carrying state that some other process also has. */
+static volatile unsigned long fork_generation = 0;
+
+class ThreadRNG : public RandomNumberGenerator, public NotCopyable
+{
+public:
+    ThreadRNG() {
+        Reseed();
+    }
+
+    bool CanIncorporateEntropy() const {
+        return true;
+    }
+
+    void IncorporateEntropy(const byte *input, size_t length) {
+        m_pool.IncorporateEntropy(input, length);
+    }
+
+    void GenerateIntoBufferedTransformation(BufferedTransformation &target, const std::string &channel, lword length) {
+        const time_t now = time(NULL);
+        if (m_generation != fork_generation
+            || m_count + length > PYCRYPTOPP_RNG_RESEED_BYTES
+            || now < m_seeded || now - m_seeded >= PYCRYPTOPP_RNG_RESEED_SECONDS)
+            Reseed();
+        m_pool.GenerateIntoBufferedTransformation(target, channel, length);
+        m_count += length;
+    }
+
+private:
+    void Reseed() {
+        SecByteBlock seed(32);
+        m_generation = fork_generation;
+        OS_GenerateRandomBlock(false, seed, seed.size());
+        m_pool.IncorporateEntropy(seed, seed.size());
+        m_count = 0;
+        m_seeded = time(NULL);
+    }
+
+    RandomPool m_pool;
+    unsigned long m_generation;
+    lword m_count;
+    time_t m_seeded;
+};
+
+#ifndef _WIN32
+static void
+threadrng_atfork_child() {
+    fork_generation++;
+}
+#endif
+
+void
+init_threadrng() {
+    if (thread_rngs)
+        return;
+    thread_rngs = new ThreadLocalStorage;
+#ifndef _WIN32
+    pthread_atfork(NULL, NULL, threadrng_atfork_child);
+#endif
+}
+
+RandomNumberGenerator&
+pycryptopp_thread_rng() {
+    ThreadRNG* rng = static_cast<ThreadRNG*>(thread_rngs->GetValue());
+    if (!rng) {
+        rng = new ThreadRNG;
+        thread_rngs->SetValue(rng);
+    }
+    return *rng;
+}
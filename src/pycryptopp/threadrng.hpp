@@ -0,0 +1,42 @@
+#ifndef __INCL_THREADRNG_HPP
+#define __INCL_THREADRNG_HPP
+
+/**
+ * A cryptographically secure random number generator for each thread, so
+ * that signing and key generation do not have to open the operating
+ * system's RNG and key a fresh RandomPool every time they are called.
+ *
+ * Each thread gets its own Crypto++ RandomPool the first time it asks for
+ * one, seeded with 32 bytes from the operating system. The pool is
+ * reseeded (the new seed is mixed into the old state) before it hands out
+ * more than PYCRYPTOPP_RNG_RESEED_BYTES bytes, when it was last seeded more
+ * than PYCRYPTOPP_RNG_RESEED_SECONDS seconds ago, and in any process that
+ * has forked since it was last seeded, so that a parent and its children
+ * never produce the same bytes.
+ *
+ * A thread's pool (under 1 KiB) stays allocated until the process exits.
+ */
+
+/* from Crypto++ */
+#ifdef DISABLE_EMBEDDED_CRYPTOPP
+#include <cryptopp/cryptlib.h>
+#else
+#include <src-cryptopp/cryptlib.h>
+#endif
+
+#define PYCRYPTOPP_RNG_RESEED_BYTES (1024*1024)
+#define PYCRYPTOPP_RNG_RESEED_SECONDS 300
+
+/* Call once, with the GIL held, before using pycryptopp_thread_rng(). */
+extern void
+init_threadrng();
+
+/**
+ * The calling thread's generator. It may be used without holding the GIL,
+ * but only by the calling thread: do not hand it to another one. Using it
+ * may throw CryptoPP::OS_RNG_Err if the operating system's RNG fails.
+ */
+extern CryptoPP::RandomNumberGenerator&
+pycryptopp_thread_rng();
+
+#endif /* #ifndef __INCL_THREADRNG_HPP */
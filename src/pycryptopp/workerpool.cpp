@@ -0,0 +1,138 @@
+/**
+ * workerpool.cpp -- a small persistent thread pool built on Python's
+ * portable PyThread primitives
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#if (PY_VERSION_HEX < 0x02050000)
+typedef int Py_ssize_t;
+#endif
+
+#include <pythread.h>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "workerpool.hpp"
+
+/* PyThread has no condition variables, so each worker sleeps on a lock of
+   its own: `go' is held by the dispatcher until there is a task for the
+   worker, and `done' is held by the worker until it has finished the task.
+   (PyThread locks, unlike mutexes, may be released by any thread.) */
+typedef struct {
+    PyThread_type_lock go;
+    PyThread_type_lock done;
+    pycryptopp_task_fn task;
+    void* ctx;
+    size_t i;
+} Worker;
+
+/* pool_lock is held by whichever caller is currently using the workers. */
+static PyThread_type_lock pool_lock = NULL;
+static Worker* workers[PYCRYPTOPP_MAX_WORKERS];
+static size_t nworkers = 0;
+
+static void
+worker_main(void* arg) {
+    Worker* w = reinterpret_cast<Worker*>(arg);
+    for (;;) {
+        PyThread_acquire_lock(w->go, 1);
+        w->task(w->ctx, w->i);
+        PyThread_release_lock(w->done);
+    }
+}
+
+/** Start another worker, returning false if that could not be done. */
+static bool
+add_worker() {
+    Worker* w = new (std::nothrow) Worker;
+    if (!w)
+        return false;
+    w->go = PyThread_allocate_lock();
+    w->done = PyThread_allocate_lock();
+    if (w->go && w->done) {
+        PyThread_acquire_lock(w->go, 1);
+        PyThread_acquire_lock(w->done, 1);
+        if (PyThread_start_new_thread(worker_main, w) != -1) {
+            workers[nworkers++] = w;
+            return true;
+        }
+    }
+    if (w->go)
+        PyThread_free_lock(w->go);
+    if (w->done)
+        PyThread_free_lock(w->done);
+    delete w;
+    return false;
+}
+
+#ifndef _WIN32
+/* Only the forking thread survives into the child, so the child starts over
+   with an empty pool. The old workers' memory is deliberately leaked: their
+   locks may have been held by threads that no longer exist. */
+static void
+workerpool_atfork_child() {
+    pool_lock = PyThread_allocate_lock();
+    nworkers = 0;
+}
+#endif
+
+void
+init_workerpool() {
+    if (pool_lock)
+        return;
+    pool_lock = PyThread_allocate_lock();
+#ifndef _WIN32
+    pthread_atfork(NULL, NULL, workerpool_atfork_child);
+#endif
+}
+
+unsigned int
+pycryptopp_cpu_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? static_cast<unsigned int>(n) : 1;
+#else
+    return 1;
+#endif
+}
+
+void
+pycryptopp_parallel_run(pycryptopp_task_fn task, void* ctx, size_t n) {
+    const bool have_pool = n > 1 && pool_lock && PyThread_acquire_lock(pool_lock, 0);
+    size_t dispatched = 0;
+    if (have_pool) {
+        size_t wanted = n - 1;
+        if (wanted > PYCRYPTOPP_MAX_WORKERS)
+            wanted = PYCRYPTOPP_MAX_WORKERS;
+        while (nworkers < wanted && add_worker())
+            ;
+        dispatched = wanted < nworkers ? wanted : nworkers;
+        for (size_t j = 0; j < dispatched; j++) {
+            workers[j]->task = task;
+            workers[j]->ctx = ctx;
+            workers[j]->i = j + 1;
+            PyThread_release_lock(workers[j]->go);
+        }
+    }
+
+    task(ctx, 0);
+    for (size_t i = dispatched + 1; i < n; i++)
+        task(ctx, i);
+
+    if (have_pool) {
+        for (size_t j = 0; j < dispatched; j++)
+            PyThread_acquire_lock(workers[j]->done, 1);
+        PyThread_release_lock(pool_lock);
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef __INCL_WORKERPOOL_HPP
+#define __INCL_WORKERPOOL_HPP
+
+/**
+ * A process-wide pool of native worker threads, for splitting one large
+ * operation across several cores. The workers never touch Python objects,
+ * so they do not need (and never take) the GIL.
+ *
+ * The pool starts empty and grows on demand up to PYCRYPTOPP_MAX_WORKERS
+ * threads, which then stay around, blocked, until the process exits.
+ */
+
+#include <stddef.h>
+
+#define PYCRYPTOPP_MAX_WORKERS 64
+
+/* One unit of work: a call task(ctx, i). A task must not throw. */
+typedef void (*pycryptopp_task_fn)(void* ctx, size_t i);
+
+/* Call once, with the GIL held, before using the pool. */
+extern void
+init_workerpool();
+
+/* The number of processors online, or 1 if that cannot be determined. */
+extern unsigned int
+pycryptopp_cpu_count();
+
+/**
+ * Call task(ctx, i) for every i in [0, n), and return once all of them have
+ * finished. Tasks 1..n-1 are handed to pool threads and task 0 (plus any
+ * task that no pool thread could be found for) runs on the calling thread,
+ * so every task runs exactly once whatever happens. If the pool is already
+ * busy with another caller's tasks, all of them run on the calling thread.
+ *
+ * Call this without holding the GIL; it may block for as long as the
+ * slowest task takes.
+ */
+extern void
+pycryptopp_parallel_run(pycryptopp_task_fn task, void* ctx, size_t n);
+
+#endif /* #ifndef __INCL_WORKERPOOL_HPP */